@@ -104,6 +104,22 @@ namespace winrt::BasicDisplayConfiguration::implementation
         m_currentConfig = configuration.c_str();
 	}
 
+    // The layout the pattern is rasterized in for a plane texture, or nothing if the pattern can't be written to it
+    static std::optional<Rendering::PlanePixelFormat> PlanePixelFormatFromTextureFormat(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return Rendering::PlanePixelFormat::R8G8B8A8UIntNormalized;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return Rendering::PlanePixelFormat::R16G16B16A16Float;
+        }
+
+        return std::nullopt;
+    }
+
 	void BasePlanePattern::ApplyToOutput(IDisplayOutput displayOutput)
     {
         m_drawOutputEventToken = displayOutput.RenderSetupCallback([this](const auto&, IRenderSetupToolArgs args) {
@@ -121,9 +137,8 @@ namespace winrt::BasicDisplayConfiguration::implementation
 
             auto planeProperties = args.Properties().GetPlaneProperties()[0];
 
-            winrt::com_ptr<IDXGISurface> dxgiSurface;
+            winrt::com_ptr<ID3D11Texture2D> texture;
             {
-                winrt::com_ptr<ID3D11Texture2D> texture;
                 auto planePropertiesInterop = planeProperties.try_as<IDisplayEnginePlanePropertiesInterop>();
 
                 if (!planePropertiesInterop)
@@ -133,73 +148,87 @@ namespace winrt::BasicDisplayConfiguration::implementation
                 }
 
                 winrt::check_hresult(planePropertiesInterop->GetPlaneTexture(texture.put()));
-                dxgiSurface = texture.as<IDXGISurface>();
             }
 
-            winrt::com_ptr<ID2D1Factory> d2dFactory;
-            winrt::check_hresult(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, d2dFactory.put()));
-            winrt::com_ptr<ID2D1RenderTarget> d2dTarget;
-            D2D1_RENDER_TARGET_PROPERTIES d2dRtProperties;
-            d2dRtProperties.pixelFormat.alphaMode = D2D1_ALPHA_MODE_IGNORE;
-            d2dRtProperties.pixelFormat.format = DXGI_FORMAT_UNKNOWN;
-            d2dRtProperties.type = D2D1_RENDER_TARGET_TYPE_DEFAULT;
-            d2dRtProperties.minLevel = D2D1_FEATURE_LEVEL_10;
-            d2dRtProperties.dpiX = 96.f;
-            d2dRtProperties.dpiY = 96.f;
-            d2dRtProperties.usage = D2D1_RENDER_TARGET_USAGE_NONE;
-
-            winrt::check_hresult(d2dFactory->CreateDxgiSurfaceRenderTarget(dxgiSurface.get(), d2dRtProperties, d2dTarget.put()));
-
-            auto& configColor = ConfigurationMap[m_currentConfig];
-            D2D1_COLOR_F checkerColor = D2D1::ColorF(
-                configColor.Red,
-                configColor.Green,
-                configColor.Blue
-            );
-
-            winrt::com_ptr<ID2D1SolidColorBrush> checkerBrush;
-            winrt::check_hresult(d2dTarget->CreateSolidColorBrush(checkerColor, checkerBrush.put()));
-
-			d2dTarget->BeginDraw();
-            d2dTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black, 1.0f));
-
-            bool indent = false;
-            for (float x = 0; x < sourceModeResolution.Width; x += PATTERN_SQUARE_SIZE)
-            {
-                for (float y = indent ? (float)PATTERN_SQUARE_SIZE : 0.f; y < sourceModeResolution.Height; y += 2 * PATTERN_SQUARE_SIZE)
-                {
-                    d2dTarget->FillRectangle(D2D1::RectF(x, y, x + PATTERN_SQUARE_SIZE, y + PATTERN_SQUARE_SIZE), checkerBrush.get());
-                }
+            // The pattern is written straight into a mapped staging texture, which is then copied to the plane in one go
+            D3D11_TEXTURE2D_DESC textureDesc{};
+            texture->GetDesc(&textureDesc);
 
-                indent = !indent;
+            const auto planePixelFormat = PlanePixelFormatFromTextureFormat(textureDesc.Format);
+            if (!planePixelFormat)
+            {
+                Logger().LogError(Name() + L": the plane texture format is not supported by this tool.");
+                throw winrt::hresult_invalid_argument();
             }
 
-            winrt::check_hresult(d2dTarget->EndDraw());
+            winrt::com_ptr<ID3D11Device> d3dDevice;
+            texture->GetDevice(d3dDevice.put());
+            winrt::com_ptr<ID3D11DeviceContext> d3dContext;
+            d3dDevice->GetImmediateContext(d3dContext.put());
+
+            const uint32_t width = (std::min)(static_cast<uint32_t>(sourceModeResolution.Width), textureDesc.Width);
+            const uint32_t height = (std::min)(static_cast<uint32_t>(sourceModeResolution.Height), textureDesc.Height);
+
+            // The staging texture covers the whole plane, so what's outside of the source mode is cleared to black
+            D3D11_TEXTURE2D_DESC stagingDesc = textureDesc;
+            stagingDesc.MipLevels = 1;
+            stagingDesc.ArraySize = 1;
+            stagingDesc.SampleDesc = {1, 0};
+            stagingDesc.Usage = D3D11_USAGE_STAGING;
+            stagingDesc.BindFlags = 0;
+            stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            stagingDesc.MiscFlags = 0;
+
+            winrt::com_ptr<ID3D11Texture2D> stagingTexture;
+            winrt::check_hresult(d3dDevice->CreateTexture2D(&stagingDesc, nullptr, stagingTexture.put()));
+
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            winrt::check_hresult(d3dContext->Map(stagingTexture.get(), 0, D3D11_MAP_WRITE, 0, &mapped));
+            RenderPatternToPlane(
+                static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, width, height, textureDesc.Width, textureDesc.Height, *planePixelFormat);
+            d3dContext->Unmap(stagingTexture.get(), 0);
+
+            d3dContext->CopySubresourceRegion(texture.get(), 0, 0, 0, 0, stagingTexture.get(), 0, nullptr);
         });
 	}
 
-    void BasePlanePattern::RenderPatternToPlane(const CanvasDrawingSession& drawingSession, float width, float height)
+    void BasePlanePattern::RenderPatternToPlane(
+        uint8_t* data, size_t rowPitch, uint32_t width, uint32_t height, uint32_t planeWidth, uint32_t planeHeight, Rendering::PlanePixelFormat format)
     {
-        drawingSession.Clear(Colors::Black());
-
         auto& configColor = ConfigurationMap[m_currentConfig];
-        Color checkerColor;
-        checkerColor.A = 255;
-        checkerColor.R = static_cast<uint8_t>(255 * configColor.Red);
-        checkerColor.G = static_cast<uint8_t>(255 * configColor.Green);
-        checkerColor.B = static_cast<uint8_t>(255 * configColor.Blue);
-        auto checkerColorBrush = winrt::Brushes::CanvasSolidColorBrush::CreateHdr(drawingSession, {configColor.Red, configColor.Green, configColor.Blue, 1.0f});
-
-        bool indent = false;
-        for (float x = 0; x < width; x += PATTERN_SQUARE_SIZE)
-        {
-            for (float y = indent ? PATTERN_SQUARE_SIZE : 0.f; y < height; y += 2 * PATTERN_SQUARE_SIZE)
-            {
-                drawingSession.FillRectangle(x, y, PATTERN_SQUARE_SIZE, PATTERN_SQUARE_SIZE, checkerColorBrush);
-            }
+        const uint32_t squareSize = static_cast<uint32_t>(PATTERN_SQUARE_SIZE);
 
-            indent = !indent;
+        // The pattern covers the top left width x height pixels, the rest of the plane is black
+        const auto render = [&]<typename Pixel>(Pixel checkerPixel, Pixel blackPixel) {
+            Rendering::RasterizeCheckerboard<Pixel>(data, rowPitch, width, height, squareSize, checkerPixel, blackPixel);
+            Rendering::FillPixels<Pixel>(data, rowPitch, width, 0, planeWidth, height, blackPixel);
+            Rendering::FillPixels<Pixel>(data, rowPitch, 0, height, planeWidth, planeHeight, blackPixel);
+        };
+
+        if (format == Rendering::PlanePixelFormat::R16G16B16A16Float)
+        {
+            // Linear planes hold the pattern color as scRGB values
+            render(
+                winrt::MicrosoftDisplayCaptureTools::Libraries::HalfFloat::PackRgba(configColor.Red, configColor.Green, configColor.Blue, 1.0f),
+                winrt::MicrosoftDisplayCaptureTools::Libraries::HalfFloat::PackRgba(0.0f, 0.0f, 0.0f, 1.0f));
+            return;
         }
+
+        // 8 bit planes hold the pattern color as its encoded values
+        const uint32_t checkerPixel = static_cast<uint32_t>(std::lround(255 * configColor.Red)) |
+                                      (static_cast<uint32_t>(std::lround(255 * configColor.Green)) << 8) |
+                                      (static_cast<uint32_t>(std::lround(255 * configColor.Blue)) << 16) | 0xFF000000;
+        const uint32_t blackPixel = 0xFF000000;
+
+        render(checkerPixel, blackPixel);
+    }
+
+    void BasePlanePattern::RenderPatternToPlane(Rendering::PlaneSurface& surface)
+    {
+        RenderPatternToPlane(surface.Row(0), surface.RowPitch(), surface.Width(), surface.Height(), surface.Width(), surface.Height(), surface.Format());
+
+        // Every row of a row of squares is the same, which lets flat predictions be described rather than rendered
+        surface.SetRowBands(Rendering::CheckerboardBandStarts(surface.Height(), static_cast<uint32_t>(PATTERN_SQUARE_SIZE)));
     }
 
     static DirectXPixelFormat PixelFormatFromPlaneInformation(const PredictionRenderer::PlaneInformation& plane)
@@ -210,6 +239,8 @@ namespace winrt::BasicDisplayConfiguration::implementation
             {
             case DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709:
                 return DirectXPixelFormat::R8G8B8A8UIntNormalizedSrgb;
+            case DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709:
+                return DirectXPixelFormat::R16G16B16A16Float;
             }
         }
 
@@ -246,6 +277,23 @@ namespace winrt::BasicDisplayConfiguration::implementation
                             throw winrt::hresult_invalid_argument();
                         }
 
+                        const auto planePixelFormat = pixelFormat == DirectXPixelFormat::R16G16B16A16Float
+                                                          ? Rendering::PlanePixelFormat::R16G16B16A16Float
+                                                          : Rendering::PlanePixelFormat::R8G8B8A8UIntNormalized;
+
+                        if (prediction->RenderOnCpu())
+                        {
+                            auto surface = std::make_shared<Rendering::PlaneSurface>(
+                                planePixelFormat,
+                                static_cast<uint32_t>(frame.SourceModeSize.Width),
+                                static_cast<uint32_t>(frame.SourceModeSize.Height));
+
+                            RenderPatternToPlane(*surface);
+
+                            plane.CpuSurface = std::move(surface);
+                            continue;
+                        }
+
                         auto canvasDevice = prediction->Device();
                         auto patternTarget = CanvasRenderTarget(
                             canvasDevice,
@@ -255,15 +303,15 @@ namespace winrt::BasicDisplayConfiguration::implementation
                             CanvasAlphaMode::Premultiplied);
 
                         {
-                            auto drawingSession = patternTarget.CreateDrawingSession();
+                            // Rasterized on the CPU and uploaded in one go
+                            const auto width = patternTarget.SizeInPixels().Width;
+                            const auto height = patternTarget.SizeInPixels().Height;
+                            const size_t rowPitch = static_cast<size_t>(width) * Rendering::BytesPerPixel(planePixelFormat);
 
-                            RenderPatternToPlane(
-                                drawingSession,
-                                frame.SourceModeSize.Width,
-                                frame.SourceModeSize.Height);
+                            std::vector<uint8_t> patternPixels(rowPitch * height);
+                            RenderPatternToPlane(patternPixels.data(), rowPitch, width, height, width, height, planePixelFormat);
 
-                            drawingSession.Flush();
-                            drawingSession.Close();
+                            patternTarget.SetPixelBytes(patternPixels);
                         }
 
                         // Transfer the rendered plane to the prediction plane surface - which will be composed.
@@ -16,7 +16,9 @@ struct BasePlanePattern : implements<BasePlanePattern, winrt::MicrosoftDisplayCa
     void ApplyToPrediction(winrt::MicrosoftDisplayCaptureTools::ConfigurationTools::IPrediction displayPrediction);
 
 private:
-    void RenderPatternToPlane(const winrt::Microsoft::Graphics::Canvas::CanvasDrawingSession& drawingSession, float width, float height);
+    void RenderPatternToPlane(uint8_t* data, size_t rowPitch, uint32_t width, uint32_t height, uint32_t planeWidth, uint32_t planeHeight,
+        winrt::BasicDisplayConfiguration::Rendering::PlanePixelFormat format);
+    void RenderPatternToPlane(winrt::BasicDisplayConfiguration::Rendering::PlaneSurface& surface);
 
 private:
     std::wstring m_currentConfig;
@@ -37,9 +37,35 @@ export inline void SetBitValue(_Inout_bytecap_(pitch*(y + 1)) PBYTE bitmap, _In_
         bitmap[y * pitch + (x / 8)] &= ~((BYTE)0x80 >> (x % 8));
 }
 
+//
+// Operations on a row of 32-bit pixels, with the alpha in the top byte. These work 4 pixels at a time with SSE2 or NEON
+// where available.
+//
+export namespace BitmapRows
+{
+    // Sets every pixel of the row to the same value
+    void Fill(std::span<DWORD> row, DWORD pixel);
+
+    // Returns true if both rows hold the same pixels, they must be the same length
+    bool Equal(std::span<const DWORD> row, std::span<const DWORD> other);
+
+    // Returns true if any pixel of the row has a non-zero alpha
+    bool AnyAlpha(std::span<const DWORD> row);
+
+    // Sets the alpha of every pixel of the row, leaving the color as is
+    void SetAlpha(std::span<DWORD> row, BYTE alpha);
+
+    // Swaps the first and third bytes of every pixel, converting between ARGB and ABGR
+    void SwapRedAndBlue(std::span<DWORD> row);
+}
+
 //
 // Encapsulates a 32-bit ARGB or ABGR bitmap.
 //
+// Bitmaps that allocate their own buffer start every row on a 16 byte boundary, so Pitch can be larger than Width * 4.
+// Those buffers come from a pool shared by all bitmaps and go back to it when the bitmap is destroyed, so making and
+// dropping bitmaps of the same size (as cursor processing does for each shape) doesn't go back to the heap.
+//
 export class Bitmap
 {
 public:
@@ -72,6 +98,10 @@ public:
     bool operator==(const Bitmap& other) const;
     bool operator!=(const Bitmap& other) const;
 
+    // Gets the pixels of a row, without any padding at the end of it
+    std::span<DWORD> Row(DWORD y);
+    std::span<const DWORD> Row(DWORD y) const;
+
     // Gets just the alpha byte of a specified pixel
     BYTE GetPixelAlpha(DWORD x, DWORD y) const;
 
@@ -87,14 +117,185 @@ public:
     // Sets the alpha and color values for all pixels
     void Clear(BYTE alpha, DWORD color);
 
+    // Sets the alpha of all pixels, leaving their colors as they are
+    void SetAlpha(BYTE alpha);
+
+    // Converts between ARGB and ABGR
+    void SwapRedAndBlue();
+
     // Returns true if any pixel contains a non-zero alpha, false otherwise
     bool ContainsNonZeroAlpha();
 
     void Destroy();
+
+private:
+    // Allocates a buffer from the pool for a bitmap of this size, with the pitch rounded up to keep rows aligned
+    void Allocate(DWORD width, DWORD height);
+
+    // The buffer this bitmap allocated, if any. It remembers its own size, so it goes back to the pool in the right
+    // place even if the public fields have been changed since.
+    winrt::BasicDisplayConfiguration::Rendering::BitmapBuffer m_buffer;
 };
 
 module : private;
 
+namespace BitmapRows
+{
+    void Fill(std::span<DWORD> row, DWORD pixel)
+    {
+        size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+        const __m128i pixels = _mm_set1_epi32(static_cast<int>(pixel));
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row.data() + x), pixels);
+        }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+        const uint32x4_t pixels = vdupq_n_u32(pixel);
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            vst1q_u32(reinterpret_cast<uint32_t*>(row.data() + x), pixels);
+        }
+#endif
+        for (; x < row.size(); x++)
+        {
+            row[x] = pixel;
+        }
+    }
+
+    bool Equal(std::span<const DWORD> row, std::span<const DWORD> other)
+    {
+        assert(row.size() == other.size());
+
+        size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.data() + x));
+            const __m128i otherPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other.data() + x));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(pixels, otherPixels)) != 0xFFFF)
+            {
+                return false;
+            }
+        }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            const uint32x4_t pixels = vld1q_u32(reinterpret_cast<const uint32_t*>(row.data() + x));
+            const uint32x4_t otherPixels = vld1q_u32(reinterpret_cast<const uint32_t*>(other.data() + x));
+            if (vminvq_u32(vceqq_u32(pixels, otherPixels)) == 0)
+            {
+                return false;
+            }
+        }
+#endif
+        for (; x < row.size(); x++)
+        {
+            if (row[x] != other[x])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool AnyAlpha(std::span<const DWORD> row)
+    {
+        size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+        // The sign bit of each byte is gathered by movemask, so the alpha bytes are tested by comparing them to zero
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            const __m128i alpha = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row.data() + x)), alphaMask);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) != 0xFFFF)
+            {
+                return true;
+            }
+        }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            if (vmaxvq_u32(vshrq_n_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(row.data() + x)), 24)) != 0)
+            {
+                return true;
+            }
+        }
+#endif
+        for (; x < row.size(); x++)
+        {
+            if (row[x] & 0xFF000000)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void SetAlpha(std::span<DWORD> row, BYTE alpha)
+    {
+        const DWORD alphaBits = static_cast<DWORD>(alpha) << 24;
+
+        size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+        const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i alphas = _mm_set1_epi32(static_cast<int>(alphaBits));
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            auto pixels = reinterpret_cast<__m128i*>(row.data() + x);
+            _mm_storeu_si128(pixels, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(pixels), colorMask), alphas));
+        }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+        const uint32x4_t colorMask = vdupq_n_u32(0x00FFFFFF);
+        const uint32x4_t alphas = vdupq_n_u32(alphaBits);
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            auto pixels = reinterpret_cast<uint32_t*>(row.data() + x);
+            vst1q_u32(pixels, vorrq_u32(vandq_u32(vld1q_u32(pixels), colorMask), alphas));
+        }
+#endif
+        for (; x < row.size(); x++)
+        {
+            row[x] = (row[x] & 0x00FFFFFF) | alphaBits;
+        }
+    }
+
+    void SwapRedAndBlue(std::span<DWORD> row)
+    {
+        size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+        const __m128i keptMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+        const __m128i byteMask = _mm_set1_epi32(0x000000FF);
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            auto pixels = reinterpret_cast<__m128i*>(row.data() + x);
+            const __m128i value = _mm_loadu_si128(pixels);
+            const __m128i low = _mm_slli_epi32(_mm_and_si128(value, byteMask), 16);
+            const __m128i high = _mm_and_si128(_mm_srli_epi32(value, 16), byteMask);
+            _mm_storeu_si128(pixels, _mm_or_si128(_mm_and_si128(value, keptMask), _mm_or_si128(low, high)));
+        }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+        const uint32x4_t keptMask = vdupq_n_u32(0xFF00FF00);
+        const uint32x4_t byteMask = vdupq_n_u32(0x000000FF);
+        for (; x + 4 <= row.size(); x += 4)
+        {
+            auto pixels = reinterpret_cast<uint32_t*>(row.data() + x);
+            const uint32x4_t value = vld1q_u32(pixels);
+            const uint32x4_t low = vshlq_n_u32(vandq_u32(value, byteMask), 16);
+            const uint32x4_t high = vandq_u32(vshrq_n_u32(value, 16), byteMask);
+            vst1q_u32(pixels, vorrq_u32(vandq_u32(value, keptMask), vorrq_u32(low, high)));
+        }
+#endif
+        for (; x < row.size(); x++)
+        {
+            const DWORD value = row[x];
+            row[x] = (value & 0xFF00FF00) | ((value & 0xFF) << 16) | ((value >> 16) & 0xFF);
+        }
+    }
+}
+
 Bitmap::Bitmap()
 {
     Width = 0;
@@ -108,11 +309,7 @@ Bitmap::Bitmap()
 
 Bitmap::Bitmap(DWORD width, DWORD height)
 {
-    Width = width;
-    Height = height;
-    Pitch = width * sizeof(DWORD);
-    Bits = new BYTE[Pitch * height];
-    OwnsBuffer = true;
+    Allocate(width, height);
 }
 
 // Constructs a bitmap by wrapping an existing buffer. Ownership of the
@@ -132,22 +329,12 @@ Bitmap::~Bitmap()
     Destroy();
 }
 
-Bitmap::Bitmap(const Bitmap& copy)
+Bitmap::Bitmap(const Bitmap& copy) : Bitmap()
 {
-    Width = copy.Width;
-    Height = copy.Height;
-    Pitch = copy.Pitch;
-    OwnsBuffer = true;
-
-    if (copy.Bits)
-    {
-        // Always copy to a new buffer
-        Bits = new BYTE[copy.Pitch * copy.Height];
-        memcpy(Bits, copy.Bits, copy.Pitch * copy.Height);
-    }
+    *this = copy;
 }
 
-Bitmap::Bitmap(Bitmap&& move)
+Bitmap::Bitmap(Bitmap&& move) : Bitmap()
 {
     *this = std::move(move);
 }
@@ -157,17 +344,14 @@ Bitmap& Bitmap::operator=(Bitmap&& move)
 {
     if (this != &move)
     {
-        if (Bits && OwnsBuffer)
-        {
-            delete[] Bits;
-            Bits = nullptr;
-        }
+        Destroy();
 
         Width = move.Width;
         Height = move.Height;
         Bits = move.Bits;
         Pitch = move.Pitch;
         OwnsBuffer = move.OwnsBuffer;
+        m_buffer = std::move(move.m_buffer);
 
         move.Bits = nullptr;
         move.Width = 0;
@@ -180,16 +364,28 @@ Bitmap& Bitmap::operator=(Bitmap&& move)
 
 Bitmap& Bitmap::operator=(const Bitmap& copy)
 {
+    if (this == &copy)
+    {
+        return *this;
+    }
+
     Destroy();
-    Width = copy.Width;
-    Height = copy.Height;
-    Pitch = copy.Pitch;
 
-    if (copy.Bits)
+    if (!copy.Bits)
     {
-        OwnsBuffer = true;
-        Bits = new BYTE[Height * Pitch];
-        memcpy(Bits, copy.Bits, Height * Pitch);
+        Width = copy.Width;
+        Height = copy.Height;
+        Pitch = copy.Pitch;
+        Bits = nullptr;
+        OwnsBuffer = false;
+        return *this;
+    }
+
+    // Always copy to a new buffer, a row at a time as the pitches can differ
+    Allocate(copy.Width, copy.Height);
+    for (DWORD y = 0; y < Height; y++)
+    {
+        std::ranges::copy(copy.Row(y), Row(y).begin());
     }
 
     return *this;
@@ -204,12 +400,9 @@ bool Bitmap::operator==(const Bitmap& other) const
 
     for (DWORD y = 0; y < Height; y++)
     {
-        for (DWORD x = 0; x < Width; x++)
+        if (!BitmapRows::Equal(Row(y), other.Row(y)))
         {
-            if (other.GetPixelColor(x, y) != GetPixelColor(x, y) || other.GetPixelAlpha(x, y) != GetPixelAlpha(x, y))
-            {
-                return false;
-            }
+            return false;
         }
     }
 
@@ -221,6 +414,20 @@ bool Bitmap::operator!=(const Bitmap& other) const
     return !(*this == other);
 }
 
+std::span<DWORD> Bitmap::Row(DWORD y)
+{
+    assert(y < Height);
+
+    return {reinterpret_cast<PDWORD>(Bits + static_cast<size_t>(y) * Pitch), Width};
+}
+
+std::span<const DWORD> Bitmap::Row(DWORD y) const
+{
+    assert(y < Height);
+
+    return {reinterpret_cast<const DWORD*>(Bits + static_cast<size_t>(y) * Pitch), Width};
+}
+
 // Gets just the alpha byte of a specified pixel
 
 BYTE Bitmap::GetPixelAlpha(DWORD x, DWORD y) const
@@ -263,13 +470,30 @@ void Bitmap::SetPixelColor(DWORD x, DWORD y, DWORD rgb)
 
 void Bitmap::Clear(BYTE alpha, DWORD color)
 {
+    const DWORD pixel = (static_cast<DWORD>(alpha) << 24) | (color & 0xFFFFFF);
     for (DWORD y = 0; y < Height; y++)
     {
-        for (DWORD x = 0; x < Width; x++)
-        {
-            SetPixelAlpha(x, y, alpha);
-            SetPixelColor(x, y, color);
-        }
+        BitmapRows::Fill(Row(y), pixel);
+    }
+}
+
+// Sets the alpha of all pixels, leaving their colors as they are
+
+void Bitmap::SetAlpha(BYTE alpha)
+{
+    for (DWORD y = 0; y < Height; y++)
+    {
+        BitmapRows::SetAlpha(Row(y), alpha);
+    }
+}
+
+// Converts between ARGB and ABGR
+
+void Bitmap::SwapRedAndBlue()
+{
+    for (DWORD y = 0; y < Height; y++)
+    {
+        BitmapRows::SwapRedAndBlue(Row(y));
     }
 }
 
@@ -279,12 +503,9 @@ bool Bitmap::ContainsNonZeroAlpha()
 {
     for (DWORD y = 0; y < Height; y++)
     {
-        for (DWORD x = 0; x < Width; x++)
+        if (BitmapRows::AnyAlpha(Row(y)))
         {
-            if (GetPixelAlpha(x, y) != 0)
-            {
-                return true;
-            }
+            return true;
         }
     }
     return false;
@@ -294,10 +515,22 @@ void Bitmap::Destroy()
 {
     if (Bits && OwnsBuffer)
     {
-        delete[] Bits;
         Bits = nullptr;
         Width = 0;
         Height = 0;
         Pitch = 0;
+        OwnsBuffer = false;
     }
+
+    m_buffer.Reset();
+}
+
+void Bitmap::Allocate(DWORD width, DWORD height)
+{
+    Width = width;
+    Height = height;
+    Pitch = (width * sizeof(DWORD) + 15) & ~15u;
+    m_buffer = winrt::BasicDisplayConfiguration::Rendering::BitmapBufferPool::Default().Allocate(static_cast<size_t>(Pitch) * Height);
+    Bits = m_buffer.Data();
+    OwnsBuffer = true;
 }
@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+//
+// Memory for bitmap pixels, in blocks aligned for SIMD. Blocks go back to a pool when they are released and are handed
+// out again for requests of the same size, so making and dropping bitmaps of the same few sizes (as cursor processing
+// does for each shape) doesn't go back to the heap. Only depends on the standard library.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    class BitmapBufferPool;
+
+    //
+    // A block from a BitmapBufferPool, given back to it when released or destroyed. The block keeps the size it was
+    // allocated with, and it's always pooled under that size whatever its owner does with the memory. It must not
+    // outlive its pool.
+    //
+    class BitmapBuffer
+    {
+    public:
+        BitmapBuffer() = default;
+
+        BitmapBuffer(const BitmapBuffer&) = delete;
+        BitmapBuffer& operator=(const BitmapBuffer&) = delete;
+
+        BitmapBuffer(BitmapBuffer&& other) noexcept :
+            m_pool(std::exchange(other.m_pool, nullptr)),
+            m_data(std::exchange(other.m_data, nullptr)),
+            m_size(std::exchange(other.m_size, 0))
+        {
+        }
+
+        BitmapBuffer& operator=(BitmapBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_pool = std::exchange(other.m_pool, nullptr);
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+            }
+
+            return *this;
+        }
+
+        ~BitmapBuffer()
+        {
+            Reset();
+        }
+
+        uint8_t* Data() const
+        {
+            return m_data;
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        // Gives the block back to its pool, leaving this empty
+        inline void Reset();
+
+    private:
+        friend class BitmapBufferPool;
+
+        BitmapBuffer(BitmapBufferPool* pool, uint8_t* data, size_t size) : m_pool(pool), m_data(data), m_size(size)
+        {
+        }
+
+        BitmapBufferPool* m_pool = nullptr;
+        uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    //
+    // Keeps released blocks to be handed out again for the same size, up to maxPooledBytes of them. Anything beyond that
+    // goes back to the heap.
+    //
+    class BitmapBufferPool
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+        static constexpr size_t DefaultMaxPooledBytes = 16 * 1024 * 1024;
+
+        explicit BitmapBufferPool(size_t maxPooledBytes = DefaultMaxPooledBytes) : m_maxPooledBytes(maxPooledBytes)
+        {
+        }
+
+        BitmapBufferPool(const BitmapBufferPool&) = delete;
+        BitmapBufferPool& operator=(const BitmapBufferPool&) = delete;
+
+        ~BitmapBufferPool()
+        {
+            for (auto& [size, blocks] : m_blocks)
+            {
+                for (auto block : blocks)
+                {
+                    ::operator delete(block, std::align_val_t{Alignment});
+                }
+            }
+        }
+
+        // The pool shared by all bitmaps
+        static BitmapBufferPool& Default()
+        {
+            static BitmapBufferPool pool;
+            return pool;
+        }
+
+        // A block of at least one byte, so that even empty bitmaps have a buffer of their own
+        BitmapBuffer Allocate(size_t size)
+        {
+            size = (std::max)(size, size_t{1});
+
+            {
+                std::lock_guard lock(m_lock);
+                auto blocks = m_blocks.find(size);
+                if (blocks != m_blocks.end() && !blocks->second.empty())
+                {
+                    uint8_t* block = blocks->second.back();
+                    blocks->second.pop_back();
+                    m_pooledBytes -= size;
+                    return BitmapBuffer(this, block, size);
+                }
+            }
+
+            return BitmapBuffer(this, static_cast<uint8_t*>(::operator new(size, std::align_val_t{Alignment})), size);
+        }
+
+        // The bytes of the blocks waiting to be handed out again
+        size_t PooledBytes()
+        {
+            std::lock_guard lock(m_lock);
+            return m_pooledBytes;
+        }
+
+    private:
+        friend class BitmapBuffer;
+
+        void Release(uint8_t* block, size_t size)
+        {
+            {
+                std::lock_guard lock(m_lock);
+                if (m_pooledBytes + size <= m_maxPooledBytes)
+                {
+                    m_blocks[size].push_back(block);
+                    m_pooledBytes += size;
+                    return;
+                }
+            }
+
+            ::operator delete(block, std::align_val_t{Alignment});
+        }
+
+        const size_t m_maxPooledBytes;
+
+        std::mutex m_lock;
+        std::map<size_t, std::vector<uint8_t*>> m_blocks;
+        size_t m_pooledBytes = 0;
+    };
+
+    inline void BitmapBuffer::Reset()
+    {
+        if (m_data)
+        {
+            m_pool->Release(m_data, m_size);
+        }
+
+        m_pool = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
@@ -0,0 +1,372 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <variant>
+#include <vector>
+
+//
+// Post-blend color pipelines.
+//
+// A pipeline is described as the chain of matrix and 1D curve steps the hardware (or the Win2D effect graph) applies. It
+// is then compiled once per frame: consecutive matrices are folded into a single 3x4 transform, identity steps are
+// dropped, and what is left (usually a single transform, with curves on either side) is run over blocks of pixels held
+// as separate channel arrays so that every step is a simple loop the compiler can vectorize. A whole frame is then one
+// pass over memory no matter how many steps the pipeline describes.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    // A 3x3 color matrix with the layout of the top left of Win2D's Matrix5x4, which is applied to row vectors:
+    // out[c] = in[0] * M[0][c] + in[1] * M[1][c] + in[2] * M[2][c]. Stored row-major.
+    using ColorMatrix = std::array<float, 9>;
+
+    inline constexpr ColorMatrix IdentityColorMatrix = {1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f};
+
+    // The same coefficients RenderPredictionFrame hands to its RGB->XYZ and XYZ->RGB ColorMatrixEffects
+    inline constexpr ColorMatrix RgbToXyzMatrix = {
+        0.4124564f, 0.3575761f, 0.1804375f,
+        0.2126729f, 0.7151522f, 0.0721750f,
+        0.0193339f, 0.1191920f, 0.9503041f};
+
+    inline constexpr ColorMatrix XyzToRgbMatrix = {
+         3.2404542f, -1.5371385f, -0.4985314f,
+        -0.9692660f,  1.8760108f,  0.0415560f,
+         0.0556434f, -0.2040259f,  1.0572252f};
+
+    // An affine color transform, the matrix followed by an offset. This is what a ColorMatrixEffect does with the top
+    // left of its Matrix5x4 and the first three columns of its last row.
+    struct ColorTransform
+    {
+        ColorMatrix Matrix = IdentityColorMatrix;
+        std::array<float, 3> Offset = {0.f, 0.f, 0.f};
+
+        bool IsIdentity() const
+        {
+            return Matrix == IdentityColorMatrix && Offset == std::array<float, 3>{0.f, 0.f, 0.f};
+        }
+
+        bool operator==(const ColorTransform&) const = default;
+    };
+
+    enum class CurveLookup
+    {
+        // The value selects one of N equal width steps, as D2D's discrete transfer effect does
+        Discrete,
+        // The value is interpolated between N evenly spaced stops, as D2D's table transfer effect does
+        Linear
+    };
+
+    // A 1D curve applied to each of red, green and blue. An empty table leaves values unchanged.
+    struct ColorCurve
+    {
+        std::vector<float> Table;
+        CurveLookup Lookup = CurveLookup::Discrete;
+
+        bool operator==(const ColorCurve&) const = default;
+    };
+
+    using ColorStage = std::variant<ColorTransform, ColorCurve>;
+
+    // The steps of a pipeline in the order they are applied. Steps work on straight alpha color.
+    class ColorPipeline
+    {
+    public:
+        ColorPipeline& Add(ColorTransform transform)
+        {
+            m_stages.emplace_back(std::move(transform));
+            return *this;
+        }
+
+        ColorPipeline& Add(const ColorMatrix& matrix)
+        {
+            return Add(ColorTransform{matrix});
+        }
+
+        ColorPipeline& Add(ColorCurve curve)
+        {
+            m_stages.emplace_back(std::move(curve));
+            return *this;
+        }
+
+        std::span<const ColorStage> Stages() const
+        {
+            return m_stages;
+        }
+
+        bool operator==(const ColorPipeline&) const = default;
+
+    private:
+        std::vector<ColorStage> m_stages;
+    };
+
+    namespace Details {
+
+        // The matrix equivalent to applying a and then b
+        inline ColorMatrix ConcatenateColorMatrices(const ColorMatrix& a, const ColorMatrix& b)
+        {
+            ColorMatrix result{};
+            for (size_t row = 0; row < 3; row++)
+            {
+                for (size_t column = 0; column < 3; column++)
+                {
+                    double sum = 0.0;
+                    for (size_t i = 0; i < 3; i++)
+                    {
+                        sum += static_cast<double>(a[row * 3 + i]) * static_cast<double>(b[i * 3 + column]);
+                    }
+
+                    result[row * 3 + column] = static_cast<float>(sum);
+                }
+            }
+
+            return result;
+        }
+
+        // The transform equivalent to applying a and then b, (c * A + a') * B + b' = c * (A * B) + (a' * B + b')
+        inline ColorTransform ConcatenateColorTransforms(const ColorTransform& a, const ColorTransform& b)
+        {
+            ColorTransform result;
+            result.Matrix = ConcatenateColorMatrices(a.Matrix, b.Matrix);
+
+            for (size_t column = 0; column < 3; column++)
+            {
+                double sum = b.Offset[column];
+                for (size_t i = 0; i < 3; i++)
+                {
+                    sum += static_cast<double>(a.Offset[i]) * static_cast<double>(b.Matrix[i * 3 + column]);
+                }
+
+                result.Offset[column] = static_cast<float>(sum);
+            }
+
+            return result;
+        }
+
+        inline float ApplyDiscreteCurve(std::span<const float> curve, float value)
+        {
+            if (curve.empty())
+            {
+                return value;
+            }
+
+            const size_t stops = curve.size();
+            if (!(value > 0.0f))
+            {
+                return curve[0];
+            }
+
+            const float scaled = value * static_cast<float>(stops);
+            const size_t step = scaled >= static_cast<float>(stops - 1) ? stops - 1 : static_cast<size_t>(scaled);
+            return curve[step];
+        }
+
+        inline float ApplyLinearCurve(std::span<const float> curve, float value)
+        {
+            if (curve.size() < 2)
+            {
+                return curve.empty() ? value : curve[0];
+            }
+
+            const size_t lastStop = curve.size() - 1;
+            const float position = (value > 0.0f ? (std::min)(value, 1.0f) : 0.0f) * static_cast<float>(lastStop);
+            const size_t stop = (std::min)(static_cast<size_t>(position), lastStop - 1);
+            const float fraction = position - static_cast<float>(stop);
+            return curve[stop] + fraction * (curve[stop + 1] - curve[stop]);
+        }
+
+    } // namespace Details
+
+    // Looks values up in a curve table in place. Gives the same results as ApplyDiscreteCurve and ApplyLinearCurve, but
+    // is written as clamps so that the index math vectorizes.
+    inline void ApplyColorCurve(std::span<const float> table, CurveLookup lookup, std::span<float> values)
+    {
+        const size_t stops = table.size();
+        if (stops == 0)
+        {
+            return;
+        }
+
+        const float lastStop = static_cast<float>(stops - 1);
+
+        if (lookup == CurveLookup::Discrete)
+        {
+            const float steps = static_cast<float>(stops);
+            for (float& value : values)
+            {
+                float scaled = value * steps;
+                scaled = scaled > 0.0f ? scaled : 0.0f;
+                scaled = scaled < lastStop ? scaled : lastStop;
+                value = table[static_cast<uint32_t>(scaled)];
+            }
+
+            return;
+        }
+
+        if (stops < 2)
+        {
+            std::fill(values.begin(), values.end(), table[0]);
+            return;
+        }
+
+        const uint32_t lastInterval = static_cast<uint32_t>(stops - 2);
+        for (float& value : values)
+        {
+            float position = value > 0.0f ? value : 0.0f;
+            position = (position < 1.0f ? position : 1.0f) * lastStop;
+
+            uint32_t stop = static_cast<uint32_t>(position);
+            stop = stop < lastInterval ? stop : lastInterval;
+
+            const float fraction = position - static_cast<float>(stop);
+            value = table[stop] + fraction * (table[stop + 1] - table[stop]);
+        }
+    }
+
+    // Pixels are run through a compiled pipeline this many at a time, one array per channel
+    inline constexpr size_t ColorBlockSize = 64;
+
+    struct ColorBlock
+    {
+        alignas(32) float R[ColorBlockSize];
+        alignas(32) float G[ColorBlockSize];
+        alignas(32) float B[ColorBlockSize];
+        alignas(32) float A[ColorBlockSize];
+    };
+
+    class CompiledColorPipeline
+    {
+    public:
+        CompiledColorPipeline() = default;
+
+        explicit CompiledColorPipeline(const ColorPipeline& pipeline)
+        {
+            for (const auto& stage : pipeline.Stages())
+            {
+                if (const auto transform = std::get_if<ColorTransform>(&stage))
+                {
+                    // Fold into the transform before it, unless a curve sits in between
+                    if (!m_stages.empty() && std::holds_alternative<ColorTransform>(m_stages.back()))
+                    {
+                        m_stages.back() = Details::ConcatenateColorTransforms(std::get<ColorTransform>(m_stages.back()), *transform);
+                    }
+                    else
+                    {
+                        m_stages.push_back(*transform);
+                    }
+                }
+                else if (!std::get<ColorCurve>(stage).Table.empty())
+                {
+                    m_stages.push_back(stage);
+                }
+            }
+
+            // Folding can leave behind transforms that do nothing
+            std::erase_if(m_stages, [](const ColorStage& stage) {
+                const auto transform = std::get_if<ColorTransform>(&stage);
+                return transform && transform->IsIdentity();
+            });
+
+            m_affine = m_stages.empty() || (m_stages.size() == 1 && std::holds_alternative<ColorTransform>(m_stages[0]));
+        }
+
+        // What is left after folding, at most one transform between each pair of curves
+        std::span<const ColorStage> Stages() const
+        {
+            return m_stages;
+        }
+
+        // Whether the whole pipeline is a single transform (or nothing at all)
+        bool IsAffine() const
+        {
+            return m_affine;
+        }
+
+        // Runs the first count pixels of a block of premultiplied color through the pipeline, leaving the result
+        // premultiplied by the same alpha. This matches what the Win2D effects do with premultiplied images: each step
+        // works on the straight color and the result is premultiplied again.
+        void ApplyPremultiplied(ColorBlock& block, size_t count) const
+        {
+            if (m_stages.empty())
+            {
+                return;
+            }
+
+            // A transform distributes over premultiplication, only its offset needs scaling by alpha
+            if (m_affine)
+            {
+                ApplyTransform(std::get<ColorTransform>(m_stages[0]), block, count, true);
+                return;
+            }
+
+            float inverseAlpha[ColorBlockSize];
+            for (size_t i = 0; i < count; i++)
+            {
+                inverseAlpha[i] = block.A[i] > 0.0f ? 1.0f / block.A[i] : 0.0f;
+            }
+
+            Scale(block, inverseAlpha, count);
+            Apply(block, count);
+            Scale(block, block.A, count);
+        }
+
+        // Runs the first count pixels of a block of straight color through the pipeline
+        void Apply(ColorBlock& block, size_t count) const
+        {
+            for (const auto& stage : m_stages)
+            {
+                if (const auto transform = std::get_if<ColorTransform>(&stage))
+                {
+                    ApplyTransform(*transform, block, count, false);
+                }
+                else
+                {
+                    const auto& curve = std::get<ColorCurve>(stage);
+                    ApplyColorCurve(curve.Table, curve.Lookup, std::span(block.R, count));
+                    ApplyColorCurve(curve.Table, curve.Lookup, std::span(block.G, count));
+                    ApplyColorCurve(curve.Table, curve.Lookup, std::span(block.B, count));
+                }
+            }
+        }
+
+    private:
+        static void Scale(ColorBlock& block, const float* scale, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                block.R[i] *= scale[i];
+                block.G[i] *= scale[i];
+                block.B[i] *= scale[i];
+            }
+        }
+
+        static void ApplyTransform(const ColorTransform& transform, ColorBlock& block, size_t count, bool premultiplied)
+        {
+            const auto& m = transform.Matrix;
+            for (size_t i = 0; i < count; i++)
+            {
+                const float r = block.R[i], g = block.G[i], b = block.B[i];
+                block.R[i] = r * m[0] + g * m[3] + b * m[6];
+                block.G[i] = r * m[1] + g * m[4] + b * m[7];
+                block.B[i] = r * m[2] + g * m[5] + b * m[8];
+            }
+
+            if (transform.Offset == std::array<float, 3>{0.f, 0.f, 0.f})
+            {
+                return;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const float scale = premultiplied ? block.A[i] : 1.0f;
+                block.R[i] += transform.Offset[0] * scale;
+                block.G[i] += transform.Offset[1] * scale;
+                block.B[i] += transform.Offset[2] * scale;
+            }
+        }
+
+        std::vector<ColorStage> m_stages;
+        bool m_affine = true;
+    };
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
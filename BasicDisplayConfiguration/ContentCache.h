@@ -0,0 +1,203 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+//
+// The pieces shared by the caches of this project: a key made of everything that goes into producing some content, and
+// an in-memory store of the most recently used content up to a budget. Only depends on the standard library.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    namespace Details {
+
+        inline uint64_t MixHash(uint64_t value)
+        {
+            value ^= value >> 33;
+            value *= 0xFF51AFD7ED558CCDull;
+            value ^= value >> 33;
+            value *= 0xC4CEB9FE1A85EC53ull;
+            value ^= value >> 33;
+            return value;
+        }
+
+        // A fast non-cryptographic 64 bit hash. Four independent lanes keep the multiplies from serializing, so large
+        // plane surfaces hash at close to memory speed.
+        inline uint64_t HashBytes(const void* data, size_t size)
+        {
+            constexpr uint64_t Prime = 0x9E3779B97F4A7C15ull;
+            const auto bytes = static_cast<const uint8_t*>(data);
+
+            uint64_t lanes[4] = {Prime, Prime ^ 1, Prime ^ 2, Prime ^ 3};
+            size_t offset = 0;
+            for (; offset + 32 <= size; offset += 32)
+            {
+                for (size_t lane = 0; lane < 4; lane++)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, bytes + offset + lane * 8, sizeof(word));
+                    lanes[lane] = std::rotl(lanes[lane] ^ (word * Prime), 31) * Prime;
+                }
+            }
+
+            uint64_t hash = static_cast<uint64_t>(size);
+            for (uint64_t lane : lanes)
+            {
+                hash = MixHash(hash ^ lane);
+            }
+
+            for (; offset < size; offset++)
+            {
+                hash = (hash ^ bytes[offset]) * Prime;
+            }
+
+            return MixHash(hash);
+        }
+
+    } // namespace Details
+
+    //
+    // The canonical description of some cached content. Values are appended in a fixed order, large contents (such as
+    // plane pixels) are reduced to a hash. Two keys are equal only if every value that went into them is.
+    //
+    class ContentCacheKey
+    {
+    public:
+        template <typename T>
+            requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+        void Add(T value)
+        {
+            Append(&value, sizeof(value));
+        }
+
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        void Add(std::span<const T> values)
+        {
+            Add(static_cast<uint64_t>(values.size()));
+            Append(values.data(), values.size_bytes());
+        }
+
+        void Add(std::wstring_view text)
+        {
+            Add(std::span<const wchar_t>(text.data(), text.size()));
+        }
+
+        void AddContent(const void* data, size_t size)
+        {
+            Add(static_cast<uint64_t>(size));
+            Add(Details::HashBytes(data, size));
+        }
+
+        const std::string& Bytes() const
+        {
+            return m_bytes;
+        }
+
+        uint64_t Hash() const
+        {
+            return Details::HashBytes(m_bytes.data(), m_bytes.size());
+        }
+
+    private:
+        void Append(const void* data, size_t size)
+        {
+            m_bytes.append(static_cast<const char*>(data), size);
+        }
+
+        std::string m_bytes;
+    };
+
+    //
+    // Shared, immutable values by key, most recently used first, kept up to a budget of bytes as reported by each value's
+    // SizeInBytes(). A budget of 0 keeps nothing.
+    //
+    template <typename T>
+    class LruContentCache
+    {
+    public:
+        explicit LruContentCache(size_t memoryBudget) : m_memoryBudget(memoryBudget)
+        {
+        }
+
+        LruContentCache(const LruContentCache&) = delete;
+        LruContentCache& operator=(const LruContentCache&) = delete;
+
+        size_t MemoryBudget() const
+        {
+            return m_memoryBudget;
+        }
+
+        // Returns the value for the key, or null
+        std::shared_ptr<const T> Find(const ContentCacheKey& key)
+        {
+            std::lock_guard lock(m_lock);
+            auto entry = m_index.find(key.Bytes());
+            if (entry == m_index.end())
+            {
+                return nullptr;
+            }
+
+            // Most recently used entries live at the front
+            m_entries.splice(m_entries.begin(), m_entries, entry->second);
+            return entry->second->Value;
+        }
+
+        // Values larger than the whole budget aren't kept, and a key that is already present keeps its value
+        void Insert(const ContentCacheKey& key, std::shared_ptr<const T> value)
+        {
+            const size_t size = value->SizeInBytes();
+            if (size > m_memoryBudget)
+            {
+                return;
+            }
+
+            std::lock_guard lock(m_lock);
+            if (m_index.contains(key.Bytes()))
+            {
+                return;
+            }
+
+            // Evict least recently used values until the new one fits
+            while (m_memoryUsed + size > m_memoryBudget && !m_entries.empty())
+            {
+                m_memoryUsed -= m_entries.back().Value->SizeInBytes();
+                m_index.erase(m_entries.back().Key);
+                m_entries.pop_back();
+            }
+
+            m_entries.push_front({key.Bytes(), std::move(value)});
+            m_index.emplace(key.Bytes(), m_entries.begin());
+            m_memoryUsed += size;
+        }
+
+        size_t MemoryUsed()
+        {
+            std::lock_guard lock(m_lock);
+            return m_memoryUsed;
+        }
+
+    private:
+        struct Entry
+        {
+            std::string Key;
+            std::shared_ptr<const T> Value;
+        };
+
+        const size_t m_memoryBudget;
+
+        std::mutex m_lock;
+        std::list<Entry> m_entries;
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> m_index;
+        size_t m_memoryUsed = 0;
+    };
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
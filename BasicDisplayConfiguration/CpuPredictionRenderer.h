@@ -0,0 +1,1636 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "AnalyticFrame.h"
+#include "ColorPipeline.h"
+#include "HalfFloat.h"
+#include "ThreadPool.h"
+#include "TiledFrame.h"
+#include "WireFormatEmulation.h"
+
+//
+// CPU implementation of the prediction pipeline in PredictionRenderer.
+//
+// This follows the same idealized pipeline as the Win2D path in RenderPredictionFrame (plane composition with per-plane
+// degamma, then the compiled post-blend ColorPipeline), but renders a band of target rows at a time straight into
+// the scRGB output buffer, so no intermediate full-frame surfaces are needed and bands can be rendered in parallel. It
+// only depends on the standard library so that predictions can be rendered and validated on machines without a D3D or
+// Win2D stack. Frames made of flat content can also be described as an AnalyticFrame, without rendering every pixel.
+//
+// Any number of planes are composed back to front, each with its own alpha mode, source and destination rectangles,
+// transform and clip. Texels are converted to premultiplied linear float a run at a time and blended onto the row with
+// SSE or NEON, one pixel per vector, which gives exactly the same result as blending them one channel at a time.
+//
+// Axis aligned planes that are scaled are resampled separably, from per-column and per-row tables of texels and weights
+// built once per frame: each target row first weights its texel rows into one row of texels, which is then weighted
+// across into the target pixels. Every row is computed the same way whichever thread renders it, so the result is
+// reproducible.
+//
+// The post-blend result can then be sent through an emulation of the wire format (see WireFormatEmulation.h). With 4:2:0
+// the two rows that share chroma are always rendered together.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    // Identifies what this renderer produces, cached predictions from other versions are never used. Increase it with
+    // every change to the rendered pixels.
+    inline constexpr uint32_t RendererVersion = 4;
+
+    enum class PlanePixelFormat
+    {
+        R8G8B8A8UIntNormalized,
+        R16G16B16A16Float
+    };
+
+    enum class PlaneAlphaMode
+    {
+        Premultiplied,
+        Straight,
+        Ignore
+    };
+
+    enum class PlaneInterpolation
+    {
+        NearestNeighbor,
+        Linear,
+        Cubic,
+        Lanczos3
+    };
+
+    inline uint32_t BytesPerPixel(PlanePixelFormat format)
+    {
+        return format == PlanePixelFormat::R16G16B16A16Float ? 8 : 4;
+    }
+
+    //
+    // CPU-side contents of a plane, as an alternative to a D3D surface. Pixels hold the plane's encoded values (before
+    // degamma) laid out as the corresponding DXGI format would be.
+    //
+    class PlaneSurface
+    {
+    public:
+        PlaneSurface(PlanePixelFormat format, uint32_t width, uint32_t height) :
+            m_format(format),
+            m_width(width),
+            m_height(height),
+            m_rowPitch(static_cast<size_t>(width) * BytesPerPixel(format)),
+            m_data(m_rowPitch * height)
+        {
+        }
+
+        PlanePixelFormat Format() const
+        {
+            return m_format;
+        }
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        size_t RowPitch() const
+        {
+            return m_rowPitch;
+        }
+
+        uint8_t* Row(uint32_t y)
+        {
+            return m_data.data() + y * m_rowPitch;
+        }
+
+        const uint8_t* Row(uint32_t y) const
+        {
+            return m_data.data() + y * m_rowPitch;
+        }
+
+        // Describes the surface as bands of identical rows, bandStarts holds the first row of each band in increasing
+        // order. Whoever fills the surface has to keep this true, the renderer then treats every row of a band alike.
+        void SetRowBands(std::vector<uint32_t> bandStarts)
+        {
+            m_bandStarts = std::move(bandStarts);
+        }
+
+        bool HasRowBands() const
+        {
+            return !m_bandStarts.empty();
+        }
+
+        // Rows in the same band have the same index, only meaningful when HasRowBands
+        uint32_t RowBand(uint32_t y) const
+        {
+            return static_cast<uint32_t>(std::upper_bound(m_bandStarts.begin(), m_bandStarts.end(), y) - m_bandStarts.begin());
+        }
+
+    private:
+        const PlanePixelFormat m_format;
+        const uint32_t m_width;
+        const uint32_t m_height;
+        const size_t m_rowPitch;
+        std::vector<uint8_t> m_data;
+        std::vector<uint32_t> m_bandStarts;
+    };
+
+    struct PlaneRect
+    {
+        float Left = 0.0f;
+        float Top = 0.0f;
+        float Right = 0.0f;
+        float Bottom = 0.0f;
+
+        bool operator==(const PlaneRect&) const = default;
+    };
+
+    // A rectangle of whole pixels (or texels), [Left, Right) x [Top, Bottom)
+    struct PixelRect
+    {
+        uint32_t Left = 0;
+        uint32_t Top = 0;
+        uint32_t Right = 0;
+        uint32_t Bottom = 0;
+    };
+
+    // A 2D affine transform with the same row-vector layout as float3x2, (x, y) maps to
+    // (x * M11 + y * M21 + M31, x * M12 + y * M22 + M32).
+    struct AffineTransform
+    {
+        float M11 = 1.0f, M12 = 0.0f;
+        float M21 = 0.0f, M22 = 1.0f;
+        float M31 = 0.0f, M32 = 0.0f;
+
+        float Determinant() const
+        {
+            return M11 * M22 - M12 * M21;
+        }
+
+        // Only valid when the determinant is non-zero
+        AffineTransform Inverse() const
+        {
+            const float inverseDeterminant = 1.0f / Determinant();
+
+            AffineTransform inverse;
+            inverse.M11 = M22 * inverseDeterminant;
+            inverse.M12 = -M12 * inverseDeterminant;
+            inverse.M21 = -M21 * inverseDeterminant;
+            inverse.M22 = M11 * inverseDeterminant;
+            inverse.M31 = -(M31 * inverse.M11 + M32 * inverse.M21);
+            inverse.M32 = -(M31 * inverse.M12 + M32 * inverse.M22);
+            return inverse;
+        }
+
+        bool operator==(const AffineTransform&) const = default;
+    };
+
+    struct CpuPlane
+    {
+        std::shared_ptr<const PlaneSurface> Surface;
+        PlaneAlphaMode AlphaMode = PlaneAlphaMode::Premultiplied;
+
+        // Maps encoded values to linear ones, looked up the way D2D's discrete transfer effect does (the value selects
+        // one of N equal width steps). An empty curve leaves values unchanged.
+        std::vector<float> DegammaCurve;
+
+        // Maps the plane's space (the space DestinationRect is given in) to target pixel coordinates
+        AffineTransform Transform;
+        PlaneRect DestinationRect;
+        PlaneRect SourceRect;
+        PlaneInterpolation Interpolation = PlaneInterpolation::Linear;
+
+        // Limits the plane to the target pixels whose centers fall inside, in target pixel coordinates
+        std::optional<PlaneRect> ClipRect;
+    };
+
+    struct CpuFrame
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+
+        // The background is only drawn when rendering the full target, otherwise the planes are composed onto
+        // transparent black.
+        bool FillBackground = true;
+        std::array<float, 4> BackgroundColor = {0.f, 0.f, 0.f, 1.f};
+
+        // In back to front order
+        std::vector<CpuPlane> Planes;
+
+        // Applied to the composed planes, which are then drawn over opaque black
+        ColorPipeline PostBlend;
+
+        // What the post-blend result goes through on its way to the sink, nothing for an idealized prediction
+        std::optional<WireFormatEmulation> Wire;
+    };
+
+    namespace Details {
+
+        // Matches the conversion D3D does when writing to an R8G8B8A8_UNORM_SRGB render target
+        inline uint32_t EncodeSrgb8(float value)
+        {
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            value = value * 255.0f + 0.5f;
+
+            if (!(value > 0.0f))
+            {
+                return 0;
+            }
+
+            return value >= 255.0f ? 255 : static_cast<uint32_t>(value);
+        }
+
+        // The preview is made from the fp16 output just like the GPU path makes it from its fp16 target, so every half
+        // value's encoding is computed once and looked up
+        inline const std::array<uint8_t, 65536>& Srgb8FromHalfTable()
+        {
+            static const auto table = [] {
+                std::array<uint8_t, 65536> encodings{};
+                for (uint32_t value = 0; value < encodings.size(); value++)
+                {
+                    encodings[value] = static_cast<uint8_t>(
+                        EncodeSrgb8(MicrosoftDisplayCaptureTools::Libraries::HalfFloat::ToFloat(static_cast<uint16_t>(value))));
+                }
+                return encodings;
+            }();
+
+            return table;
+        }
+
+        // The sRGB 8bpc preview pixel (RGBA) of an scRGB pixel, srgb8FromHalf is Srgb8FromHalfTable()
+        inline uint32_t Srgb8FromScRgb(const std::array<uint8_t, 65536>& srgb8FromHalf, uint64_t pixel)
+        {
+            return static_cast<uint32_t>(srgb8FromHalf[pixel & 0xFFFF]) | (static_cast<uint32_t>(srgb8FromHalf[(pixel >> 16) & 0xFFFF]) << 8) |
+                   (static_cast<uint32_t>(srgb8FromHalf[(pixel >> 32) & 0xFFFF]) << 16) | 0xFF000000u;
+        }
+
+        struct LinearPixel
+        {
+            float R, G, B, A;
+        };
+
+        // Texels are converted this many at a time before being blended
+        inline constexpr uint32_t BlendRunSize = 64;
+
+        // Scratch space for resampling a run of a plane, kept by whoever renders a range of rows so that it is only
+        // allocated once for all of them
+        struct ResamplingScratch
+        {
+            std::vector<LinearPixel> Texels;
+            std::vector<LinearPixel> Weighted;
+        };
+
+        // destination[i] += source[i] * weight
+        inline void AddWeightedRow(LinearPixel* destination, const LinearPixel* source, float weight, size_t count)
+        {
+#if defined(_M_X64) || defined(__x86_64__)
+            const __m128 weights = _mm_set1_ps(weight);
+            for (size_t i = 0; i < count; i++)
+            {
+                _mm_storeu_ps(&destination[i].R, _mm_add_ps(_mm_loadu_ps(&destination[i].R), _mm_mul_ps(_mm_loadu_ps(&source[i].R), weights)));
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            const float32x4_t weights = vdupq_n_f32(weight);
+            for (size_t i = 0; i < count; i++)
+            {
+                vst1q_f32(&destination[i].R, vaddq_f32(vld1q_f32(&destination[i].R), vmulq_f32(vld1q_f32(&source[i].R), weights)));
+            }
+#else
+            for (size_t i = 0; i < count; i++)
+            {
+                destination[i].R = destination[i].R + source[i].R * weight;
+                destination[i].G = destination[i].G + source[i].G * weight;
+                destination[i].B = destination[i].B + source[i].B * weight;
+                destination[i].A = destination[i].A + source[i].A * weight;
+            }
+#endif
+        }
+
+        // The sum of texels[indices[i] - firstIndex] * weights[i], added up in order
+        inline LinearPixel WeightedSum(const LinearPixel* texels, int32_t firstIndex, const int32_t* indices, const float* weights, size_t count)
+        {
+            LinearPixel sum{0.0f, 0.0f, 0.0f, 0.0f};
+#if defined(_M_X64) || defined(__x86_64__)
+            __m128 accumulator = _mm_setzero_ps();
+            for (size_t i = 0; i < count; i++)
+            {
+                accumulator = _mm_add_ps(accumulator, _mm_mul_ps(_mm_loadu_ps(&texels[indices[i] - firstIndex].R), _mm_set1_ps(weights[i])));
+            }
+            _mm_storeu_ps(&sum.R, accumulator);
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            float32x4_t accumulator = vdupq_n_f32(0.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                accumulator = vaddq_f32(accumulator, vmulq_f32(vld1q_f32(&texels[indices[i] - firstIndex].R), vdupq_n_f32(weights[i])));
+            }
+            vst1q_f32(&sum.R, accumulator);
+#else
+            for (size_t i = 0; i < count; i++)
+            {
+                const LinearPixel& texel = texels[indices[i] - firstIndex];
+                sum.R = sum.R + texel.R * weights[i];
+                sum.G = sum.G + texel.G * weights[i];
+                sum.B = sum.B + texel.B * weights[i];
+                sum.A = sum.A + texel.A * weights[i];
+            }
+#endif
+            return sum;
+        }
+
+        // Catmull-Rom, the cubic convolution kernel with a = -0.5
+        inline double CubicKernel(double x)
+        {
+            x = std::abs(x);
+            if (x < 1.0)
+            {
+                return (1.5 * x - 2.5) * x * x + 1.0;
+            }
+
+            return x < 2.0 ? ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0 : 0.0;
+        }
+
+        inline double Lanczos3Kernel(double x)
+        {
+            x = std::abs(x);
+            if (x < 1e-9)
+            {
+                return 1.0;
+            }
+
+            if (x >= 3.0)
+            {
+                return 0.0;
+            }
+
+            const double angle = std::numbers::pi * x;
+            return 3.0 * std::sin(angle) * std::sin(angle / 3.0) / (angle * angle);
+        }
+
+        //
+        // The texels each target column (or row) of a plane is resampled from and their weights. Texel indices are
+        // already clamped to the ones that can be sampled.
+        //
+        struct ResamplingTaps
+        {
+            // The taps of column i are [Offsets[i], Offsets[i + 1])
+            std::vector<uint32_t> Offsets;
+            std::vector<int32_t> Texels;
+            std::vector<float> Weights;
+
+            // Builds the taps for sample positions centers (in source texels, texel i is centered on i + 0.5), which are
+            // texelsPerPixel texels apart. Nearest and linear sample the way D2D does, cubic and Lanczos are stretched
+            // over more texels when downscaling so that every texel contributes.
+            static ResamplingTaps Build(
+                PlaneInterpolation interpolation, std::span<const float> centers, float texelsPerPixel, int32_t minTexel, int32_t maxTexel)
+            {
+                ResamplingTaps taps;
+                taps.Offsets.reserve(centers.size() + 1);
+
+                const auto addTap = [&](int64_t texel, float weight) {
+                    taps.Texels.push_back(static_cast<int32_t>(std::clamp<int64_t>(texel, minTexel, maxTexel)));
+                    taps.Weights.push_back(weight);
+                };
+
+                const double filterScale = (std::max)(1.0, std::abs(static_cast<double>(texelsPerPixel)));
+                const double radius = (interpolation == PlaneInterpolation::Cubic ? 2.0 : 3.0) * filterScale;
+
+                std::vector<double> weights;
+                for (const float center : centers)
+                {
+                    taps.Offsets.push_back(static_cast<uint32_t>(taps.Texels.size()));
+                    if (!std::isfinite(center))
+                    {
+                        continue;
+                    }
+
+                    const float position = center - 0.5f;
+                    const float floorPosition = std::floor(position);
+                    const float fraction = position - floorPosition;
+
+                    if (interpolation == PlaneInterpolation::NearestNeighbor || (interpolation == PlaneInterpolation::Linear && fraction == 0.0f))
+                    {
+                        addTap(static_cast<int64_t>(interpolation == PlaneInterpolation::NearestNeighbor ? std::floor(center) : floorPosition), 1.0f);
+                        continue;
+                    }
+
+                    if (interpolation == PlaneInterpolation::Linear)
+                    {
+                        addTap(static_cast<int64_t>(floorPosition), 1.0f - fraction);
+                        addTap(static_cast<int64_t>(floorPosition) + 1, fraction);
+                        continue;
+                    }
+
+                    const int64_t first = static_cast<int64_t>(std::ceil(position - radius));
+                    const int64_t last = static_cast<int64_t>(std::floor(position + radius));
+
+                    weights.clear();
+                    double total = 0.0;
+                    for (int64_t texel = first; texel <= last; texel++)
+                    {
+                        const double distance = (static_cast<double>(texel) - position) / filterScale;
+                        weights.push_back(interpolation == PlaneInterpolation::Cubic ? CubicKernel(distance) : Lanczos3Kernel(distance));
+                        total += weights.back();
+                    }
+
+                    // Normalized, so flat areas stay exactly flat
+                    for (int64_t texel = first; texel <= last; texel++)
+                    {
+                        addTap(texel, static_cast<float>(weights[texel - first] / total));
+                    }
+                }
+
+                taps.Offsets.push_back(static_cast<uint32_t>(taps.Texels.size()));
+                return taps;
+            }
+        };
+
+        // Source-over with premultiplied alpha, blends count source pixels onto as many destination pixels
+        inline void BlendRowOver(LinearPixel* destination, const LinearPixel* source, size_t count)
+        {
+#if defined(_M_X64) || defined(__x86_64__)
+            const __m128 one = _mm_set1_ps(1.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                const __m128 sourcePixel = _mm_loadu_ps(&source[i].R);
+                const __m128 inverseAlpha = _mm_sub_ps(one, _mm_shuffle_ps(sourcePixel, sourcePixel, _MM_SHUFFLE(3, 3, 3, 3)));
+                _mm_storeu_ps(&destination[i].R, _mm_add_ps(sourcePixel, _mm_mul_ps(_mm_loadu_ps(&destination[i].R), inverseAlpha)));
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                const float32x4_t sourcePixel = vld1q_f32(&source[i].R);
+                const float32x4_t inverseAlpha = vsubq_f32(one, vdupq_laneq_f32(sourcePixel, 3));
+                vst1q_f32(&destination[i].R, vaddq_f32(sourcePixel, vmulq_f32(vld1q_f32(&destination[i].R), inverseAlpha)));
+            }
+#else
+            for (size_t i = 0; i < count; i++)
+            {
+                const float inverseAlpha = 1.0f - source[i].A;
+                destination[i].R = source[i].R + destination[i].R * inverseAlpha;
+                destination[i].G = source[i].G + destination[i].G * inverseAlpha;
+                destination[i].B = source[i].B + destination[i].B * inverseAlpha;
+                destination[i].A = source[i].A + destination[i].A * inverseAlpha;
+            }
+#endif
+        }
+
+        //
+        // A plane prepared for rendering, with everything that doesn't depend on the target pixel resolved up front.
+        //
+        class PreparedPlane
+        {
+        public:
+            PreparedPlane(const CpuPlane& plane, uint32_t width, uint32_t height) :
+                m_surface(plane.Surface),
+                m_alphaMode(plane.AlphaMode),
+                m_degammaCurve(plane.DegammaCurve),
+                m_destination(plane.DestinationRect),
+                m_source(plane.SourceRect),
+                m_interpolation(plane.Interpolation),
+                m_clip(plane.ClipRect)
+            {
+                const float destinationWidth = m_destination.Right - m_destination.Left;
+                const float destinationHeight = m_destination.Bottom - m_destination.Top;
+
+                m_visible = m_surface && m_surface->Width() != 0 && m_surface->Height() != 0 && plane.Transform.Determinant() != 0.0f &&
+                            destinationWidth > 0.0f && destinationHeight > 0.0f && m_source.Right > m_source.Left &&
+                            m_source.Bottom > m_source.Top;
+
+                if (!m_visible)
+                {
+                    return;
+                }
+
+                m_targetToPlane = plane.Transform.Inverse();
+                m_scaleX = (m_source.Right - m_source.Left) / destinationWidth;
+                m_scaleY = (m_source.Bottom - m_source.Top) / destinationHeight;
+                m_axisAligned = m_targetToPlane.M12 == 0.0f && m_targetToPlane.M21 == 0.0f;
+                m_unitStep = m_axisAligned && m_targetToPlane.M11 * m_scaleX == 1.0f;
+
+                // Texels outside of both the source rectangle and the surface are never sampled
+                m_minTexelX = static_cast<int32_t>((std::max)(std::floor(m_source.Left), 0.0f));
+                m_minTexelY = static_cast<int32_t>((std::max)(std::floor(m_source.Top), 0.0f));
+                m_maxTexelX = static_cast<int32_t>((std::min)(std::ceil(m_source.Right), static_cast<float>(m_surface->Width()))) - 1;
+                m_maxTexelY = static_cast<int32_t>((std::min)(std::ceil(m_source.Bottom), static_cast<float>(m_surface->Height()))) - 1;
+                m_visible = m_minTexelX <= m_maxTexelX && m_minTexelY <= m_maxTexelY;
+                if (!m_visible)
+                {
+                    return;
+                }
+
+                // Scaled axis aligned planes are resampled separably, the sample position of a target column only
+                // depends on x and that of a target row only on y
+                m_resampled = m_axisAligned && !(m_unitStep && m_targetToPlane.M22 * m_scaleY == 1.0f);
+                if (m_resampled)
+                {
+                    // Computed exactly as ComposeRow steps through the row, so the covered span and the taps agree
+                    const float rowX = 0.5f * m_targetToPlane.M11 + m_targetToPlane.M31;
+                    std::vector<float> centers(width);
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        centers[x] = SourceX(rowX + static_cast<float>(x) * m_targetToPlane.M11);
+                    }
+                    m_columnTaps = ResamplingTaps::Build(m_interpolation, centers, m_targetToPlane.M11 * m_scaleX, m_minTexelX, m_maxTexelX);
+
+                    centers.resize(height);
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        centers[y] = SourceY((static_cast<float>(y) + 0.5f) * m_targetToPlane.M22 + m_targetToPlane.M32);
+                    }
+                    m_rowTaps = ResamplingTaps::Build(m_interpolation, centers, m_targetToPlane.M22 * m_scaleY, m_minTexelY, m_maxTexelY);
+                }
+
+                // 8 bit planes only have 256 possible values per channel, so degamma them once up front
+                if (m_surface->Format() == PlanePixelFormat::R8G8B8A8UIntNormalized)
+                {
+                    for (uint32_t code = 0; code < 256; code++)
+                    {
+                        m_degamma8[code] = ApplyDiscreteCurve(m_degammaCurve, static_cast<float>(code) / 255.0f);
+                    }
+                }
+            }
+
+            // Composes this plane over pixels [left, right) of the premultiplied linear row [0, width) of target row y
+            void ComposeRow(uint32_t y, uint32_t width, uint32_t left, uint32_t right, LinearPixel* row, ResamplingScratch& scratch) const
+            {
+                if (!m_visible)
+                {
+                    return;
+                }
+
+                // Pixel centers step linearly through the plane's space along the row
+                const float centerY = static_cast<float>(y) + 0.5f;
+                const float rowX = 0.5f * m_targetToPlane.M11 + centerY * m_targetToPlane.M21 + m_targetToPlane.M31;
+                const float rowY = 0.5f * m_targetToPlane.M12 + centerY * m_targetToPlane.M22 + m_targetToPlane.M32;
+
+                if (!ClipRow(y, width, left, right))
+                {
+                    return;
+                }
+
+                uint32_t firstX = left;
+                uint32_t lastX = right;
+                if (m_axisAligned)
+                {
+                    if (!(rowY >= m_destination.Top && rowY < m_destination.Bottom))
+                    {
+                        return;
+                    }
+
+                    CoveredSpan(rowX, rowY, width, firstX, lastX);
+                    if (firstX >= lastX)
+                    {
+                        return;
+                    }
+
+                    // The run is found from the start of the covered span whatever part of it is composed, so that
+                    // every part of a row lands on the same texels as the whole row would
+                    int32_t texelX = 0, texelY = 0;
+                    const bool texelRun = TexelRun(rowX, rowY, firstX, texelX, texelY);
+
+                    const uint32_t spanFirstX = firstX;
+                    firstX = (std::max)(firstX, left);
+                    lastX = (std::min)(lastX, right);
+                    if (firstX >= lastX)
+                    {
+                        return;
+                    }
+
+                    if (texelRun)
+                    {
+                        ComposeTexelRun(texelX + static_cast<int32_t>(firstX - spanFirstX), texelY, row + firstX, lastX - firstX);
+                        return;
+                    }
+
+                    if (m_resampled)
+                    {
+                        ComposeResampledRun(y, firstX, lastX, row, scratch);
+                        return;
+                    }
+                }
+
+                // Samples are blended a run of covered pixels at a time
+                LinearPixel samples[BlendRunSize];
+                uint32_t runStart = firstX;
+                uint32_t runLength = 0;
+                const auto blendRun = [&] {
+                    BlendRowOver(row + runStart, samples, runLength);
+                    runLength = 0;
+                };
+
+                for (uint32_t x = firstX; x < lastX; x++)
+                {
+                    const float planeX = rowX + static_cast<float>(x) * m_targetToPlane.M11;
+                    const float planeY = rowY + static_cast<float>(x) * m_targetToPlane.M12;
+                    if (!InDestination(planeX, planeY))
+                    {
+                        blendRun();
+                        continue;
+                    }
+
+                    const float sourceX = SourceX(planeX);
+                    const float sourceY = SourceY(planeY);
+
+                    if (runLength == 0)
+                    {
+                        runStart = x;
+                    }
+
+                    // Rotated planes are sampled bilinearly with the wider kernels too
+                    samples[runLength++] = m_interpolation == PlaneInterpolation::NearestNeighbor ? SampleNearest(sourceX, sourceY)
+                                                                                                  : SampleLinear(sourceX, sourceY);
+                    if (runLength == BlendRunSize)
+                    {
+                        blendRun();
+                    }
+                }
+
+                blendRun();
+            }
+
+            // Finds which of the surface's bands of identical rows each target row is composed from, or -1 where the
+            // plane doesn't cover the row. Rows with the same band compose identically. Returns false when rows are
+            // filtered rather than composed texel for texel, or the surface doesn't describe its rows.
+            bool ComposedRowBands(uint32_t width, uint32_t height, std::vector<int64_t>& bands) const
+            {
+                bands.assign(height, -1);
+                if (!m_visible)
+                {
+                    return true;
+                }
+
+                if (!m_axisAligned || !m_surface->HasRowBands())
+                {
+                    return false;
+                }
+
+                // Axis aligned rows all start at the same point across, so every covered row covers the same pixels
+                uint32_t firstX = 0, lastX = 0;
+                bool spanFound = false;
+
+                for (uint32_t y = 0; y < height; y++)
+                {
+                    const float centerY = static_cast<float>(y) + 0.5f;
+                    const float rowX = 0.5f * m_targetToPlane.M11 + centerY * m_targetToPlane.M21 + m_targetToPlane.M31;
+                    const float rowY = 0.5f * m_targetToPlane.M12 + centerY * m_targetToPlane.M22 + m_targetToPlane.M32;
+                    uint32_t clipLeft = 0, clipRight = width;
+                    if (!(rowY >= m_destination.Top && rowY < m_destination.Bottom) || !ClipRow(y, width, clipLeft, clipRight))
+                    {
+                        continue;
+                    }
+
+                    if (!spanFound)
+                    {
+                        CoveredSpan(rowX, rowY, width, firstX, lastX);
+                        spanFound = true;
+                    }
+
+                    // The clip takes the same columns out of every row
+                    if ((std::max)(firstX, clipLeft) >= (std::min)(lastX, clipRight))
+                    {
+                        bands.assign(height, -1);
+                        return true;
+                    }
+
+                    int32_t texelX = 0, texelY = 0;
+                    if (!TexelRun(rowX, rowY, firstX, texelX, texelY))
+                    {
+                        return false;
+                    }
+
+                    bands[y] = m_surface->RowBand(static_cast<uint32_t>(std::clamp(texelY, m_minTexelY, m_maxTexelY)));
+                }
+
+                return true;
+            }
+
+        private:
+            // Narrows [left, right) of row y down to the pixels inside the clip, returns false when none of the row is
+            bool ClipRow(uint32_t y, uint32_t width, uint32_t& left, uint32_t& right) const
+            {
+                if (!m_clip)
+                {
+                    return left < right;
+                }
+
+                const float centerY = static_cast<float>(y) + 0.5f;
+                if (!(centerY >= m_clip->Top && centerY < m_clip->Bottom))
+                {
+                    return false;
+                }
+
+                // The first pixel whose center is at or past edge
+                const auto column = [width](float edge) {
+                    return static_cast<uint32_t>(std::clamp(std::ceil(edge - 0.5f), 0.0f, static_cast<float>(width)));
+                };
+
+                left = (std::max)(left, column(m_clip->Left));
+                right = (std::min)(right, column(m_clip->Right));
+                return left < right;
+            }
+
+            // When the pixel centers of an axis aligned row land on texel centers one texel apart there is nothing to
+            // filter, the texels starting at (texelX, texelY) are composed as they are
+            bool TexelRun(float rowX, float rowY, uint32_t firstX, int32_t& texelX, int32_t& texelY) const
+            {
+                const float sourceX = SourceX(rowX + static_cast<float>(firstX) * m_targetToPlane.M11);
+                const float sourceY = SourceY(rowY);
+                if (!m_unitStep || sourceX - std::floor(sourceX) != 0.5f || sourceY - std::floor(sourceY) != 0.5f)
+                {
+                    return false;
+                }
+
+                texelX = static_cast<int32_t>(std::floor(sourceX));
+                texelY = static_cast<int32_t>(std::floor(sourceY));
+                return true;
+            }
+
+            bool InDestination(float planeX, float planeY) const
+            {
+                return planeX >= m_destination.Left && planeX < m_destination.Right && planeY >= m_destination.Top &&
+                       planeY < m_destination.Bottom;
+            }
+
+            float SourceX(float planeX) const
+            {
+                return m_source.Left + (planeX - m_destination.Left) * m_scaleX;
+            }
+
+            float SourceY(float planeY) const
+            {
+                return m_source.Top + (planeY - m_destination.Top) * m_scaleY;
+            }
+
+            // For axis aligned planes, finds the pixels [firstX, lastX) of a row whose centers fall inside the destination
+            // rectangle. The estimate is corrected against the per-pixel test so both always agree.
+            void CoveredSpan(float rowX, float rowY, uint32_t width, uint32_t& firstX, uint32_t& lastX) const
+            {
+                const float step = m_targetToPlane.M11;
+                const float leftX = (m_destination.Left - rowX) / step;
+                const float rightX = (m_destination.Right - rowX) / step;
+                const float estimate = std::clamp(std::ceil((std::min)(leftX, rightX)), 0.0f, static_cast<float>(width));
+
+                const auto covered = [&](uint32_t x) {
+                    return InDestination(rowX + static_cast<float>(x) * step, rowY);
+                };
+
+                firstX = static_cast<uint32_t>(estimate);
+                while (firstX > 0 && covered(firstX - 1))
+                {
+                    firstX--;
+                }
+
+                while (firstX < width && !covered(firstX))
+                {
+                    firstX++;
+                }
+
+                lastX = firstX;
+                while (lastX < width && covered(lastX))
+                {
+                    lastX++;
+                }
+            }
+
+            // Composes pixels [firstX, lastX) of target row y from the resampling tables
+            void ComposeResampledRun(uint32_t y, uint32_t firstX, uint32_t lastX, LinearPixel* row, ResamplingScratch& scratch) const
+            {
+                // Rows and columns whose sample position isn't a number have no taps and draw nothing
+                const auto columnTexelsBegin = m_columnTaps.Texels.begin() + m_columnTaps.Offsets[firstX];
+                const auto columnTexelsEnd = m_columnTaps.Texels.begin() + m_columnTaps.Offsets[lastX];
+                if (m_rowTaps.Offsets[y] == m_rowTaps.Offsets[y + 1] || columnTexelsBegin == columnTexelsEnd)
+                {
+                    return;
+                }
+
+                const auto [firstTexelTap, lastTexelTap] = std::minmax_element(columnTexelsBegin, columnTexelsEnd);
+                const int32_t firstTexel = *firstTexelTap;
+                const size_t texelCount = static_cast<size_t>(*lastTexelTap - firstTexel) + 1;
+
+                // Down first, the texel rows are weighted into a single row of texels
+                auto& texels = scratch.Texels;
+                auto& weighted = scratch.Weighted;
+                texels.resize(texelCount);
+                weighted.assign(texelCount, LinearPixel{0.0f, 0.0f, 0.0f, 0.0f});
+                for (uint32_t tap = m_rowTaps.Offsets[y]; tap < m_rowTaps.Offsets[y + 1]; tap++)
+                {
+                    for (size_t i = 0; i < texelCount; i++)
+                    {
+                        texels[i] = Texel(firstTexel + static_cast<int32_t>(i), m_rowTaps.Texels[tap]);
+                    }
+
+                    AddWeightedRow(weighted.data(), texels.data(), m_rowTaps.Weights[tap], texelCount);
+                }
+
+                // Then across, into runs of target pixels that are blended together. Texel t of the row is at t - firstTexel.
+                LinearPixel samples[BlendRunSize];
+                for (uint32_t runStart = firstX; runStart < lastX; runStart += BlendRunSize)
+                {
+                    const uint32_t runLength = (std::min)(lastX - runStart, BlendRunSize);
+                    for (uint32_t i = 0; i < runLength; i++)
+                    {
+                        const uint32_t first = m_columnTaps.Offsets[runStart + i];
+                        const uint32_t count = m_columnTaps.Offsets[runStart + i + 1] - first;
+                        samples[i] = WeightedSum(
+                            weighted.data(), firstTexel, m_columnTaps.Texels.data() + first, m_columnTaps.Weights.data() + first, count);
+                    }
+
+                    BlendRowOver(row + runStart, samples, runLength);
+                }
+            }
+
+            // Composes count texels of one texel row, starting at (texelX, texelY), onto consecutive pixels
+            void ComposeTexelRun(int32_t texelX, int32_t texelY, LinearPixel* row, uint32_t count) const
+            {
+                LinearPixel texels[BlendRunSize];
+                const uint8_t* texelRow = m_surface->Row(static_cast<uint32_t>(std::clamp(texelY, m_minTexelY, m_maxTexelY)));
+
+                for (uint32_t runStart = 0; runStart < count; runStart += BlendRunSize)
+                {
+                    const uint32_t runLength = (std::min)(count - runStart, BlendRunSize);
+                    for (uint32_t i = 0; i < runLength; i++)
+                    {
+                        const int32_t x = texelX + static_cast<int32_t>(runStart + i);
+                        if (m_surface->Format() != PlanePixelFormat::R8G8B8A8UIntNormalized)
+                        {
+                            texels[i] = Texel(x, texelY);
+                            continue;
+                        }
+
+                        const uint8_t* pixel = texelRow + static_cast<size_t>(std::clamp(x, m_minTexelX, m_maxTexelX)) * 4;
+
+                        // Partially transparent premultiplied texels have to be divided out before degamma
+                        if (m_alphaMode == PlaneAlphaMode::Premultiplied && pixel[3] != 255)
+                        {
+                            texels[i] = Texel(x, texelY);
+                            continue;
+                        }
+
+                        const float alpha = m_alphaMode == PlaneAlphaMode::Ignore ? 1.0f : static_cast<float>(pixel[3]) / 255.0f;
+                        texels[i] = {m_degamma8[pixel[0]] * alpha, m_degamma8[pixel[1]] * alpha, m_degamma8[pixel[2]] * alpha, alpha};
+                    }
+
+                    BlendRowOver(row + runStart, texels, runLength);
+                }
+            }
+
+            // Reads a texel and converts it to premultiplied linear, degamma applies to the straight alpha color
+            LinearPixel Texel(int32_t x, int32_t y) const
+            {
+                x = std::clamp(x, m_minTexelX, m_maxTexelX);
+                y = std::clamp(y, m_minTexelY, m_maxTexelY);
+
+                const uint8_t* pixel = m_surface->Row(static_cast<uint32_t>(y)) + static_cast<size_t>(x) * BytesPerPixel(m_surface->Format());
+
+                LinearPixel texel;
+                if (m_surface->Format() == PlanePixelFormat::R8G8B8A8UIntNormalized)
+                {
+                    texel.A = m_alphaMode == PlaneAlphaMode::Ignore ? 1.0f : static_cast<float>(pixel[3]) / 255.0f;
+
+                    if (m_alphaMode != PlaneAlphaMode::Premultiplied || pixel[3] == 255)
+                    {
+                        texel.R = m_degamma8[pixel[0]];
+                        texel.G = m_degamma8[pixel[1]];
+                        texel.B = m_degamma8[pixel[2]];
+                        return Premultiply(texel);
+                    }
+
+                    if (pixel[3] == 0)
+                    {
+                        return {0.0f, 0.0f, 0.0f, 0.0f};
+                    }
+
+                    texel.R = static_cast<float>(pixel[0]) / 255.0f;
+                    texel.G = static_cast<float>(pixel[1]) / 255.0f;
+                    texel.B = static_cast<float>(pixel[2]) / 255.0f;
+                }
+                else
+                {
+                    uint16_t channels[4];
+                    std::memcpy(channels, pixel, sizeof(channels));
+
+                    texel.R = MicrosoftDisplayCaptureTools::Libraries::HalfFloat::ToFloat(channels[0]);
+                    texel.G = MicrosoftDisplayCaptureTools::Libraries::HalfFloat::ToFloat(channels[1]);
+                    texel.B = MicrosoftDisplayCaptureTools::Libraries::HalfFloat::ToFloat(channels[2]);
+                    texel.A = m_alphaMode == PlaneAlphaMode::Ignore ? 1.0f : MicrosoftDisplayCaptureTools::Libraries::HalfFloat::ToFloat(channels[3]);
+
+                    if (m_alphaMode != PlaneAlphaMode::Premultiplied || texel.A == 1.0f)
+                    {
+                        texel.R = ApplyDiscreteCurve(m_degammaCurve, texel.R);
+                        texel.G = ApplyDiscreteCurve(m_degammaCurve, texel.G);
+                        texel.B = ApplyDiscreteCurve(m_degammaCurve, texel.B);
+                        return Premultiply(texel);
+                    }
+
+                    if (!(texel.A > 0.0f))
+                    {
+                        return {0.0f, 0.0f, 0.0f, 0.0f};
+                    }
+                }
+
+                // Premultiplied, partially transparent texel
+                texel.R = ApplyDiscreteCurve(m_degammaCurve, texel.R / texel.A);
+                texel.G = ApplyDiscreteCurve(m_degammaCurve, texel.G / texel.A);
+                texel.B = ApplyDiscreteCurve(m_degammaCurve, texel.B / texel.A);
+                return Premultiply(texel);
+            }
+
+            static LinearPixel Premultiply(LinearPixel texel)
+            {
+                texel.R *= texel.A;
+                texel.G *= texel.A;
+                texel.B *= texel.A;
+                return texel;
+            }
+
+            LinearPixel SampleNearest(float sourceX, float sourceY) const
+            {
+                return Texel(static_cast<int32_t>(std::floor(sourceX)), static_cast<int32_t>(std::floor(sourceY)));
+            }
+
+            // Bilinear filtering in premultiplied linear space, edges are clamped to the source rectangle
+            LinearPixel SampleLinear(float sourceX, float sourceY) const
+            {
+                const float u = sourceX - 0.5f;
+                const float v = sourceY - 0.5f;
+                const float floorU = std::floor(u);
+                const float floorV = std::floor(v);
+                const float fractionU = u - floorU;
+                const float fractionV = v - floorV;
+                const int32_t x0 = static_cast<int32_t>(floorU);
+                const int32_t y0 = static_cast<int32_t>(floorV);
+
+                const LinearPixel t00 = Texel(x0, y0);
+                if (fractionU == 0.0f && fractionV == 0.0f)
+                {
+                    return t00;
+                }
+
+                const LinearPixel t10 = Texel(x0 + 1, y0);
+                const LinearPixel t01 = Texel(x0, y0 + 1);
+                const LinearPixel t11 = Texel(x0 + 1, y0 + 1);
+
+                const float w00 = (1.0f - fractionU) * (1.0f - fractionV);
+                const float w10 = fractionU * (1.0f - fractionV);
+                const float w01 = (1.0f - fractionU) * fractionV;
+                const float w11 = fractionU * fractionV;
+
+                return {
+                    t00.R * w00 + t10.R * w10 + t01.R * w01 + t11.R * w11,
+                    t00.G * w00 + t10.G * w10 + t01.G * w01 + t11.G * w11,
+                    t00.B * w00 + t10.B * w10 + t01.B * w01 + t11.B * w11,
+                    t00.A * w00 + t10.A * w10 + t01.A * w01 + t11.A * w11};
+            }
+
+            std::shared_ptr<const PlaneSurface> m_surface;
+            PlaneAlphaMode m_alphaMode;
+            std::vector<float> m_degammaCurve;
+            std::array<float, 256> m_degamma8{};
+
+            PlaneRect m_destination;
+            PlaneRect m_source;
+            PlaneInterpolation m_interpolation;
+            std::optional<PlaneRect> m_clip;
+
+            bool m_visible = false;
+            bool m_axisAligned = false;
+            bool m_unitStep = false;
+            bool m_resampled = false;
+            ResamplingTaps m_columnTaps;
+            ResamplingTaps m_rowTaps;
+            AffineTransform m_targetToPlane;
+            float m_scaleX = 1.0f;
+            float m_scaleY = 1.0f;
+            int32_t m_minTexelX = 0, m_minTexelY = 0, m_maxTexelX = -1, m_maxTexelY = -1;
+        };
+
+        // The texels that differ between two surfaces of the same format and size, nothing if they're identical
+        inline std::optional<PixelRect> ChangedTexels(const PlaneSurface& previous, const PlaneSurface& current)
+        {
+            const size_t bytesPerPixel = BytesPerPixel(current.Format());
+            const size_t rowBytes = static_cast<size_t>(current.Width()) * bytesPerPixel;
+
+            PixelRect changed{current.Width(), current.Height(), 0, 0};
+            for (uint32_t y = 0; y < current.Height(); y++)
+            {
+                const uint8_t* before = previous.Row(y);
+                const uint8_t* after = current.Row(y);
+                if (std::memcmp(before, after, rowBytes) == 0)
+                {
+                    continue;
+                }
+
+                size_t first = 0, last = rowBytes;
+                while (before[first] == after[first])
+                {
+                    first++;
+                }
+
+                while (before[last - 1] == after[last - 1])
+                {
+                    last--;
+                }
+
+                changed.Left = (std::min)(changed.Left, static_cast<uint32_t>(first / bytesPerPixel));
+                changed.Right = (std::max)(changed.Right, static_cast<uint32_t>((last + bytesPerPixel - 1) / bytesPerPixel));
+                changed.Top = (std::min)(changed.Top, y);
+                changed.Bottom = y + 1;
+            }
+
+            if (changed.Top >= changed.Bottom)
+            {
+                return std::nullopt;
+            }
+
+            return changed;
+        }
+
+        // The target pixels a plane can draw to, or just those the texels in sourceTexels can reach when given. Filtering
+        // reaches one texel further, and texels on the edge of what can be sampled are repeated out to the destination's
+        // edge. Generous by a pixel all around, so rounding never leaves a pixel out.
+        inline std::optional<PixelRect> PlaneTargetBounds(
+            const CpuPlane& plane, uint32_t width, uint32_t height, const std::optional<PixelRect>& sourceTexels = std::nullopt)
+        {
+            const PlaneRect& destination = plane.DestinationRect;
+            const PlaneRect& source = plane.SourceRect;
+            if (!plane.Surface || !(destination.Right > destination.Left && destination.Bottom > destination.Top) ||
+                !(source.Right > source.Left && source.Bottom > source.Top))
+            {
+                return std::nullopt;
+            }
+
+            PlaneRect region = destination;
+            if (sourceTexels)
+            {
+                const float minTexelX = (std::max)(std::floor(source.Left), 0.0f);
+                const float minTexelY = (std::max)(std::floor(source.Top), 0.0f);
+                const float maxTexelX = (std::min)(std::ceil(source.Right), static_cast<float>(plane.Surface->Width())) - 1.0f;
+                const float maxTexelY = (std::min)(std::ceil(source.Bottom), static_cast<float>(plane.Surface->Height())) - 1.0f;
+
+                const float planeFromSourceX = (destination.Right - destination.Left) / (source.Right - source.Left);
+                const float planeFromSourceY = (destination.Bottom - destination.Top) / (source.Bottom - source.Top);
+                const auto planeX = [&](float sourceX) { return destination.Left + (sourceX - source.Left) * planeFromSourceX; };
+                const auto planeY = [&](float sourceY) { return destination.Top + (sourceY - source.Top) * planeFromSourceY; };
+
+                // How many texels away a changed texel can still be sampled from, wider kernels reach further and are
+                // stretched over more texels when the plane is scaled down
+                float reachX = 1.0f, reachY = 1.0f;
+                if (plane.Interpolation == PlaneInterpolation::Cubic || plane.Interpolation == PlaneInterpolation::Lanczos3)
+                {
+                    const AffineTransform targetToPlane = plane.Transform.Inverse();
+                    const float radius = plane.Interpolation == PlaneInterpolation::Cubic ? 2.0f : 3.0f;
+                    if (targetToPlane.M12 == 0.0f && targetToPlane.M21 == 0.0f)
+                    {
+                        reachX = std::ceil(radius * (std::max)(1.0f, std::abs(targetToPlane.M11 / planeFromSourceX)));
+                        reachY = std::ceil(radius * (std::max)(1.0f, std::abs(targetToPlane.M22 / planeFromSourceY)));
+                    }
+                }
+
+                const float left = static_cast<float>(sourceTexels->Left);
+                const float top = static_cast<float>(sourceTexels->Top);
+                const float right = static_cast<float>(sourceTexels->Right);
+                const float bottom = static_cast<float>(sourceTexels->Bottom);
+
+                if (left > minTexelX)
+                {
+                    region.Left = (std::max)(region.Left, planeX(left - reachX));
+                }
+                if (top > minTexelY)
+                {
+                    region.Top = (std::max)(region.Top, planeY(top - reachY));
+                }
+                if (right - 1.0f < maxTexelX)
+                {
+                    region.Right = (std::min)(region.Right, planeX(right + reachX));
+                }
+                if (bottom - 1.0f < maxTexelY)
+                {
+                    region.Bottom = (std::min)(region.Bottom, planeY(bottom + reachY));
+                }
+
+                // Only texels that are never sampled changed
+                if (!(region.Right > region.Left && region.Bottom > region.Top))
+                {
+                    return std::nullopt;
+                }
+            }
+
+            const AffineTransform& m = plane.Transform;
+            float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+            for (const auto& [x, y] : {std::pair{region.Left, region.Top},
+                                       std::pair{region.Right, region.Top},
+                                       std::pair{region.Left, region.Bottom},
+                                       std::pair{region.Right, region.Bottom}})
+            {
+                const float targetX = x * m.M11 + y * m.M21 + m.M31;
+                const float targetY = x * m.M12 + y * m.M22 + m.M32;
+                minX = (std::min)(minX, targetX);
+                minY = (std::min)(minY, targetY);
+                maxX = (std::max)(maxX, targetX);
+                maxY = (std::max)(maxY, targetY);
+            }
+
+            // Bounds that aren't numbers cover everything
+            const auto clampToFrame = [](float value, uint32_t size, float otherwise) {
+                return std::isnan(value) ? otherwise : std::clamp(value, 0.0f, static_cast<float>(size));
+            };
+
+            if (plane.ClipRect)
+            {
+                minX = (std::max)(minX, plane.ClipRect->Left);
+                minY = (std::max)(minY, plane.ClipRect->Top);
+                maxX = (std::min)(maxX, plane.ClipRect->Right);
+                maxY = (std::min)(maxY, plane.ClipRect->Bottom);
+            }
+
+            const PixelRect bounds{
+                static_cast<uint32_t>(clampToFrame(std::floor(minX) - 1.0f, width, 0.0f)),
+                static_cast<uint32_t>(clampToFrame(std::floor(minY) - 1.0f, height, 0.0f)),
+                static_cast<uint32_t>(clampToFrame(std::ceil(maxX) + 1.0f, width, static_cast<float>(width))),
+                static_cast<uint32_t>(clampToFrame(std::ceil(maxY) + 1.0f, height, static_cast<float>(height)))};
+
+            if (bounds.Left >= bounds.Right || bounds.Top >= bounds.Bottom)
+            {
+                return std::nullopt;
+            }
+
+            return bounds;
+        }
+
+    } // namespace Details
+
+    //
+    // Finds the target pixels that can differ between two frames from how their planes changed, planes are matched up
+    // by their position in the frame. A plane placed or sampled differently dirties wherever it was drawn before and is
+    // drawn now, a plane whose surface only changed in content dirties wherever the changed texels reach. Returns nothing
+    // when anything else differs, as then the whole frame has to be rendered.
+    //
+    inline std::optional<std::vector<PixelRect>> ChangedRegions(const CpuFrame& previous, const CpuFrame& current)
+    {
+        if (previous.Width != current.Width || previous.Height != current.Height || previous.FillBackground != current.FillBackground ||
+            previous.BackgroundColor != current.BackgroundColor || previous.Planes.size() != current.Planes.size() ||
+            previous.PostBlend != current.PostBlend || previous.Wire != current.Wire)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<PixelRect> changed;
+        const auto add = [&](const std::optional<PixelRect>& bounds) {
+            if (bounds)
+            {
+                changed.push_back(*bounds);
+            }
+        };
+
+        for (size_t i = 0; i < current.Planes.size(); i++)
+        {
+            const CpuPlane& before = previous.Planes[i];
+            const CpuPlane& after = current.Planes[i];
+
+            const bool sameLayout = before.Surface && after.Surface && before.Surface->Format() == after.Surface->Format() &&
+                                    before.Surface->Width() == after.Surface->Width() &&
+                                    before.Surface->Height() == after.Surface->Height();
+
+            const bool samePlacement = before.AlphaMode == after.AlphaMode && before.DegammaCurve == after.DegammaCurve &&
+                                       before.Transform == after.Transform && before.DestinationRect == after.DestinationRect &&
+                                       before.SourceRect == after.SourceRect && before.Interpolation == after.Interpolation &&
+                                       before.ClipRect == after.ClipRect;
+
+            if (!sameLayout || !samePlacement)
+            {
+                add(Details::PlaneTargetBounds(before, previous.Width, previous.Height));
+                add(Details::PlaneTargetBounds(after, current.Width, current.Height));
+                continue;
+            }
+
+            if (before.Surface == after.Surface)
+            {
+                continue;
+            }
+
+            if (const auto texels = Details::ChangedTexels(*before.Surface, *after.Surface))
+            {
+                add(Details::PlaneTargetBounds(after, current.Width, current.Height, texels));
+            }
+        }
+
+        return changed;
+    }
+
+    class CpuPredictionRenderer
+    {
+    public:
+        explicit CpuPredictionRenderer(const CpuFrame& frame) :
+            m_width(frame.Width),
+            m_height(frame.Height),
+            m_fillBackground(frame.FillBackground),
+            m_backgroundColor(frame.BackgroundColor),
+            m_postBlend(frame.PostBlend)
+        {
+            if (frame.Wire)
+            {
+                m_wire.emplace(*frame.Wire);
+            }
+
+            m_planes.reserve(frame.Planes.size());
+            for (const auto& plane : frame.Planes)
+            {
+                m_planes.emplace_back(plane, m_width, m_height);
+            }
+        }
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        // Renders rows [firstRow, firstRow + rowCount) of the frame. The outputs are full frame sized buffers, scRgb
+        // receives R16G16B16A16_FLOAT pixels and rgba8 (which may be null) receives the sRGB 8bpc approximation. Rows can
+        // be rendered in any order and from multiple threads as long as the row ranges don't overlap.
+        void RenderRows(uint32_t firstRow, uint32_t rowCount, uint64_t* scRgb, uint32_t* rgba8) const
+        {
+            const uint32_t lastRow = (std::min)(firstRow + rowCount, m_height);
+            if (firstRow >= lastRow)
+            {
+                return;
+            }
+
+            const size_t offset = static_cast<size_t>(firstRow) * m_width;
+            RenderRowRange(firstRow, lastRow, 0, m_width, scRgb + offset, rgba8 ? rgba8 + offset : nullptr);
+        }
+
+        //
+        // Describes the frame as rectangles of constant color, without rendering it, when every plane is composed texel
+        // for texel (no scaling or filtering) from a surface that describes its bands of identical rows. Target rows then
+        // only change where a plane starts or ends or moves on to another band, so just the first row of each run of
+        // identical rows is rendered and split into runs of pixels. Returns nothing for frames that can't be described
+        // this way, or that would take more than maxRectangles rectangles.
+        //
+        std::optional<MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame> RenderAnalytic(size_t maxRectangles = 4096) const
+        {
+            using MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame;
+
+            if (m_width == 0 || m_height == 0)
+            {
+                return AnalyticFrame(m_width, m_height, 0, {});
+            }
+
+            // A row that shares chroma with the next one depends on more than its own bands
+            if (m_wire && m_wire->PairsRows())
+            {
+                return std::nullopt;
+            }
+
+            std::vector<Details::LinearPixel> rows(RowScratchSize());
+            std::vector<uint64_t> pixels(m_width);
+            ColorBlock blocks[2];
+            Details::ResamplingScratch resampling;
+
+            // The band each plane composes into each row
+            std::vector<std::vector<int64_t>> bands(m_planes.size());
+            for (size_t plane = 0; plane < m_planes.size(); plane++)
+            {
+                if (!m_planes[plane].ComposedRowBands(m_width, m_height, bands[plane]))
+                {
+                    return std::nullopt;
+                }
+            }
+
+            const auto sameRows = [&](uint32_t a, uint32_t b) {
+                return std::all_of(bands.begin(), bands.end(), [&](const std::vector<int64_t>& planeBands) {
+                    return planeBands[a] == planeBands[b];
+                });
+            };
+
+            std::vector<AnalyticFrame::Rectangle> rectangles;
+            uint64_t background = 0;
+            uint32_t runTop = 0;
+
+            // Adds the pixels of a run of identical rows that differ from the background
+            const auto addRun = [&](uint32_t runBottom) {
+                for (uint32_t left = 0; left < m_width;)
+                {
+                    uint32_t right = left + 1;
+                    while (right < m_width && pixels[right] == pixels[left])
+                    {
+                        right++;
+                    }
+
+                    if (pixels[left] != background)
+                    {
+                        rectangles.push_back({left, runTop, right, runBottom, pixels[left]});
+                    }
+
+                    left = right;
+                }
+            };
+
+            for (uint32_t y = 0; y < m_height; y++)
+            {
+                if (y != 0 && sameRows(runTop, y))
+                {
+                    continue;
+                }
+
+                if (y != 0)
+                {
+                    addRun(y);
+                    if (rectangles.size() > maxRectangles)
+                    {
+                        return std::nullopt;
+                    }
+                }
+
+                RenderRow(y, 0, m_width, rows.data(), blocks, resampling, pixels.data(), nullptr);
+                if (y == 0)
+                {
+                    background = pixels[0];
+                }
+
+                runTop = y;
+            }
+
+            addRun(m_height);
+            if (rectangles.size() > maxRectangles)
+            {
+                return std::nullopt;
+            }
+
+            return AnalyticFrame(m_width, m_height, background, std::move(rectangles));
+        }
+
+        // Renders the whole frame in bands of rows on the thread pool
+        void Render(uint64_t* scRgb, uint32_t* rgba8, MicrosoftDisplayCaptureTools::Libraries::ThreadPool& pool, uint32_t rowsPerBand = 16) const
+        {
+            rowsPerBand = (std::max)(rowsPerBand, 1u);
+            const uint32_t bandCount = (m_height + rowsPerBand - 1) / rowsPerBand;
+
+            pool.ParallelFor(bandCount, [&](uint32_t band) { RenderRows(band * rowsPerBand, rowsPerBand, scRgb, rgba8); });
+        }
+
+        // Renders the whole frame a row of tiles at a time on the thread pool, encoding each row of tiles as soon as it is
+        // done so that the uncompressed frame is never held in memory. No preview is made.
+        MicrosoftDisplayCaptureTools::Libraries::TiledFrame RenderTiled(MicrosoftDisplayCaptureTools::Libraries::ThreadPool& pool) const
+        {
+            using MicrosoftDisplayCaptureTools::Libraries::TiledFrame;
+
+            TiledFrame frame(m_width, m_height);
+            pool.ParallelFor(frame.TilesDown(), [&](uint32_t tileRow) {
+                const uint32_t firstRow = tileRow * TiledFrame::TileSize;
+                const uint32_t rowCount = (std::min)(TiledFrame::TileSize, m_height - firstRow);
+
+                std::vector<uint64_t> pixels(static_cast<size_t>(m_width) * rowCount);
+                RenderRowRange(firstRow, firstRow + rowCount, 0, m_width, pixels.data(), nullptr);
+
+                frame.SetTileRow(tileRow, pixels.data(), m_width);
+            });
+
+            return frame;
+        }
+
+        // Renders the frame on top of previous, a frame of the same size that only differs from this one inside the
+        // changed rectangles (see ChangedRegions). Only the tiles those touch are rendered, every other tile is shared
+        // with previous.
+        MicrosoftDisplayCaptureTools::Libraries::TiledFrame RenderTiled(
+            const MicrosoftDisplayCaptureTools::Libraries::TiledFrame& previous,
+            std::span<const PixelRect> changed,
+            MicrosoftDisplayCaptureTools::Libraries::ThreadPool& pool) const
+        {
+            using MicrosoftDisplayCaptureTools::Libraries::TiledFrame;
+
+            if (previous.Width() != m_width || previous.Height() != m_height)
+            {
+                return RenderTiled(pool);
+            }
+
+            TiledFrame frame(previous);
+
+            std::vector<uint8_t> dirty(static_cast<size_t>(frame.TilesAcross()) * frame.TilesDown());
+            for (const auto& rect : changed)
+            {
+                const uint32_t right = (std::min)(rect.Right, m_width);
+                const uint32_t bottom = (std::min)(rect.Bottom, m_height);
+                for (uint32_t tileY = rect.Top / TiledFrame::TileSize; rect.Top < bottom && tileY * TiledFrame::TileSize < bottom; tileY++)
+                {
+                    for (uint32_t tileX = rect.Left / TiledFrame::TileSize; rect.Left < right && tileX * TiledFrame::TileSize < right; tileX++)
+                    {
+                        dirty[static_cast<size_t>(tileY) * frame.TilesAcross() + tileX] = 1;
+                    }
+                }
+            }
+
+            pool.ParallelFor(frame.TilesDown(), [&](uint32_t tileRow) {
+                const uint8_t* dirtyTiles = dirty.data() + static_cast<size_t>(tileRow) * frame.TilesAcross();
+                if (std::find(dirtyTiles, dirtyTiles + frame.TilesAcross(), 1) == dirtyTiles + frame.TilesAcross())
+                {
+                    return;
+                }
+
+                const uint32_t firstRow = tileRow * TiledFrame::TileSize;
+                const uint32_t rowCount = (std::min)(TiledFrame::TileSize, m_height - firstRow);
+
+                std::vector<uint64_t> pixels(static_cast<size_t>(m_width) * rowCount);
+
+                // Runs of neighboring dirty tiles are rendered a row at a time
+                for (uint32_t firstTile = 0; firstTile < frame.TilesAcross();)
+                {
+                    if (!dirtyTiles[firstTile])
+                    {
+                        firstTile++;
+                        continue;
+                    }
+
+                    uint32_t lastTile = firstTile + 1;
+                    while (lastTile < frame.TilesAcross() && dirtyTiles[lastTile])
+                    {
+                        lastTile++;
+                    }
+
+                    const uint32_t left = firstTile * TiledFrame::TileSize;
+                    const uint32_t right = (std::min)(lastTile * TiledFrame::TileSize, m_width);
+                    RenderRowRange(firstRow, firstRow + rowCount, left, right, pixels.data(), nullptr);
+
+                    for (uint32_t tileX = firstTile; tileX < lastTile; tileX++)
+                    {
+                        frame.SetTile(tileX, tileRow, pixels.data() + static_cast<size_t>(tileX) * TiledFrame::TileSize, m_width);
+                    }
+
+                    firstTile = lastTile;
+                }
+            });
+
+            return frame;
+        }
+
+    private:
+        // The scratch space RenderRow needs for the composed planes, room for two rows when rows are paired
+        size_t RowScratchSize() const
+        {
+            return static_cast<size_t>(m_width) * (m_wire && m_wire->PairsRows() ? 2 : 1);
+        }
+
+        // Renders pixels [left, right) of rows [firstRow, lastRow), row y going to the row sized outputs at
+        // (y - firstRow) * width. Rows that share chroma are rendered together when both are in the range.
+        void RenderRowRange(uint32_t firstRow, uint32_t lastRow, uint32_t left, uint32_t right, uint64_t* scRgb, uint32_t* rgba8) const
+        {
+            std::vector<Details::LinearPixel> rows(RowScratchSize());
+            ColorBlock blocks[2];
+            Details::ResamplingScratch resampling;
+
+            const bool pairsRows = m_wire && m_wire->PairsRows();
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                const size_t offset = static_cast<size_t>(y - firstRow) * m_width;
+                const bool withNext = pairsRows && y % 2 == 0 && y + 1 < lastRow;
+
+                RenderRow(
+                    y,
+                    left,
+                    right,
+                    rows.data(),
+                    blocks,
+                    resampling,
+                    scRgb + offset,
+                    rgba8 ? rgba8 + offset : nullptr,
+                    withNext ? scRgb + offset + m_width : nullptr,
+                    withNext && rgba8 ? rgba8 + offset + m_width : nullptr);
+
+                if (withNext)
+                {
+                    y++;
+                }
+            }
+        }
+
+        // Renders pixels [left, right) of row y into the row sized outputs, rows is RowScratchSize() of scratch space for
+        // the composed planes and resampling that for scaled planes. When rows are paired the other row of the pair is rendered as well, and written to
+        // pairedScRgb and pairedRgba8 if those are given.
+        void RenderRow(
+            uint32_t y,
+            uint32_t left,
+            uint32_t right,
+            Details::LinearPixel* rows,
+            ColorBlock (&blocks)[2],
+            Details::ResamplingScratch& resampling,
+            uint64_t* scRgb,
+            uint32_t* rgba8,
+            uint64_t* pairedScRgb = nullptr,
+            uint32_t* pairedRgba8 = nullptr) const
+        {
+            // The background brush color has straight alpha
+            const float backgroundAlpha = m_fillBackground ? m_backgroundColor[3] : 0.0f;
+            const Details::LinearPixel background{
+                m_backgroundColor[0] * backgroundAlpha,
+                m_backgroundColor[1] * backgroundAlpha,
+                m_backgroundColor[2] * backgroundAlpha,
+                backgroundAlpha};
+
+            // Paired rows always go through the wire even row first, so both come out the same whichever was asked for
+            const bool pairsRows = m_wire && m_wire->PairsRows();
+            const uint32_t firstY = pairsRows ? y & ~1u : y;
+            const uint32_t rowCount = pairsRows && firstY + 1 < m_height ? 2 : 1;
+
+            uint64_t* scRgbRows[2] = {scRgb, pairedScRgb};
+            uint32_t* rgba8Rows[2] = {rgba8, pairedRgba8};
+            if (firstY != y)
+            {
+                std::swap(scRgbRows[0], scRgbRows[1]);
+                std::swap(rgba8Rows[0], rgba8Rows[1]);
+            }
+
+            for (uint32_t i = 0; i < rowCount; i++)
+            {
+                Details::LinearPixel* row = rows + static_cast<size_t>(i) * m_width;
+                std::fill(row + left, row + right, background);
+
+                for (const auto& plane : m_planes)
+                {
+                    plane.ComposeRow(firstY + i, m_width, left, right, row, resampling);
+                }
+            }
+
+            // The post-blend pipeline runs over blocks of the row. Its result is drawn over opaque black, which for
+            // premultiplied color just means replacing alpha with 1.
+            const auto& srgb8FromHalf = Details::Srgb8FromHalfTable();
+            for (uint32_t blockStart = left; blockStart < right; blockStart += ColorBlockSize)
+            {
+                const size_t count = (std::min)(static_cast<size_t>(right - blockStart), ColorBlockSize);
+
+                for (uint32_t i = 0; i < rowCount; i++)
+                {
+                    const Details::LinearPixel* pixels = rows + static_cast<size_t>(i) * m_width + blockStart;
+                    ColorBlock& block = blocks[i];
+
+                    for (size_t x = 0; x < count; x++)
+                    {
+                        block.R[x] = pixels[x].R;
+                        block.G[x] = pixels[x].G;
+                        block.B[x] = pixels[x].B;
+                        block.A[x] = pixels[x].A;
+                    }
+
+                    m_postBlend.ApplyPremultiplied(block, count);
+                }
+
+                if (m_wire)
+                {
+                    m_wire->Apply(blocks[0], rowCount == 2 ? &blocks[1] : nullptr, count);
+                }
+
+                for (uint32_t i = 0; i < rowCount; i++)
+                {
+                    if (!scRgbRows[i])
+                    {
+                        continue;
+                    }
+
+                    const ColorBlock& block = blocks[i];
+                    uint64_t* scRgbPixels = scRgbRows[i] + blockStart;
+                    for (size_t x = 0; x < count; x++)
+                    {
+                        scRgbPixels[x] = MicrosoftDisplayCaptureTools::Libraries::HalfFloat::PackRgba(block.R[x], block.G[x], block.B[x], 1.0f);
+                    }
+
+                    if (rgba8Rows[i])
+                    {
+                        uint32_t* previewPixels = rgba8Rows[i] + blockStart;
+                        for (size_t x = 0; x < count; x++)
+                        {
+                            previewPixels[x] = Details::Srgb8FromScRgb(srgb8FromHalf, scRgbPixels[x]);
+                        }
+                    }
+                }
+            }
+        }
+
+        const uint32_t m_width;
+        const uint32_t m_height;
+        const bool m_fillBackground;
+        const std::array<float, 4> m_backgroundColor;
+
+        const CompiledColorPipeline m_postBlend;
+        std::optional<CompiledWireFormatEmulation> m_wire;
+        std::vector<Details::PreparedPlane> m_planes;
+    };
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
@@ -0,0 +1,358 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+//
+// The pixel conversions of cursor shapes, on rows of 32 bit pixels with the mask or alpha in the top byte. A pixel with
+// alpha and a black color is transparent (the screen shows through it), one with alpha and any other color inverts the
+// screen (XOR). Only depends on the standard library, so the conversions can be checked without a device.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    namespace Details {
+
+        constexpr uint32_t CursorBlack = 0;
+        constexpr uint32_t CursorWhite = 0xFFFFFF;
+        constexpr uint32_t CursorAlpha = 0xFF000000;
+
+        //
+        // Sets every bit of a bitset to the OR of the bits in [bit, bit + window). The window is built up by doubling, so
+        // this takes O(log window) passes over the words rather than one per bit of the window.
+        //
+        inline void DilateForward(std::span<uint64_t> bits, size_t window)
+        {
+            // bits |= bits shifted down by shift, bit x taking bit x + shift. Going up through the words only reads words
+            // that haven't been written yet.
+            const auto orShiftedDown = [&](size_t shift) {
+                const size_t wordShift = shift / 64;
+                const size_t bitShift = shift % 64;
+                for (size_t word = 0; word < bits.size(); word++)
+                {
+                    const size_t source = word + wordShift;
+                    uint64_t shifted = source < bits.size() ? bits[source] >> bitShift : 0;
+                    if (bitShift != 0 && source + 1 < bits.size())
+                    {
+                        shifted |= bits[source + 1] << (64 - bitShift);
+                    }
+
+                    bits[word] |= shifted;
+                }
+            };
+
+            size_t covered = 1;
+            for (; covered * 2 <= window; covered *= 2)
+            {
+                orShiftedDown(covered);
+            }
+
+            if (covered < window)
+            {
+                orShiftedDown(window - covered);
+            }
+        }
+
+        //
+        // For each value of a byte of a 1bpp plane, a mask for each of the 8 pixels it covers that is all ones where the
+        // bit is set. The most significant bit is the leftmost pixel.
+        //
+        inline const std::array<std::array<uint32_t, 8>, 256>& BitExpansionTable()
+        {
+            static const auto table = [] {
+                std::array<std::array<uint32_t, 8>, 256> masks{};
+                for (size_t value = 0; value < masks.size(); value++)
+                {
+                    for (size_t bit = 0; bit < 8; bit++)
+                    {
+                        masks[value][bit] = (value & (0x80 >> bit)) ? 0xFFFFFFFF : 0;
+                    }
+                }
+                return masks;
+            }();
+
+            return table;
+        }
+
+    } // namespace Details
+
+    // The width of the white border drawn around a cursor of this width in place of its XOR pixels
+    inline uint32_t XorBorderSize(uint32_t width)
+    {
+        return (width + 47) / 48;
+    }
+
+    //
+    // Converts a cursor with XOR pixels to a black and white scheme, for sinks that don't support XOR. The output is
+    // XorBorderSize(width) larger on every side than the input.
+    //
+    // Every pixel that isn't transparent keeps its place (XOR pixels become black), and any transparent pixel within
+    // the border size of one of them, in both directions, becomes white. That border is the mask of non-transparent
+    // pixels dilated by a (2 * borderSize + 1) square, which is done as a row pass and then a column pass over bitsets.
+    //
+    inline void ConvertXorToBorder(const uint8_t* input, size_t inputPitch, uint32_t width, uint32_t height, uint8_t* output, size_t outputPitch)
+    {
+        using namespace Details;
+
+        const size_t borderSize = XorBorderSize(width);
+        const size_t window = borderSize * 2 + 1;
+        const size_t outputWidth = width + borderSize * 2;
+        const size_t outputHeight = height + borderSize * 2;
+
+        const auto inputRow = [&](size_t y) { return reinterpret_cast<const uint32_t*>(input + y * inputPitch); };
+        const auto isTransparent = [](uint32_t pixel) { return (pixel >> 24) && (pixel & CursorWhite) == CursorBlack; };
+
+        // The mask of non-transparent pixels, with input pixel (cx, cy) at bit cx + 2 * borderSize of row cy + 2 *
+        // borderSize. With that offset, a window starting at output pixel (x, y) covers the input pixels within borderSize
+        // of it.
+        const size_t maskWidth = width + borderSize * 4;
+        const size_t maskHeight = height + borderSize * 4;
+        const size_t wordsPerRow = (maskWidth + 63) / 64;
+        std::vector<uint64_t> mask(wordsPerRow * maskHeight, 0);
+        const auto maskRow = [&](size_t y) { return std::span<uint64_t>(mask.data() + y * wordsPerRow, wordsPerRow); };
+
+        for (size_t cy = 0; cy < height; ++cy)
+        {
+            const uint32_t* pixels = inputRow(cy);
+            auto row = maskRow(cy + borderSize * 2);
+            for (size_t cx = 0; cx < width; ++cx)
+            {
+                if (!isTransparent(pixels[cx]))
+                {
+                    const size_t bit = cx + borderSize * 2;
+                    row[bit / 64] |= uint64_t{1} << (bit % 64);
+                }
+            }
+
+            // Row pass
+            DilateForward(row, window);
+        }
+
+        // Column pass, the same doubling as the row pass with whole rows in place of bits. Going down through the rows
+        // only reads rows that haven't been written yet.
+        const auto orRowsBelow = [&](size_t offset) {
+            for (size_t y = 0; y + offset < maskHeight; y++)
+            {
+                auto row = maskRow(y);
+                const auto rowBelow = maskRow(y + offset);
+                for (size_t word = 0; word < wordsPerRow; word++)
+                {
+                    row[word] |= rowBelow[word];
+                }
+            }
+        };
+
+        size_t covered = 1;
+        for (; covered * 2 <= window; covered *= 2)
+        {
+            orRowsBelow(covered);
+        }
+
+        if (covered < window)
+        {
+            orRowsBelow(window - covered);
+        }
+
+        constexpr uint32_t transparent = CursorAlpha | CursorBlack;
+        constexpr uint32_t border = CursorWhite;
+
+        for (size_t y = 0; y < outputHeight; ++y)
+        {
+            auto outRow = reinterpret_cast<uint32_t*>(output + y * outputPitch);
+            const auto row = maskRow(y);
+
+            // Outline the pixels in white, whole words of the mask at a time where they are all set or all clear
+            for (size_t x = 0; x < outputWidth; x += 64)
+            {
+                const size_t count = (std::min)(size_t{64}, outputWidth - x);
+                const uint64_t bits = row[x / 64];
+                if (bits == 0 || bits == ~uint64_t{0})
+                {
+                    std::fill_n(outRow + x, count, bits ? border : transparent);
+                    continue;
+                }
+
+                for (size_t bit = 0; bit < count; bit++)
+                {
+                    outRow[x + bit] = (bits >> bit) & 1 ? border : transparent;
+                }
+            }
+
+            // Then place the pixels of the cursor itself
+            if (y < borderSize || y - borderSize >= height)
+            {
+                continue;
+            }
+
+            const uint32_t* pixels = inputRow(y - borderSize);
+            for (size_t cx = 0; cx < width; ++cx)
+            {
+                const uint32_t pixel = pixels[cx];
+                if (!isTransparent(pixel))
+                {
+                    // Inverted (XOR) pixels are set to black, the others have no alpha and are copied
+                    outRow[cx + borderSize] = (pixel >> 24) ? CursorBlack : pixel;
+                }
+            }
+        }
+    }
+
+    //
+    // Converts a masked color cursor into straight alpha, in place. Pixels with any alpha (the screen shows through them)
+    // become fully transparent black, the others become opaque.
+    //
+    inline void ConvertMaskToStraight(uint8_t* data, size_t rowPitch, uint32_t width, uint32_t height)
+    {
+        using namespace Details;
+
+        for (size_t cy = 0; cy < height; ++cy)
+        {
+            auto row = reinterpret_cast<uint32_t*>(data + cy * rowPitch);
+
+            size_t cx = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+            const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(CursorAlpha));
+            for (; cx + 4 <= width; cx += 4)
+            {
+                auto pixels = reinterpret_cast<__m128i*>(row + cx);
+                const __m128i value = _mm_loadu_si128(pixels);
+                const __m128i noAlpha = _mm_cmpeq_epi32(_mm_and_si128(value, alphaMask), _mm_setzero_si128());
+                _mm_storeu_si128(pixels, _mm_and_si128(noAlpha, _mm_or_si128(value, alphaMask)));
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            const uint32x4_t alphaMask = vdupq_n_u32(CursorAlpha);
+            for (; cx + 4 <= width; cx += 4)
+            {
+                const uint32x4_t value = vld1q_u32(row + cx);
+                const uint32x4_t noAlpha = vceqq_u32(vandq_u32(value, alphaMask), vdupq_n_u32(0));
+                vst1q_u32(row + cx, vandq_u32(noAlpha, vorrq_u32(value, alphaMask)));
+            }
+#endif
+            for (; cx < width; ++cx)
+            {
+                row[cx] = (row[cx] & CursorAlpha) ? 0 : (row[cx] | CursorAlpha);
+            }
+        }
+    }
+
+    //
+    // Converts the AND and XOR planes of a monochrome cursor, 1 bit per pixel with the leftmost pixel in the most
+    // significant bit, into masked color. The AND plane gives the alpha and the XOR plane the color (white or black).
+    //
+    // A byte of each plane is expanded to 8 pixels at a time through a lookup table, the last pixels of a row that
+    // doesn't end on a byte are read one bit at a time.
+    //
+    inline void ExpandMonochrome(
+        const uint8_t* andPlane, const uint8_t* xorPlane, size_t planePitch, uint32_t width, uint32_t height, uint8_t* output, size_t outputPitch)
+    {
+        using namespace Details;
+
+        const auto& expansion = BitExpansionTable();
+
+        for (size_t y = 0; y < height; y++)
+        {
+            const uint8_t* andRow = andPlane + y * planePitch;
+            const uint8_t* xorRow = xorPlane + y * planePitch;
+            auto row = reinterpret_cast<uint32_t*>(output + y * outputPitch);
+
+            uint32_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                const auto& andMasks = expansion[andRow[x / 8]];
+                const auto& xorMasks = expansion[xorRow[x / 8]];
+                uint32_t* pixels = row + x;
+
+#if defined(_M_X64) || defined(__x86_64__)
+                const __m128i alpha = _mm_set1_epi32(static_cast<int>(CursorAlpha));
+                const __m128i color = _mm_set1_epi32(static_cast<int>(CursorWhite));
+                for (size_t half = 0; half < 8; half += 4)
+                {
+                    const __m128i andMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(andMasks.data() + half));
+                    const __m128i xorMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xorMasks.data() + half));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + half),
+                        _mm_or_si128(_mm_and_si128(andMask, alpha), _mm_and_si128(xorMask, color)));
+                }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+                const uint32x4_t alpha = vdupq_n_u32(CursorAlpha);
+                const uint32x4_t color = vdupq_n_u32(CursorWhite);
+                for (size_t half = 0; half < 8; half += 4)
+                {
+                    const uint32x4_t andMask = vld1q_u32(andMasks.data() + half);
+                    const uint32x4_t xorMask = vld1q_u32(xorMasks.data() + half);
+                    vst1q_u32(pixels + half, vorrq_u32(vandq_u32(andMask, alpha), vandq_u32(xorMask, color)));
+                }
+#else
+                for (size_t bit = 0; bit < 8; bit++)
+                {
+                    pixels[bit] = (andMasks[bit] & CursorAlpha) | (xorMasks[bit] & CursorWhite);
+                }
+#endif
+            }
+
+            for (; x < width; x++)
+            {
+                const uint8_t bit = static_cast<uint8_t>(0x80 >> (x % 8));
+                row[x] = ((andRow[x / 8] & bit) ? CursorAlpha : 0) | ((xorRow[x / 8] & bit) ? CursorWhite : CursorBlack);
+            }
+        }
+    }
+
+    //
+    // Looks for an XOR pixel the way sinks do, a white color with non-zero alpha, 4 pixels at a time where SIMD is
+    // available. Stops at the first one.
+    //
+    inline bool ContainsXorPixel(const uint8_t* data, size_t rowPitch, uint32_t width, uint32_t height)
+    {
+        using namespace Details;
+
+        for (size_t y = 0; y < height; y++)
+        {
+            const auto row = reinterpret_cast<const uint32_t*>(data + y * rowPitch);
+
+            size_t x = 0;
+#if defined(_M_X64) || defined(__x86_64__)
+            const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(CursorAlpha));
+            const __m128i white = _mm_set1_epi32(static_cast<int>(CursorWhite));
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                const __m128i isWhite = _mm_cmpeq_epi32(_mm_and_si128(value, white), white);
+                const __m128i noAlpha = _mm_cmpeq_epi32(_mm_and_si128(value, alphaMask), _mm_setzero_si128());
+                if (_mm_movemask_epi8(_mm_andnot_si128(noAlpha, isWhite)) != 0)
+                {
+                    return true;
+                }
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            const uint32x4_t white = vdupq_n_u32(CursorWhite);
+            for (; x + 4 <= width; x += 4)
+            {
+                const uint32x4_t value = vld1q_u32(row + x);
+                const uint32x4_t isWhite = vceqq_u32(vandq_u32(value, white), white);
+                const uint32x4_t hasAlpha = vtstq_u32(value, vdupq_n_u32(CursorAlpha));
+                if (vmaxvq_u32(vandq_u32(isWhite, hasAlpha)) != 0)
+                {
+                    return true;
+                }
+            }
+#endif
+            for (; x < width; x++)
+            {
+                if ((row[x] & CursorWhite) == CursorWhite && (row[x] & CursorAlpha))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
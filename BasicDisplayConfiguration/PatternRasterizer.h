@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//
+// Writes the base plane checkerboard straight into rows of pixels, for a mapped texture or a CPU plane surface.
+//
+// Every row of a band of squares is the same, and the two kinds of band only differ in which color comes first. So one
+// row is built for each kind and every row of the plane is a copy of one of them, done with memcpy, which the C runtime
+// does with the widest stores the CPU has. Like the CPU renderer this only depends on the standard library, so patterns
+// can be made and checked without a device.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    // Fills width x height pixels (4 byte R8G8B8A8 or 8 byte R16G16B16A16 pixels) with squares of squareSize pixels. The
+    // square at the top left is the checker color, the colors then alternate along each row and each column.
+    template <typename Pixel>
+        requires std::same_as<Pixel, uint32_t> || std::same_as<Pixel, uint64_t>
+    void RasterizeCheckerboard(uint8_t* data, size_t rowPitch, uint32_t width, uint32_t height, uint32_t squareSize, Pixel checker, Pixel background)
+    {
+        if (width == 0 || height == 0)
+        {
+            return;
+        }
+
+        squareSize = (std::max)(squareSize, 1u);
+
+        // The row of the bands that start with the checker color, then of those that start with the background
+        std::vector<Pixel> bandRows[2];
+        for (uint32_t band = 0; band < 2; band++)
+        {
+            bandRows[band].resize(width);
+            for (uint32_t x = 0; x < width; x += squareSize)
+            {
+                const bool checkerSquare = (x / squareSize + band) % 2 == 0;
+                std::fill_n(bandRows[band].data() + x, (std::min)(squareSize, width - x), checkerSquare ? checker : background);
+            }
+        }
+
+        const size_t rowBytes = static_cast<size_t>(width) * sizeof(Pixel);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            std::memcpy(data + y * rowPitch, bandRows[(y / squareSize) % 2].data(), rowBytes);
+        }
+    }
+
+    // Fills the pixels [left, right) x [top, bottom) with one pixel, such as the part of a plane outside of the pattern
+    template <typename Pixel>
+        requires std::same_as<Pixel, uint32_t> || std::same_as<Pixel, uint64_t>
+    void FillPixels(uint8_t* data, size_t rowPitch, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, Pixel pixel)
+    {
+        for (uint32_t y = top; y < bottom; y++)
+        {
+            auto row = reinterpret_cast<Pixel*>(data + y * rowPitch);
+            std::fill(row + left, row + right, pixel);
+        }
+    }
+
+    // The first row of each band of squares, every row of a band is the same
+    inline std::vector<uint32_t> CheckerboardBandStarts(uint32_t height, uint32_t squareSize)
+    {
+        squareSize = (std::max)(squareSize, 1u);
+
+        std::vector<uint32_t> bandStarts;
+        for (uint32_t y = 0; y < height; y += squareSize)
+        {
+            bandStarts.push_back(y);
+        }
+
+        return bandStarts;
+    }
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
@@ -0,0 +1,221 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "ContentCache.h"
+
+//
+// A content-addressed cache of finished prediction frames.
+//
+// Many test configurations render exactly the same prediction (tools like the refresh rate never touch the pixels), so
+// frames are looked up by a canonical description of everything that goes into rendering them. Recently used frames are
+// kept in memory up to a budget, and an optional folder on disk keeps them across test runs. Like the CPU renderer this
+// only depends on the standard library.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    // Predictions are keyed by everything that goes into rendering them
+    using PredictionCacheKey = ContentCacheKey;
+
+    // A finished prediction frame, its scRGB fp16 pixels
+    struct CachedPrediction
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        std::vector<uint64_t> ScRgb;
+
+        size_t SizeInBytes() const
+        {
+            return ScRgb.size() * sizeof(uint64_t);
+        }
+    };
+
+    class PredictionCache
+    {
+    public:
+        // A memory budget of 0 keeps nothing in memory. An empty folder disables the disk tier, which is not size limited.
+        PredictionCache(size_t memoryBudget, std::filesystem::path folder) :
+            m_memory(memoryBudget), m_folder(std::move(folder))
+        {
+            if (!m_folder.empty())
+            {
+                std::error_code error;
+                std::filesystem::create_directories(m_folder, error);
+                if (error)
+                {
+                    m_folder.clear();
+                }
+            }
+        }
+
+        PredictionCache(const PredictionCache&) = delete;
+        PredictionCache& operator=(const PredictionCache&) = delete;
+
+        bool Enabled() const
+        {
+            return m_memory.MemoryBudget() != 0 || !m_folder.empty();
+        }
+
+        // Returns the cached frame for the key, or null. Frames found on disk are brought into memory.
+        std::shared_ptr<const CachedPrediction> Find(const PredictionCacheKey& key)
+        {
+            if (auto frame = m_memory.Find(key))
+            {
+                return frame;
+            }
+
+            auto frame = ReadFromDisk(key);
+            if (frame)
+            {
+                m_memory.Insert(key, frame);
+            }
+
+            return frame;
+        }
+
+        void Insert(const PredictionCacheKey& key, std::shared_ptr<const CachedPrediction> frame)
+        {
+            WriteToDisk(key, *frame);
+            m_memory.Insert(key, std::move(frame));
+        }
+
+        size_t MemoryUsed()
+        {
+            return m_memory.MemoryUsed();
+        }
+
+    private:
+        static constexpr char FileMagic[8] = {'M', 'D', 'C', 'T', 'P', 'R', 'E', 'D'};
+        static constexpr uint32_t FileVersion = 2;
+
+        std::filesystem::path FilePath(const PredictionCacheKey& key) const
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            const uint64_t hash = key.Hash();
+
+            std::string name(16, '0');
+            for (size_t i = 0; i < 16; i++)
+            {
+                name[i] = digits[(hash >> (60 - i * 4)) & 0xF];
+            }
+
+            return m_folder / (name + ".prediction");
+        }
+
+        // Each file holds the full key, so a file whose name collides with another key's is never used for it
+        std::shared_ptr<const CachedPrediction> ReadFromDisk(const PredictionCacheKey& key) const
+        {
+            if (m_folder.empty())
+            {
+                return nullptr;
+            }
+
+            std::ifstream file(FilePath(key), std::ios::binary);
+            if (!file)
+            {
+                return nullptr;
+            }
+
+            char magic[sizeof(FileMagic)] = {};
+            uint32_t version = 0, keySize = 0;
+            file.read(magic, sizeof(magic));
+            file.read(reinterpret_cast<char*>(&version), sizeof(version));
+            file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+            if (!file || std::memcmp(magic, FileMagic, sizeof(magic)) != 0 || version != FileVersion || keySize != key.Bytes().size())
+            {
+                return nullptr;
+            }
+
+            std::string storedKey(keySize, '\0');
+            file.read(storedKey.data(), keySize);
+            if (!file || storedKey != key.Bytes())
+            {
+                return nullptr;
+            }
+
+            auto frame = std::make_shared<CachedPrediction>();
+            file.read(reinterpret_cast<char*>(&frame->Width), sizeof(frame->Width));
+            file.read(reinterpret_cast<char*>(&frame->Height), sizeof(frame->Height));
+            if (!file)
+            {
+                return nullptr;
+            }
+
+            const size_t pixelCount = static_cast<size_t>(frame->Width) * frame->Height;
+            frame->ScRgb.resize(pixelCount);
+            file.read(reinterpret_cast<char*>(frame->ScRgb.data()), pixelCount * sizeof(uint64_t));
+            if (!file)
+            {
+                return nullptr;
+            }
+
+            return frame;
+        }
+
+        // A random token for this process and a count of the files it has written, so no two writers ever share a
+        // temporary file, whether they are threads of one run or separate runs sharing the folder.
+        static std::string TemporaryFileSuffix()
+        {
+            static const uint64_t processToken = [] {
+                std::random_device device;
+                return (static_cast<uint64_t>(device()) << 32) | device();
+            }();
+            static std::atomic<uint64_t> fileCount{0};
+
+            return std::to_string(processToken) + "." + std::to_string(fileCount.fetch_add(1, std::memory_order_relaxed));
+        }
+
+        // Written to a temporary file first and renamed into place, so concurrent runs sharing a folder never see a
+        // partial file. Failures only mean the frame isn't cached on disk.
+        void WriteToDisk(const PredictionCacheKey& key, const CachedPrediction& frame) const
+        {
+            if (m_folder.empty())
+            {
+                return;
+            }
+
+            const auto path = FilePath(key);
+            auto temporaryPath = path;
+            temporaryPath += "." + TemporaryFileSuffix() + ".tmp";
+
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                const uint32_t keySize = static_cast<uint32_t>(key.Bytes().size());
+                file.write(FileMagic, sizeof(FileMagic));
+                file.write(reinterpret_cast<const char*>(&FileVersion), sizeof(FileVersion));
+                file.write(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+                file.write(key.Bytes().data(), keySize);
+                file.write(reinterpret_cast<const char*>(&frame.Width), sizeof(frame.Width));
+                file.write(reinterpret_cast<const char*>(&frame.Height), sizeof(frame.Height));
+                file.write(reinterpret_cast<const char*>(frame.ScRgb.data()), frame.ScRgb.size() * sizeof(uint64_t));
+
+                if (!file)
+                {
+                    file.close();
+                    std::error_code error;
+                    std::filesystem::remove(temporaryPath, error);
+                    return;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(temporaryPath, path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporaryPath, error);
+            }
+        }
+
+        LruContentCache<CachedPrediction> m_memory;
+        std::filesystem::path m_folder;
+    };
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
@@ -6,6 +6,8 @@ import RenderingUtils;
 using namespace RenderingUtils;
 using namespace winrt::MicrosoftDisplayCaptureTools::Framework::Helpers;
 
+namespace CpuRendering = winrt::BasicDisplayConfiguration::Rendering;
+
 namespace winrt
 {
     using namespace winrt::Windows::Foundation;
@@ -47,8 +49,12 @@ namespace PredictionRenderer {
         winrt::float3x2 TransformMatrix = winrt::float3x2::identity();
         std::optional<winrt::Rect> SourceRect = {};
         std::optional<winrt::Rect> DestinationRect = {};
+        std::optional<winrt::Rect> ClipRect = {}; // In the source mode's space, the plane's transform doesn't apply to it
         float SdrWhiteLevel = 80.0F;
         winrt::CanvasImageInterpolation InterpolationMode = winrt::CanvasImageInterpolation::Linear;
+
+        // CPU-side plane contents, used in place of Surface when the prediction is rendered on the CPU
+        std::shared_ptr<const CpuRendering::PlaneSurface> CpuSurface = nullptr;
     };
 
     /// <summary>
@@ -56,6 +62,12 @@ namespace PredictionRenderer {
     /// </summary>
     export enum class StretchMode { Identity, Center, Fill, FillToAspectRatio };
 
+    /// <summary>
+    /// The filter a stretched frame's planes are resampled with. Lanczos3 is only rendered as such on the CPU, Win2D
+    /// draws it with its high quality cubic filter instead.
+    /// </summary>
+    export enum class ScalingFilter { NearestNeighbor, Bilinear, Bicubic, Lanczos3 };
+
     /// <summary>
     /// Rendering mode
     /// </summary>
@@ -76,10 +88,12 @@ namespace PredictionRenderer {
         winrt::Size TargetModeSize = {640, 480};
         winrt::Size SourceModeSize = {640, 480};
         StretchMode SourceToTargetStretch = StretchMode::Identity;
+        std::optional<ScalingFilter> StretchFilter = {}; // Overrides each plane's InterpolationMode when stretching
         RenderMode RenderMode = RenderMode::Target;
 
         // Describes the post-blend color pipeline
         winrt::DisplayWireFormat WireFormat = nullptr;
+        bool EmulateWireFormat = true; // Quantize, subsample and range convert CPU predictions as the wire format does
         std::vector<float> GammaLut;
         winrt::float4x4 ColorMatrixXyz = 
             {1.f, 0.f, 0.f, 0.f,
@@ -108,13 +122,49 @@ namespace PredictionRenderer {
         void Resolution(winrt::SizeInt32 const& resolution);
         void SetImageApproximation(winrt::SoftwareBitmap bitmap);
 
+        // Describes the frame as constant rectangles instead of setting its buffer. The description is published as a
+        // frame property that comparisons use directly, the pixels and the approximation are only made if asked for.
+        void SetAnalyticFrame(std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame> analyticFrame);
+
+        // Holds the frame as tiles instead of setting its buffer. The tiles are published as a frame property the first
+        // time the properties are asked for, the pixels and the approximation are only made if asked for.
+        void SetTiledFrame(std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame> tiledFrame);
+
+        // The tiles of the frame, or null if it doesn't have any. Only for use within this module, consumers elsewhere
+        // read the frame property.
+        std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame> Tiles() const;
+
     private:
+        // Calls function(left, right, pixels, repeated) for the runs of row y of the analytic or tiled frame
+        template <typename Function>
+        void ForEachRun(uint32_t y, Function&& function) const
+        {
+            if (m_analyticFrame)
+            {
+                m_analyticFrame->ForEachRun(y, function);
+            }
+            else
+            {
+                m_tiledFrame->ForEachRun(y, function);
+            }
+        }
+
+        // The pixels and the approximation of an analytic or tiled frame. The pixels are made the first time they are
+        // asked for and kept from then on, the approximation is made for each caller and released when they are done.
+        winrt::IBuffer MakeData() const;
+        winrt::SoftwareBitmap MakeApproximation() const;
+
+        std::mutex m_dataLock;
         winrt::IBuffer m_data{nullptr};
         winrt::DisplayWireFormat m_format{nullptr};
         winrt::IMap<winrt::hstring, winrt::IInspectable> m_properties;
         winrt::SizeInt32 m_resolution;
 
         winrt::SoftwareBitmap m_bitmap{nullptr};
+
+        std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame> m_analyticFrame;
+        std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame> m_tiledFrame;
+        std::once_flag m_tiledFramePublished;
     };
 
     export struct FrameSet : winrt::implements<FrameSet, winrt::IRawFrameSet>
@@ -147,8 +197,13 @@ namespace PredictionRenderer {
         std::vector<FrameInformation>& Frames();
         winrt::CanvasDevice Device();
 
+        // Whether frames are rendered on the CPU rather than through Win2D. Tools should provide CpuSurface for their
+        // planes when this is set, so that no D3D device is needed.
+        bool RenderOnCpu();
+
     private:
         winrt::CanvasDevice m_device{nullptr};
+        std::optional<bool> m_renderOnCpu;
 
         winrt::IMap<winrt::hstring, winrt::IInspectable> m_properties;
         std::vector<PredictionRenderer::FrameInformation> m_frames;
@@ -177,12 +232,16 @@ namespace PredictionRenderer {
 
         winrt::event_token RenderLoopCallback(winrt::EventHandler<winrt::IPredictionData> const& handler);
         void RenderLoopCallback(winrt::event_token const& token) noexcept;
+
+        winrt::event_token FrameRenderedCallback(winrt::EventHandler<winrt::IRawFrame> const& handler);
+        void FrameRenderedCallback(winrt::event_token const& token) noexcept;
         
 
     private:
         winrt::event<winrt::EventHandler<winrt::IPredictionData>> m_displaySetupCallback;
         winrt::event<winrt::EventHandler<winrt::IPredictionData>> m_renderSetupCallback;
         winrt::event<winrt::EventHandler<winrt::IPredictionData>> m_renderLoopCallback;
+        winrt::event<winrt::EventHandler<winrt::IRawFrame>> m_frameRenderedCallback;
     };
 } // namespace PredictionRenderer
 
@@ -237,16 +296,41 @@ namespace PredictionRenderer {
         return m_device;
     }
 
+    bool PredictionData::RenderOnCpu()
+    {
+        if (!m_renderOnCpu.has_value())
+        {
+            // Rendering on hardware still goes through Win2D, what would otherwise run on WARP runs on the CPU instead
+            m_renderOnCpu = !RuntimeSettings().GetSettingValueAsBool(L"RenderOnHardware");
+
+            if (m_renderOnCpu.value())
+            {
+                Logger().LogNote(L"Rendering predictions on the CPU");
+            }
+        }
+
+        return m_renderOnCpu.value();
+    }
+
     Prediction::Prediction()
     {
     }
 
     Frame::Frame()
     {
+        m_properties = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
     }
 
     winrt::IBuffer Frame::Data()
     {
+        // Frames held in a compact form only pay for their full size once something asks for the pixels, but after that
+        // every caller, on any thread, shares the one buffer instead of expanding the frame again.
+        std::lock_guard lock(m_dataLock);
+        if (!m_data)
+        {
+            m_data = MakeData();
+        }
+
         return m_data;
     }
 
@@ -257,6 +341,17 @@ namespace PredictionRenderer {
 
     winrt::IMap<winrt::hstring, winrt::IInspectable> Frame::Properties()
     {
+        // Serializing the tiles costs about as much as reading them, so it's left until something outside of this module
+        // asks for them. Frames only used as the base of an incremental render never pay for it.
+        if (m_tiledFrame)
+        {
+            std::call_once(m_tiledFramePublished, [this] {
+                m_properties.Insert(
+                    winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame::PropertyName,
+                    winrt::PropertyValue::CreateUInt64Array(m_tiledFrame->Serialize()));
+            });
+        }
+
         return m_properties;
     }
 
@@ -267,9 +362,9 @@ namespace PredictionRenderer {
 
     winrt::IAsyncOperation<winrt::SoftwareBitmap> Frame::GetRenderableApproximationAsync()
     {
-        // In this implementation, this approximation is created as a side effect of rendering the prediction. So here the result can
-        // just be returned.
-        co_return m_bitmap;
+        // Predictions are held as a description or as tiles, the approximation is made from them for this caller. Frames
+        // given a bitmap directly just return it.
+        co_return m_bitmap ? m_bitmap : MakeApproximation();
     }
 
     winrt::hstring Frame::GetPixelInfo(uint32_t x, uint32_t y)
@@ -284,6 +379,7 @@ namespace PredictionRenderer {
 
     void Frame::SetBuffer(winrt::IBuffer buffer)
     {
+        std::lock_guard lock(m_dataLock);
         m_data = buffer;
     }
 
@@ -302,6 +398,91 @@ namespace PredictionRenderer {
         m_bitmap = bitmap;
     }
 
+    void Frame::SetAnalyticFrame(std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame> analyticFrame)
+    {
+        m_properties.Insert(
+            winrt::MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame::PropertyName,
+            winrt::PropertyValue::CreateUInt64Array(analyticFrame->Serialize()));
+
+        m_analyticFrame = std::move(analyticFrame);
+    }
+
+    void Frame::SetTiledFrame(std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame> tiledFrame)
+    {
+        m_tiledFrame = std::move(tiledFrame);
+    }
+
+    std::shared_ptr<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame> Frame::Tiles() const
+    {
+        return m_tiledFrame;
+    }
+
+    winrt::IBuffer Frame::MakeData() const
+    {
+        if (!m_analyticFrame && !m_tiledFrame)
+        {
+            return nullptr;
+        }
+
+        const uint32_t width = m_analyticFrame ? m_analyticFrame->Width() : m_tiledFrame->Width();
+        const uint32_t height = m_analyticFrame ? m_analyticFrame->Height() : m_tiledFrame->Height();
+
+        winrt::Buffer frameBuffer(width * height * sizeof(uint64_t));
+        frameBuffer.Length(frameBuffer.Capacity());
+        auto scRgb = reinterpret_cast<uint64_t*>(frameBuffer.data());
+
+        winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool::Default().ParallelFor(height, [&](uint32_t y) {
+            uint64_t* row = scRgb + static_cast<size_t>(y) * width;
+            ForEachRun(y, [row](uint32_t left, uint32_t right, const uint64_t* pixels, bool repeated) {
+                if (repeated)
+                {
+                    std::fill(row + left, row + right, *pixels);
+                }
+                else
+                {
+                    std::copy(pixels, pixels + (right - left), row + left);
+                }
+            });
+        });
+
+        return frameBuffer;
+    }
+
+    winrt::SoftwareBitmap Frame::MakeApproximation() const
+    {
+        if (!m_analyticFrame && !m_tiledFrame)
+        {
+            return nullptr;
+        }
+
+        const uint32_t width = m_analyticFrame ? m_analyticFrame->Width() : m_tiledFrame->Width();
+        const uint32_t height = m_analyticFrame ? m_analyticFrame->Height() : m_tiledFrame->Height();
+        const auto& srgb8FromHalf = CpuRendering::Details::Srgb8FromHalfTable();
+
+        winrt::Buffer previewBuffer(width * height * sizeof(uint32_t));
+        previewBuffer.Length(previewBuffer.Capacity());
+        auto preview = reinterpret_cast<uint32_t*>(previewBuffer.data());
+
+        // Made straight from the runs, a repeated pixel is only converted once
+        winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool::Default().ParallelFor(height, [&](uint32_t y) {
+            uint32_t* row = preview + static_cast<size_t>(y) * width;
+            ForEachRun(y, [&](uint32_t left, uint32_t right, const uint64_t* pixels, bool repeated) {
+                if (repeated)
+                {
+                    std::fill(row + left, row + right, CpuRendering::Details::Srgb8FromScRgb(srgb8FromHalf, *pixels));
+                    return;
+                }
+
+                for (uint32_t x = left; x < right; x++)
+                {
+                    row[x] = CpuRendering::Details::Srgb8FromScRgb(srgb8FromHalf, pixels[x - left]);
+                }
+            });
+        });
+
+        return winrt::SoftwareBitmap::CreateCopyFromBuffer(previewBuffer, winrt::BitmapPixelFormat::Rgba8, (int32_t)width, (int32_t)height);
+    }
+
     FrameSet::FrameSet()
     {
         m_frames = winrt::single_threaded_vector<winrt::IRawFrame>();
@@ -317,6 +498,150 @@ namespace PredictionRenderer {
         return m_properties;
     }
 
+    //
+    // The transform from source mode space to target mode space, only applied when rendering the full target
+    //
+    winrt::float3x2 SourceToTargetTransform(const FrameInformation& frameInformation)
+    {
+        winrt::float3x2 sourceToTarget = winrt::float3x2::identity();
+
+        if (frameInformation.RenderMode == RenderMode::Target)
+        {
+            // We are rendering the full target, so include the source -> target transform
+            switch (frameInformation.SourceToTargetStretch)
+            {
+            case StretchMode::Identity:
+                sourceToTarget = winrt::float3x2::identity();
+                break;
+            case StretchMode::Center:
+                sourceToTarget = winrt::make_float3x2_translation(
+                    (float)((frameInformation.TargetModeSize.Width - frameInformation.SourceModeSize.Width) / 2),
+                    (float)((frameInformation.TargetModeSize.Height - frameInformation.SourceModeSize.Height) / 2));
+                break;
+            case StretchMode::Fill:
+                sourceToTarget = winrt::make_float3x2_scale(
+                    (float)frameInformation.TargetModeSize.Width / frameInformation.SourceModeSize.Width,
+                    (float)frameInformation.TargetModeSize.Height / frameInformation.SourceModeSize.Height);
+                break;
+            case StretchMode::FillToAspectRatio:
+                float Ratio =
+                    min((float)frameInformation.TargetModeSize.Width / frameInformation.SourceModeSize.Width,
+                        (float)frameInformation.TargetModeSize.Height / frameInformation.SourceModeSize.Height);
+
+                sourceToTarget = winrt::make_float3x2_scale(Ratio, Ratio) *
+                                 winrt::make_float3x2_translation(
+                                     (frameInformation.TargetModeSize.Width - frameInformation.SourceModeSize.Width * Ratio) / 2,
+                                     (frameInformation.TargetModeSize.Height - frameInformation.SourceModeSize.Height * Ratio) / 2);
+                break;
+            }
+        }
+
+        return sourceToTarget;
+    }
+
+    //
+    // The stretch filter only applies when the source is actually scaled onto the target
+    //
+    std::optional<ScalingFilter> EffectiveStretchFilter(const FrameInformation& frameInformation)
+    {
+        if (frameInformation.RenderMode != RenderMode::Target || frameInformation.SourceToTargetStretch == StretchMode::Identity ||
+            frameInformation.SourceToTargetStretch == StretchMode::Center)
+        {
+            return std::nullopt;
+        }
+
+        return frameInformation.StretchFilter;
+    }
+
+    //
+    // The per-plane degamma curve, from a plane's encoded values to scRGB. The curve comes from the shared table cache, HDR
+    // curves are scaled from their normalized range so that 1.0 stays at 80 nits.
+    //
+    std::vector<float> CreatePlaneDegammaCurve(DXGI_COLOR_SPACE_TYPE colorSpace)
+    {
+        const auto gammaType = GetGammaTypeForColorSpace(colorSpace);
+
+        // TODO: source gamma stops parameter from GPU caps?
+        std::vector<float> degammaCurve = *RenderingUtils::GetGammaTransferCurve(gammaType, RenderingUtils::GammaType::G10, 1024);
+
+        const float scale = RenderingUtils::GetLinearScale(gammaType);
+        if (scale != 1.0f)
+        {
+            for (auto& value : degammaCurve)
+            {
+                value *= scale;
+            }
+        }
+
+        return degammaCurve;
+    }
+
+    //
+    // The post-blend color pipeline of a frame: RGB->XYZ, the XYZ color matrix and XYZ->RGB. Regamma is skipped since the
+    // prediction stays in scRGB, see RenderPredictionFrame.
+    //
+    CpuRendering::ColorPipeline CreatePostBlendPipeline(const FrameInformation& frameInformation)
+    {
+        const auto& csc = frameInformation.ColorMatrixXyz;
+
+        CpuRendering::ColorPipeline pipeline;
+        pipeline.Add(CpuRendering::RgbToXyzMatrix)
+            .Add(CpuRendering::ColorMatrix{csc.m11, csc.m12, csc.m13, csc.m21, csc.m22, csc.m23, csc.m31, csc.m32, csc.m33})
+            .Add(CpuRendering::XyzToRgbMatrix);
+
+        return pipeline;
+    }
+
+    //
+    // Builds the Win2D effects for a compiled pipeline, one effect per remaining stage.
+    //
+    winrt::ICanvasImage CreatePipelineEffects(const CpuRendering::CompiledColorPipeline& pipeline, winrt::ICanvasImage source)
+    {
+        for (const auto& stage : pipeline.Stages())
+        {
+            if (const auto transform = std::get_if<CpuRendering::ColorTransform>(&stage))
+            {
+                const auto& m = transform->Matrix;
+
+                winrt::Matrix5x4 matrix{};
+                matrix.M11 = m[0]; matrix.M12 = m[1]; matrix.M13 = m[2];
+                matrix.M21 = m[3]; matrix.M22 = m[4]; matrix.M23 = m[5];
+                matrix.M31 = m[6]; matrix.M32 = m[7]; matrix.M33 = m[8];
+                matrix.M44 = 1.f;
+                matrix.M51 = transform->Offset[0]; matrix.M52 = transform->Offset[1]; matrix.M53 = transform->Offset[2];
+
+                auto matrixEffect = winrt::ColorMatrixEffect();
+                matrixEffect.ColorMatrix(matrix);
+                matrixEffect.Source(source);
+                source = matrixEffect;
+            }
+            else
+            {
+                const auto& curve = std::get<CpuRendering::ColorCurve>(stage);
+                if (curve.Lookup == CpuRendering::CurveLookup::Discrete)
+                {
+                    auto curveEffect = winrt::DiscreteTransferEffect();
+                    curveEffect.RedTable(curve.Table);
+                    curveEffect.GreenTable(curve.Table);
+                    curveEffect.BlueTable(curve.Table);
+                    curveEffect.Source(source);
+                    source = curveEffect;
+                }
+                else
+                {
+                    auto curveEffect = winrt::TableTransferEffect();
+                    curveEffect.RedTable(curve.Table);
+                    curveEffect.GreenTable(curve.Table);
+                    curveEffect.BlueTable(curve.Table);
+                    curveEffect.Source(source);
+                    source = curveEffect;
+                }
+            }
+        }
+
+        return source;
+    }
+
     //
     // Compose the data collected for each frame into the final output data
     //
@@ -360,45 +685,14 @@ namespace PredictionRenderer {
             auto backgroundBrush = winrt::Brushes::CanvasSolidColorBrush::CreateHdr(drawingSession, frameInformation.BackgroundColor);
             backgroundBrush.ColorHdr(frameInformation.BackgroundColor);
 
-            winrt::float3x2 sourceToTarget;
+            const winrt::float3x2 sourceToTarget = SourceToTargetTransform(frameInformation);
+            const auto stretchFilter = EffectiveStretchFilter(frameInformation);
 
             if (frameInformation.RenderMode == RenderMode::Target)
             {
-                // We are rendering the full target, so include the source -> target transform
-                switch (frameInformation.SourceToTargetStretch)
-                {
-                case StretchMode::Identity:
-                    sourceToTarget = winrt::float3x2::identity();
-                    break;
-                case StretchMode::Center:
-                    sourceToTarget = winrt::make_float3x2_translation(
-                        (float)((frameInformation.TargetModeSize.Width + frameInformation.SourceModeSize.Width) / 2),
-                        (float)((frameInformation.TargetModeSize.Height + frameInformation.SourceModeSize.Height) / 2));
-                    break;
-                case StretchMode::Fill:
-                    sourceToTarget = winrt::make_float3x2_scale(
-                        (float)frameInformation.TargetModeSize.Width / frameInformation.SourceModeSize.Width,
-                        (float)frameInformation.TargetModeSize.Height + frameInformation.SourceModeSize.Height);
-                    break;
-                case StretchMode::FillToAspectRatio:
-                    float Ratio =
-                        min((float)frameInformation.TargetModeSize.Width / frameInformation.SourceModeSize.Width,
-                            (float)frameInformation.TargetModeSize.Height / frameInformation.SourceModeSize.Height);
-
-                    sourceToTarget = winrt::make_float3x2_scale(Ratio, Ratio) *
-                                     winrt::make_float3x2_translation(
-                                         (frameInformation.TargetModeSize.Width + frameInformation.SourceModeSize.Width * Ratio) / 2,
-                                         (frameInformation.TargetModeSize.Height + frameInformation.SourceModeSize.Height * Ratio) / 2);
-                    break;
-                }
-
                 drawingSession.FillRectangle(
                     winrt::Rect(0, 0, (float)frameInformation.TargetModeSize.Width, (float)frameInformation.TargetModeSize.Height), backgroundBrush);
             }
-            else
-            {
-                sourceToTarget = winrt::float3x2::identity();
-            }
 
             {
                 CanvasAutoTransform FrameTransform(drawingSession, sourceToTarget);
@@ -406,17 +700,20 @@ namespace PredictionRenderer {
                 // Render the target bounds in the background color first
                 for (auto& plane : frameInformation.Planes)
                 {
+                    // The clip is set up before the plane's own transform, which it isn't subject to
+                    winrt::CanvasActiveLayer clipLayer{nullptr};
+                    if (plane.ClipRect.has_value())
+                    {
+                        clipLayer = drawingSession.CreateLayer(1.0F, plane.ClipRect.value());
+                    }
+
                     CanvasAutoTransform PlaneTransform(drawingSession, plane.TransformMatrix);
                     winrt::Size sourceSize = {};
 
                     // Per-Plane de-gamma
                     auto degammaEffect = winrt::DiscreteTransferEffect();
 
-                    auto degammaCurve = RenderingUtils::CreateGammaTransferCurve(
-                        GetGammaTypeForColorSpace(plane.ColorSpace),
-                        RenderingUtils::GammaType::G10,
-                        1024);
-                    // TODO: source gamma stops parameter from GPU caps?
+                    auto degammaCurve = CreatePlaneDegammaCurve(plane.ColorSpace);
 
                     degammaEffect.RedTable(degammaCurve);
                     degammaEffect.GreenTable(degammaCurve);
@@ -442,6 +739,26 @@ namespace PredictionRenderer {
                         degammaEffect.Source(planeSource);
                     }
                     
+                    auto interpolationMode = plane.InterpolationMode;
+                    if (stretchFilter.has_value())
+                    {
+                        switch (stretchFilter.value())
+                        {
+                        case ScalingFilter::NearestNeighbor:
+                            interpolationMode = winrt::CanvasImageInterpolation::NearestNeighbor;
+                            break;
+                        case ScalingFilter::Bilinear:
+                            interpolationMode = winrt::CanvasImageInterpolation::Linear;
+                            break;
+                        case ScalingFilter::Bicubic:
+                            interpolationMode = winrt::CanvasImageInterpolation::Cubic;
+                            break;
+                        case ScalingFilter::Lanczos3:
+                            interpolationMode = winrt::CanvasImageInterpolation::HighQualityCubic;
+                            break;
+                        }
+                    }
+
                     // Draw the plane into the main linear surface
                     drawingSession.DrawImage(
                         degammaEffect,
@@ -449,7 +766,12 @@ namespace PredictionRenderer {
                                                           : winrt::Rect(winrt::Point(), frameInformation.SourceModeSize),
                         plane.SourceRect.has_value() ? plane.SourceRect.value() : winrt::Rect(winrt::Point(), sourceSize),
                         1.0F,
-                        plane.InterpolationMode);
+                        interpolationMode);
+
+                    if (clipLayer)
+                    {
+                        clipLayer.Close();
+                    }
                 }
             }
 
@@ -482,48 +804,12 @@ namespace PredictionRenderer {
             drawingSession.FillRectangle(
                 winrt::Rect(0, 0, (float)frameInformation.TargetModeSize.Width, (float)frameInformation.TargetModeSize.Height), backgroundBrush);
 
-            // 1. RBG->XYZ
-            auto rgbxyzMatrixEffect = winrt::ColorMatrixEffect();
-            winrt::Matrix5x4 rgbxyz{};
-
-            rgbxyz.M11 = 0.4124564f; rgbxyz.M12 = 0.3575761f; rgbxyz.M13 = 0.1804375f; rgbxyz.M14 = 0.f; 
-            rgbxyz.M21 = 0.2126729f; rgbxyz.M22 = 0.7151522f; rgbxyz.M23 = 0.0721750f; rgbxyz.M24 = 0.f;
-            rgbxyz.M31 = 0.0193339f; rgbxyz.M32 = 0.1191920f; rgbxyz.M33 = 0.9503041f; rgbxyz.M34 = 0.f;
-            rgbxyz.M41 = 0.f;        rgbxyz.M42 = 0.f;        rgbxyz.M43 = 0.f;        rgbxyz.M44 = 1.f;
-
-            rgbxyzMatrixEffect.ColorMatrix(rgbxyz);
-            rgbxyzMatrixEffect.Source(planeCompositingTarget);
-
-            // 2. Color Matrix
-            auto cscMatrix = winrt::ColorMatrixEffect();
-            winrt::Matrix5x4 csc{};
-            csc.M11 = frameInformation.ColorMatrixXyz.m11;
-            csc.M12 = frameInformation.ColorMatrixXyz.m12;
-            csc.M13 = frameInformation.ColorMatrixXyz.m13;
-            csc.M21 = frameInformation.ColorMatrixXyz.m21;
-            csc.M22 = frameInformation.ColorMatrixXyz.m22;
-            csc.M23 = frameInformation.ColorMatrixXyz.m23;
-            csc.M31 = frameInformation.ColorMatrixXyz.m31;
-            csc.M32 = frameInformation.ColorMatrixXyz.m32;
-            csc.M33 = frameInformation.ColorMatrixXyz.m33;
-            csc.M44 = 1.f;
-            cscMatrix.ColorMatrix(csc);
-            cscMatrix.Source(rgbxyzMatrixEffect);
-
-            // 3. XYZ->RGB
-            auto xyzrgbMatrixEffect = winrt::ColorMatrixEffect();
-            winrt::Matrix5x4 xyzrgb{};
-
-            xyzrgb.M11 =  3.2404542f; xyzrgb.M12 = -1.5371385f; xyzrgb.M13 = -0.4985314f; xyzrgb.M14 = 0.f;
-            xyzrgb.M21 = -0.9692660f; xyzrgb.M22 =  1.8760108f; xyzrgb.M23 =  0.0415560f; xyzrgb.M24 = 0.f;
-            xyzrgb.M31 =  0.0556434f; xyzrgb.M32 = -0.2040259f; xyzrgb.M33 =  1.0572252f; xyzrgb.M34 = 0.f;
-            xyzrgb.M41 =  0.f;        xyzrgb.M42 =  0.f;        xyzrgb.M43 =  0.f;        xyzrgb.M44 = 1.f;
-
-            xyzrgbMatrixEffect.ColorMatrix(xyzrgb);
-            xyzrgbMatrixEffect.Source(cscMatrix);
+            // 1-3. RGB->XYZ, the color matrix and XYZ->RGB are folded into a single matrix, so they cost one effect
+            // instead of three
+            const CpuRendering::CompiledColorPipeline postBlendPipeline(CreatePostBlendPipeline(frameInformation));
 
             // Commit the color pipeline
-            drawingSession.DrawImage(xyzrgbMatrixEffect);
+            drawingSession.DrawImage(CreatePipelineEffects(postBlendPipeline, planeCompositingTarget));
 
             drawingSession.Flush();
             drawingSession.Close();
@@ -531,78 +817,537 @@ namespace PredictionRenderer {
         
         // Transit GPU surface to CPU-Accessible for returning.
         // 1. Create an output frame object
-        // 2. Start copying over a GPU surface to the frame object for render previews
-        // 3. Copy GPU surface to CPU-accessible memory
-        // 4. Slice CPU-accessible pixel data to the destination type (starting from 16 bit-per-channel floats)
-        // 5. Ensure that the copy started in 2 is finished
+        // 2. Copy GPU surface to CPU-accessible memory
+        // 3. Hold the pixel data as tiles, so that flat areas cost a few bytes instead of the full buffer while the frame
+        //    waits to be consumed. The pixels and the render preview are made from the tiles when they are asked for.
         {
             // 1. Create an output frame object
             auto frame = winrt::make_self<Frame>();
             frame->Resolution(winrt::SizeInt32(postBlendTarget.SizeInPixels().Width, postBlendTarget.SizeInPixels().Height));
             frame->DataFormat(frameInformation.WireFormat);
 
-            // 2. Create a renderable preview of the post-color pipeline image to be used as preview
-            auto CreateSoftwareBitmapAsync = [&]() -> winrt::IAsyncOperation<winrt::SoftwareBitmap> {
-                auto renderablePreview = winrt::CanvasRenderTarget(
-                    device,
-                    (float)frameInformation.TargetModeSize.Width,
-                    (float)frameInformation.TargetModeSize.Height,
-                    96,
-                    winrt::DirectXPixelFormat::R8G8B8A8UIntNormalizedSrgb,
-                    winrt::CanvasAlphaMode::Premultiplied);
-                {
-                    auto drawingSession = renderablePreview.CreateDrawingSession();
-                    drawingSession.DrawImage(postBlendTarget);
+            // 2. Copy GPU surface to CPU-accessible memory
+            const auto frameBytes = postBlendTarget.GetPixelBytes();
+
+            // 3. Hold the pixel data as tiles
+            frame->SetTiledFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame>(
+                winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame::FromPixels(
+                    std::span(reinterpret_cast<const uint64_t*>(frameBytes.data()), frameBytes.size() / sizeof(uint64_t)),
+                    postBlendTarget.SizeInPixels().Width,
+                    postBlendTarget.SizeInPixels().Height)));
+
+            auto rawFrame = frame.as<winrt::IRawFrame>();
+            co_return rawFrame;
+        }
+    }
+
+    //
+    // Whether a frame can be rendered by the CPU renderer, which needs every plane with contents to have a CpuSurface.
+    // Planes without any contents are skipped.
+    //
+    bool CanRenderOnCpu(const FrameInformation& frameInformation)
+    {
+        for (const auto& plane : frameInformation.Planes)
+        {
+            if (plane.CpuSurface ? plane.ColorType != PlaneColorType::RGB : plane.Surface != nullptr)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // What the CPU prediction goes through on the wire, as the Tanager decodes it. Sources send RGB at full range and
+    // YCbCr at limited range. Only the target goes over the wire, and formats the Tanager can't decode aren't emulated.
+    //
+    std::optional<CpuRendering::WireFormatEmulation> CreateWireFormatEmulation(const FrameInformation& frameInformation)
+    {
+        namespace WireFormat = winrt::MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+        const auto& wireFormat = frameInformation.WireFormat;
+        if (!frameInformation.EmulateWireFormat || !wireFormat || frameInformation.RenderMode != RenderMode::Target ||
+            wireFormat.BitsPerChannel() < 8 || wireFormat.BitsPerChannel() > 12)
+        {
+            return std::nullopt;
+        }
+
+        CpuRendering::WireFormatEmulation emulation;
+        emulation.BitDepth = static_cast<uint32_t>(wireFormat.BitsPerChannel());
+
+        switch (wireFormat.Eotf())
+        {
+        case winrt::DisplayWireFormatEotf::Sdr:
+            emulation.Transfer = WireFormat::TransferFunction::Bt709;
+            break;
+        case winrt::DisplayWireFormatEotf::HdrSmpte2084:
+            emulation.Transfer = WireFormat::TransferFunction::Smpte2084;
+            break;
+        default:
+            return std::nullopt;
+        }
+
+        WireFormat::YcbcrMatrix ycbcrMatrix;
+        switch (wireFormat.ColorSpace())
+        {
+        case winrt::DisplayWireFormatColorSpace::BT709:
+            emulation.Primaries = WireFormat::ColorPrimaries::Bt709;
+            ycbcrMatrix = WireFormat::YcbcrMatrix::Bt709;
+            break;
+        case winrt::DisplayWireFormatColorSpace::BT2020:
+            emulation.Primaries = WireFormat::ColorPrimaries::Bt2020;
+            ycbcrMatrix = WireFormat::YcbcrMatrix::Bt2020;
+            break;
+        default:
+            return std::nullopt;
+        }
+
+        switch (wireFormat.PixelEncoding())
+        {
+        case winrt::DisplayWireFormatPixelEncoding::Rgb444:
+            return emulation;
+        case winrt::DisplayWireFormatPixelEncoding::Ycc444:
+            emulation.Subsampling = CpuRendering::ChromaSubsampling::None;
+            break;
+        case winrt::DisplayWireFormatPixelEncoding::Ycc422:
+            emulation.Subsampling = CpuRendering::ChromaSubsampling::Horizontal;
+            break;
+        case winrt::DisplayWireFormatPixelEncoding::Ycc420:
+            emulation.Subsampling = CpuRendering::ChromaSubsampling::HorizontalAndVertical;
+            break;
+        default:
+            return std::nullopt;
+        }
+
+        emulation.Matrix = ycbcrMatrix;
+        emulation.LimitedRange = true;
+        return emulation;
+    }
 
-                    drawingSession.Flush();
-                    drawingSession.Close();
+    //
+    // Translates a frame into the CPU renderer's description of it, resolving each plane's placement and degamma the same
+    // way RenderPredictionFrame sets up its draw calls.
+    //
+    CpuRendering::CpuFrame CreateCpuFrame(const FrameInformation& frameInformation)
+    {
+        CpuRendering::CpuFrame cpuFrame;
+        cpuFrame.Width = (uint32_t)frameInformation.TargetModeSize.Width;
+        cpuFrame.Height = (uint32_t)frameInformation.TargetModeSize.Height;
+        cpuFrame.FillBackground = frameInformation.RenderMode == RenderMode::Target;
+        cpuFrame.BackgroundColor = {
+            frameInformation.BackgroundColor.x,
+            frameInformation.BackgroundColor.y,
+            frameInformation.BackgroundColor.z,
+            frameInformation.BackgroundColor.w};
+
+        cpuFrame.PostBlend = CreatePostBlendPipeline(frameInformation);
+        cpuFrame.Wire = CreateWireFormatEmulation(frameInformation);
+
+        const winrt::float3x2 sourceToTarget = SourceToTargetTransform(frameInformation);
+        const auto stretchFilter = EffectiveStretchFilter(frameInformation);
+
+        for (const auto& plane : frameInformation.Planes)
+        {
+            if (!plane.CpuSurface)
+            {
+                continue;
+            }
+
+            CpuRendering::CpuPlane cpuPlane;
+            cpuPlane.Surface = plane.CpuSurface;
+
+            switch (plane.AlphaMode)
+            {
+            case winrt::CanvasAlphaMode::Straight:
+                cpuPlane.AlphaMode = CpuRendering::PlaneAlphaMode::Straight;
+                break;
+            case winrt::CanvasAlphaMode::Ignore:
+                cpuPlane.AlphaMode = CpuRendering::PlaneAlphaMode::Ignore;
+                break;
+            default:
+                cpuPlane.AlphaMode = CpuRendering::PlaneAlphaMode::Premultiplied;
+                break;
+            }
+
+            // Per-Plane de-gamma
+            cpuPlane.DegammaCurve = CreatePlaneDegammaCurve(plane.ColorSpace);
+
+            const winrt::float3x2 planeToTarget = plane.TransformMatrix * sourceToTarget;
+            cpuPlane.Transform = {
+                planeToTarget.m11, planeToTarget.m12, planeToTarget.m21, planeToTarget.m22, planeToTarget.m31, planeToTarget.m32};
+
+            const winrt::Rect destinationRect = plane.DestinationRect.has_value()
+                                                    ? plane.DestinationRect.value()
+                                                    : winrt::Rect(winrt::Point(), frameInformation.SourceModeSize);
+            const winrt::Rect sourceRect = plane.SourceRect.has_value()
+                                               ? plane.SourceRect.value()
+                                               : winrt::Rect(0, 0, (float)plane.CpuSurface->Width(), (float)plane.CpuSurface->Height());
+
+            cpuPlane.DestinationRect = {
+                destinationRect.X, destinationRect.Y, destinationRect.X + destinationRect.Width, destinationRect.Y + destinationRect.Height};
+            cpuPlane.SourceRect = {sourceRect.X, sourceRect.Y, sourceRect.X + sourceRect.Width, sourceRect.Y + sourceRect.Height};
+
+            if (stretchFilter.has_value())
+            {
+                switch (stretchFilter.value())
+                {
+                case ScalingFilter::NearestNeighbor:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::NearestNeighbor;
+                    break;
+                case ScalingFilter::Bilinear:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::Linear;
+                    break;
+                case ScalingFilter::Bicubic:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::Cubic;
+                    break;
+                case ScalingFilter::Lanczos3:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::Lanczos3;
+                    break;
+                }
+            }
+            else
+            {
+                switch (plane.InterpolationMode)
+                {
+                case winrt::CanvasImageInterpolation::NearestNeighbor:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::NearestNeighbor;
+                    break;
+                case winrt::CanvasImageInterpolation::Cubic:
+                case winrt::CanvasImageInterpolation::HighQualityCubic:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::Cubic;
+                    break;
+                default:
+                    cpuPlane.Interpolation = CpuRendering::PlaneInterpolation::Linear;
+                    break;
                 }
+            }
 
-                auto buffer = winrt::Buffer(renderablePreview.SizeInPixels().Width * renderablePreview.SizeInPixels().Height * 4);
-                renderablePreview.GetPixelBytes(buffer);
+            // The clip is in the source mode's space, so only the source to target transform moves it
+            if (plane.ClipRect.has_value())
+            {
+                const winrt::Rect& clipRect = plane.ClipRect.value();
+                const winrt::float2 topLeft = winrt::transform(winrt::float2(clipRect.X, clipRect.Y), sourceToTarget);
+                const winrt::float2 bottomRight =
+                    winrt::transform(winrt::float2(clipRect.X + clipRect.Width, clipRect.Y + clipRect.Height), sourceToTarget);
+
+                cpuPlane.ClipRect = CpuRendering::PlaneRect{
+                    (std::min)(topLeft.x, bottomRight.x),
+                    (std::min)(topLeft.y, bottomRight.y),
+                    (std::max)(topLeft.x, bottomRight.x),
+                    (std::max)(topLeft.y, bottomRight.y)};
+            }
 
-                auto softwareBitmap = winrt::SoftwareBitmap::CreateCopyFromBuffer(
-                    buffer,
-                    winrt::BitmapPixelFormat::Rgba8,
-                    (int32_t)frameInformation.TargetModeSize.Width,
-                    (int32_t)frameInformation.TargetModeSize.Height);
+            cpuFrame.Planes.push_back(std::move(cpuPlane));
+        }
 
-                // Return the SoftwareBitmap
-                co_return softwareBitmap;
-            };
+        return cpuFrame;
+    }
 
-            auto softwareBitmapAsync = CreateSoftwareBitmapAsync();
+    //
+    // The process-wide cache of CPU rendered predictions. Runtime parameters can set its memory budget in MB
+    // (PredictionCacheSize, 0 disables it) and a folder that keeps predictions across runs (PredictionCacheFolder).
+    //
+    CpuRendering::PredictionCache& GetPredictionCache()
+    {
+        static CpuRendering::PredictionCache cache = [] {
+            double budgetInMegabytes = 1024;
+            if (RuntimeSettings().GetSettingValue(L"PredictionCacheSize"))
+            {
+                budgetInMegabytes = (std::max)(RuntimeSettings().GetSettingValueAsDouble(L"PredictionCacheSize"), 0.0);
+            }
 
-            // 3. Copy GPU surface to CPU-accessible memory
-            auto frameBytes = postBlendTarget.GetPixelBytes();
+            const std::wstring folder(RuntimeSettings().GetSettingValueAsString(L"PredictionCacheFolder"));
 
-            // 4. Slice CPU-accessible pixel data to the destination type (starting from 16 bit-per-channel floats)
-            auto frameBytesBufferWriter = winrt::DataWriter();
-            frameBytesBufferWriter.WriteBytes(frameBytes);
+            Logger().LogNote(std::format(
+                L"Prediction cache: {} MB in memory, {}", budgetInMegabytes, folder.empty() ? L"no disk cache" : L"disk cache in " + folder));
 
-            frame->SetBuffer(frameBytesBufferWriter.DetachBuffer());
-             
-            // 5. Ensure that the copy started in 2 is finished
-            frame->SetImageApproximation(softwareBitmapAsync.get());
+            return CpuRendering::PredictionCache(static_cast<size_t>(budgetInMegabytes * 1024 * 1024), folder);
+        }();
 
-            auto rawFrame = frame.as<winrt::IRawFrame>();
-            co_return rawFrame;
+        return cache;
+    }
+
+    //
+    // Describes everything about a frame that affects what the CPU renderer produces for it. Plane contents are hashed,
+    // so frames drawn the same way by different tool configurations (e.g. only the refresh rate differs) share a key.
+    //
+    CpuRendering::PredictionCacheKey CreatePredictionCacheKey(const FrameInformation& frameInformation)
+    {
+        CpuRendering::PredictionCacheKey key;
+        key.Add(CpuRendering::RendererVersion);
+
+        key.Add(frameInformation.TargetModeSize.Width);
+        key.Add(frameInformation.TargetModeSize.Height);
+        key.Add(frameInformation.SourceModeSize.Width);
+        key.Add(frameInformation.SourceModeSize.Height);
+        key.Add(frameInformation.SourceToTargetStretch);
+        key.Add(frameInformation.StretchFilter.has_value());
+        if (frameInformation.StretchFilter.has_value())
+        {
+            key.Add(frameInformation.StretchFilter.value());
+        }
+        key.Add(frameInformation.RenderMode);
+        key.Add(std::span<const float>(&frameInformation.BackgroundColor.x, 4));
+
+        for (const auto& plane : frameInformation.Planes)
+        {
+            // Planes without contents aren't rendered
+            if (!plane.CpuSurface)
+            {
+                continue;
+            }
+
+            key.Add(plane.Type);
+            key.Add(plane.AlphaMode);
+            key.Add(plane.ColorType);
+            key.Add(plane.ColorSpace);
+            key.Add(std::span<const float>(&plane.TransformMatrix.m11, 6));
+            key.Add(plane.SourceRect.has_value());
+            if (plane.SourceRect.has_value())
+            {
+                key.Add(std::span<const float>(&plane.SourceRect->X, 4));
+            }
+            key.Add(plane.DestinationRect.has_value());
+            if (plane.DestinationRect.has_value())
+            {
+                key.Add(std::span<const float>(&plane.DestinationRect->X, 4));
+            }
+            key.Add(plane.ClipRect.has_value());
+            if (plane.ClipRect.has_value())
+            {
+                key.Add(std::span<const float>(&plane.ClipRect->X, 4));
+            }
+            key.Add(plane.SdrWhiteLevel);
+            key.Add(plane.InterpolationMode);
+
+            const auto& surface = *plane.CpuSurface;
+            key.Add(surface.Format());
+            key.Add(surface.Width());
+            key.Add(surface.Height());
+            key.AddContent(surface.Row(0), surface.RowPitch() * surface.Height());
         }
+
+        key.Add(frameInformation.WireFormat != nullptr);
+        if (frameInformation.WireFormat)
+        {
+            key.Add(frameInformation.WireFormat.PixelEncoding());
+            key.Add(frameInformation.WireFormat.BitsPerChannel());
+            key.Add(frameInformation.WireFormat.ColorSpace());
+            key.Add(frameInformation.WireFormat.Eotf());
+            key.Add(frameInformation.WireFormat.HdrMetadata());
+            key.Add(frameInformation.EmulateWireFormat);
+        }
+
+        key.Add(std::span<const float>(frameInformation.GammaLut));
+        key.Add(std::span<const float>(&frameInformation.ColorMatrixXyz.m11, 16));
+
+        return key;
     }
 
-    /// <summary>
-    /// Allow co_awaiting on a collection. Note that this can be a collection of IAsyncActions _or_ IAsyncOperations,
-    /// the difference being whether you have to keep the collection around for results checking. Borrowed from
-    /// winrt::when_all
-    /// </summary>
-    template <typename T>
-    winrt::IAsyncAction when_all_container(T const& container)
+    //
+    // Renders the same pipeline as RenderPredictionFrame without Win2D. Rows of tiles are composed, color converted and
+    // encoded in parallel on the thread pool, so the frame is only held as tiles. Frames that have been rendered before
+    // are taken from the prediction cache instead, and frames of flat content are only described. When given the frame
+    // rendered just before this one, only what changed since is rendered and the rest of its tiles are shared.
+    //
+    winrt::IAsyncOperation<winrt::IRawFrame> RenderPredictionFrameOnCpu(
+        FrameInformation& frameInformation, const CpuRendering::CpuFrame* previousCpuFrame = nullptr, winrt::IRawFrame previousFrame = nullptr)
+    {
+        co_await winrt::resume_background();
+
+        const uint32_t width = (uint32_t)frameInformation.TargetModeSize.Width;
+        const uint32_t height = (uint32_t)frameInformation.TargetModeSize.Height;
+
+        auto frame = winrt::make_self<Frame>();
+        frame->Resolution(winrt::SizeInt32((int32_t)width, (int32_t)height));
+        frame->DataFormat(frameInformation.WireFormat);
+
+        const CpuRendering::CpuFrame cpuFrame = CreateCpuFrame(frameInformation);
+        const CpuRendering::CpuPredictionRenderer renderer(cpuFrame);
+        auto& pool = winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool::Default();
+
+        // Flat content is only described, comparisons work from the description and nothing is rendered unless the
+        // pixels are asked for
+        if (auto analyticFrame = renderer.RenderAnalytic())
+        {
+            frame->SetAnalyticFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::AnalyticFrame>(std::move(*analyticFrame)));
+            co_return frame.as<winrt::IRawFrame>();
+        }
+
+        auto& cache = GetPredictionCache();
+        std::optional<CpuRendering::PredictionCacheKey> key;
+        if (cache.Enabled())
+        {
+            key = CreatePredictionCacheKey(frameInformation);
+
+            // Each frame gets its own tiles rather than a copy of the full buffer, consumers that want the pixels get
+            // their own buffer made from them
+            if (auto cachedFrame = cache.Find(*key))
+            {
+                Logger().LogNote(L"Using a cached prediction for this frame");
+                frame->SetTiledFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame>(
+                    winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame::FromPixels(cachedFrame->ScRgb, width, height)));
+                co_return frame.as<winrt::IRawFrame>();
+            }
+        }
+
+        // Only the tiles touched by what changed since the previous frame are rendered. These frames aren't added to the
+        // cache, they already cost no more than the change does. Previous frames always come from this renderer.
+        const auto previousTiles = previousFrame ? winrt::get_self<Frame>(previousFrame)->Tiles() : nullptr;
+        if (previousTiles && previousCpuFrame)
+        {
+            if (const auto changed = CpuRendering::ChangedRegions(*previousCpuFrame, cpuFrame))
+            {
+                frame->SetTiledFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame>(
+                    renderer.RenderTiled(*previousTiles, *changed, pool)));
+                co_return frame.as<winrt::IRawFrame>();
+            }
+        }
+
+        if (!key)
+        {
+            frame->SetTiledFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame>(renderer.RenderTiled(pool)));
+            co_return frame.as<winrt::IRawFrame>();
+        }
+
+        auto renderedFrame = std::make_shared<CpuRendering::CachedPrediction>();
+        renderedFrame->Width = width;
+        renderedFrame->Height = height;
+        renderedFrame->ScRgb.resize(static_cast<size_t>(width) * height);
+
+        // Frames are read from their tiles, so no preview is made
+        renderer.Render(renderedFrame->ScRgb.data(), nullptr, pool);
+        cache.Insert(*key, renderedFrame);
+
+        frame->SetTiledFrame(std::make_shared<const winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame>(
+            winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame::FromPixels(renderedFrame->ScRgb, width, height)));
+
+        auto rawFrame = frame.as<winrt::IRawFrame>();
+        co_return rawFrame;
+    }
+
+    //
+    // Limits on rendering the frames of a prediction. Runtime parameters can set the memory that frames being rendered may
+    // use in MB (PredictionMemoryBudget) and how many render jobs run at once (PredictionWorkers).
+    //
+    struct RenderLimits
     {
-        for (auto&& action : container) co_await action;
+        size_t MemoryBudget;
+        size_t Workers;
+    };
+
+    RenderLimits GetRenderLimits()
+    {
+        double budgetInMegabytes = 4096;
+        if (RuntimeSettings().GetSettingValue(L"PredictionMemoryBudget"))
+        {
+            budgetInMegabytes = (std::max)(RuntimeSettings().GetSettingValueAsDouble(L"PredictionMemoryBudget"), 0.0);
+        }
+
+        double workers = 4;
+        if (RuntimeSettings().GetSettingValue(L"PredictionWorkers"))
+        {
+            workers = (std::max)(RuntimeSettings().GetSettingValueAsDouble(L"PredictionWorkers"), 1.0);
+        }
+
+        return {static_cast<size_t>(budgetInMegabytes * 1024 * 1024), static_cast<size_t>(workers)};
+    }
+
+    //
+    // The memory a frame needs while it is being rendered. Win2D holds two FP16 targets and the read back pixels while the
+    // tiles are made from them. The CPU renderer holds a full buffer when the frame is cached, the frame's tiles and
+    // the tiles of the frame before it, along with the CPU surfaces of the frame's planes until it is done.
+    //
+    size_t EstimateRenderBytes(const FrameInformation& frameInformation, bool onCpu)
+    {
+        const size_t pixels = static_cast<size_t>((std::max)(frameInformation.TargetModeSize.Width, 0)) *
+                              static_cast<size_t>((std::max)(frameInformation.TargetModeSize.Height, 0));
+
+        if (!onCpu)
+        {
+            return pixels * 4 * sizeof(uint64_t);
+        }
+
+        size_t bytes = pixels * 3 * sizeof(uint64_t);
+        for (const auto& plane : frameInformation.Planes)
+        {
+            if (plane.CpuSurface)
+            {
+                bytes += plane.CpuSurface->RowPitch() * plane.CpuSurface->Height();
+            }
+        }
+
+        return bytes;
+    }
+
+    //
+    // The frame most recently rendered on the CPU for a prediction, with the description it was rendered from, so the
+    // frame after it can be rendered on top of it. Only this one frame's planes are kept past its render.
+    //
+    struct LastCpuFrame
+    {
+        std::mutex Lock;
+        size_t Index = 0;
+        std::optional<CpuRendering::CpuFrame> Description;
+        winrt::IRawFrame Frame{nullptr};
+    };
+
+    //
+    // Renders one frame of a prediction. Without a device the frame is rendered on the CPU, on top of the frame before it
+    // if that one was already done when this one started. The frame's planes are released as soon as it is rendered. The
+    // operation holds on to the prediction, so it can safely outlive a caller that gave up waiting on it.
+    //
+    winrt::IAsyncOperation<winrt::IRawFrame> RenderPredictionFrameAsync(
+        winrt::com_ptr<PredictionData> predictionData, size_t index, winrt::CanvasDevice device, std::shared_ptr<LastCpuFrame> lastCpuFrame)
+    {
+        auto& frameInformation = predictionData->Frames()[index];
+
+        winrt::IRawFrame frame{nullptr};
+        if (device)
+        {
+            frame = co_await RenderPredictionFrame(frameInformation, device);
+        }
+        else
+        {
+            std::optional<CpuRendering::CpuFrame> previousCpuFrame;
+            winrt::IRawFrame previousFrame{nullptr};
+            {
+                std::lock_guard lock(lastCpuFrame->Lock);
+                if (lastCpuFrame->Frame && lastCpuFrame->Index + 1 == index)
+                {
+                    previousCpuFrame = lastCpuFrame->Description;
+                    previousFrame = lastCpuFrame->Frame;
+                }
+            }
+
+            frame = co_await RenderPredictionFrameOnCpu(frameInformation, previousCpuFrame ? &*previousCpuFrame : nullptr, previousFrame);
+
+            auto cpuFrame = CreateCpuFrame(frameInformation);
+            std::lock_guard lock(lastCpuFrame->Lock);
+            if (!lastCpuFrame->Frame || lastCpuFrame->Index < index)
+            {
+                lastCpuFrame->Index = index;
+                lastCpuFrame->Description = std::move(cpuFrame);
+                lastCpuFrame->Frame = frame;
+            }
+        }
+
+        for (auto& plane : frameInformation.Planes)
+        {
+            plane.CpuSurface = nullptr;
+            plane.Surface = nullptr;
+        }
+
+        co_return frame;
     }
 
     winrt::IAsyncOperation<winrt::IRawFrameSet> Prediction::FinalizePredictionAsync()
     {
+        // Frames are handed to the FrameRenderedCallback handlers long after this is called, so the prediction has to
+        // stay alive until they have all been
+        auto strongThis{get_strong()};
+
         // This operation is expected to be heavyweight, as tools are moving a lot of memory. So
         // we return the thread control and resume this function on the thread pool. The intent
         // is that during actual test operation, this can be queued up and happening behind the
@@ -620,10 +1365,6 @@ namespace PredictionRenderer {
 
         predictionData->Frames().resize(frameCount);
 
-        auto canvasDevice = predictionData->Device();
-
-        // TODO: Should have options for per-frame and collective callbacks
-
         // Invoke any tools registering as display setup (format, resolution, etc.)
         if (m_displaySetupCallback)
         {
@@ -647,18 +1388,54 @@ namespace PredictionRenderer {
         predictedFrames.Frames().Clear();
 
         {
-            // Render the predicted frames concurrently
-            std::vector<winrt::IAsyncOperation<winrt::IRawFrame>> frameRenderTasks;
-            for (auto& frame : predictionData->Frames())
+            auto& frames = predictionData->Frames();
+
+            // Every frame is a render job of its own. Jobs are started in order while there is a free worker and room in
+            // the memory budget, otherwise the oldest running job is waited on first. A job always runs when nothing else
+            // is, however large it is. Finished frames are taken in order: with FrameRenderedCallback handlers each one is
+            // handed to them and released once they return, otherwise it is added to the frame set. If a job fails the
+            // others are left to finish on their own, which is safe as they share ownership of what they use.
+            struct RenderJob
             {
-                frameRenderTasks.push_back(RenderPredictionFrame(frame, canvasDevice));
-            }
+                size_t Bytes;
+                winrt::IAsyncOperation<winrt::IRawFrame> Operation;
+            };
+
+            const RenderLimits limits = GetRenderLimits();
+            const auto lastCpuFrame = std::make_shared<LastCpuFrame>();
+            std::deque<RenderJob> runningJobs;
+            size_t bytesInFlight = 0;
 
-            // Wait for all of the render tasks to complete and collect the results
-            for (auto& frameRenderTask : frameRenderTasks)
+            for (size_t next = 0; next < frames.size() || !runningJobs.empty();)
             {
-                auto frame = co_await frameRenderTask;
-                predictedFrames.Frames().Append(frame);
+                if (next < frames.size())
+                {
+                    const bool onCpu = predictionData->RenderOnCpu() && CanRenderOnCpu(frames[next]);
+                    const size_t bytes = EstimateRenderBytes(frames[next], onCpu);
+                    if (runningJobs.empty() || (runningJobs.size() < limits.Workers && bytesInFlight + bytes <= limits.MemoryBudget))
+                    {
+                        bytesInFlight += bytes;
+                        runningJobs.push_back(
+                            {bytes,
+                             RenderPredictionFrameAsync(
+                                 predictionData, next, onCpu ? winrt::CanvasDevice{nullptr} : predictionData->Device(), lastCpuFrame)});
+                        next++;
+                        continue;
+                    }
+                }
+
+                auto frame = co_await runningJobs.front().Operation;
+                bytesInFlight -= runningJobs.front().Bytes;
+                runningJobs.pop_front();
+
+                if (m_frameRenderedCallback)
+                {
+                    m_frameRenderedCallback(*this, frame);
+                }
+                else
+                {
+                    predictedFrames.Frames().Append(frame);
+                }
             }
         }
 
@@ -695,4 +1472,14 @@ namespace PredictionRenderer {
         m_renderLoopCallback.remove(token);
     }
 
+    winrt::event_token Prediction::FrameRenderedCallback(winrt::EventHandler<winrt::IRawFrame> const& handler)
+    {
+        return m_frameRenderedCallback.add(handler);
+    }
+
+    void Prediction::FrameRenderedCallback(winrt::event_token const& token) noexcept
+    {
+        m_frameRenderedCallback.remove(token);
+    }
+
 } // namespace PredictionRenderer
\ No newline at end of file
@@ -69,80 +69,182 @@ export GammaType GetGammaTypeForColorSpace(const DXGI_COLOR_SPACE_TYPE colorSpac
     }
 }
 
-export std::vector<float> CreateGammaTransferCurve(
-    const GammaType sourceGamma, 
+/// <summary>
+/// The precision the entries of a transfer curve are stored with.
+/// </summary>
+export enum class TransferCurvePrecision { Float32, Float16 };
+
+// Transfer curves map between each curve's own normalized [0, 1] ranges. On the linear side 1.0 is reference white for
+// the SDR curves, 10000 nits for PQ and the peak scene light for HLG. This is the scRGB value of that 1.0.
+export float GetLinearScale(const GammaType gamma)
+{
+    switch (gamma)
+    {
+    case GammaType::G2084:
+        return 10000.0f / 80.0f;
+    case GammaType::GHLG:
+        // The nominal 1000 nit peak of the BT.2100 reference display, the HLG system gamma is not applied
+        return 1000.0f / 80.0f;
+    default:
+        return 1.0f;
+    }
+}
+
+// Encoded value to normalized linear light
+float Degamma(const GammaType gamma, float stop)
+{
+    switch (gamma)
+    {
+    case GammaType::G10:
+        return stop;
+    case GammaType::G22:
+        return stop <= 0.04045f ? stop / 12.92f : std::powf((stop + 0.055f) / 1.055f, 2.4f);
+    case GammaType::G709:
+        return stop < 0.081f ? stop / 4.5f : std::powf((stop + 0.099f) / 1.099f, 1.0f / 0.45f);
+    case GammaType::G24:
+        return (float)std::pow((double)stop, 2.4);
+    case GammaType::G2084:
+    {
+        // SMPTE ST 2084 EOTF
+        constexpr double m1 = 2610.0 / 16384.0, m2 = 2523.0 / 4096.0 * 128.0;
+        constexpr double c1 = 3424.0 / 4096.0, c2 = 2413.0 / 4096.0 * 32.0, c3 = 2392.0 / 4096.0 * 32.0;
+
+        const double power = std::pow((double)stop, 1.0 / m2);
+        return (float)std::pow((std::max)(power - c1, 0.0) / (c2 - c3 * power), 1.0 / m1);
+    }
+    case GammaType::GHLG:
+    {
+        // BT.2100 HLG inverse OETF
+        constexpr double a = 0.17883277, b = 1.0 - 4.0 * a, c = 0.55991073;
+
+        return (float)(stop <= 0.5f ? (double)stop * stop / 3.0 : (std::exp(((double)stop - c) / a) + b) / 12.0);
+    }
+    default:
+        throw winrt::hresult_invalid_argument();
+    }
+}
+
+// Normalized linear light to encoded value
+float Regamma(const GammaType gamma, float stop)
+{
+    switch (gamma)
+    {
+    case GammaType::G10:
+        return stop;
+    case GammaType::G22:
+        return stop <= 0.0031308f ? stop * 12.92f : 1.055f * std::powf(stop, 1.0f/2.4f) - 0.055f;
+    case GammaType::G709:
+        return stop < 0.018f ? stop * 4.5f : 1.099f * std::powf(stop, 0.45f) - 0.099f;
+    case GammaType::G24:
+        return (float)std::pow((double)stop, 1.0 / 2.4);
+    case GammaType::G2084:
+    {
+        // SMPTE ST 2084 inverse EOTF
+        constexpr double m1 = 2610.0 / 16384.0, m2 = 2523.0 / 4096.0 * 128.0;
+        constexpr double c1 = 3424.0 / 4096.0, c2 = 2413.0 / 4096.0 * 32.0, c3 = 2392.0 / 4096.0 * 32.0;
+
+        const double power = std::pow((double)(std::max)(stop, 0.0f), m1);
+        return (float)std::pow((c1 + c2 * power) / (1.0 + c3 * power), m2);
+    }
+    case GammaType::GHLG:
+    {
+        // BT.2100 HLG OETF
+        constexpr double a = 0.17883277, b = 1.0 - 4.0 * a, c = 0.55991073;
+
+        return (float)(stop <= 1.0f / 12.0f ? std::sqrt(3.0 * (std::max)(stop, 0.0f)) : a * std::log(12.0 * stop - b) + c);
+    }
+    default:
+        throw winrt::hresult_invalid_argument();
+    }
+}
+
+std::vector<float> BuildGammaTransferCurve(
+    const GammaType sourceGamma,
     const GammaType destGamma,
-    unsigned long gammaStops)
+    unsigned long gammaStops,
+    TransferCurvePrecision precision)
 {
     auto gammaArray = std::vector<float>(gammaStops);
 
-    if (sourceGamma == GammaType::G10)
+    // Between two non-linear curves the stops go through absolute light, so that e.g. PQ and 2.2 agree on where
+    // reference white is
+    const float scale = sourceGamma == GammaType::G10 || destGamma == GammaType::G10
+                            ? 1.0f
+                            : GetLinearScale(sourceGamma) / GetLinearScale(destGamma);
+
+    for (unsigned long i = 0; i < gammaStops; i++)
     {
-        // Re-gamma operation
-        switch (destGamma)
+        float stop = (float)i / (gammaStops - 1);
+
+        if (sourceGamma == GammaType::G10)
         {
-        case GammaType::G10:
-            for (unsigned int i = 0; i < gammaStops; i++)
-            {
-                gammaArray[i] = (float)i / (gammaStops - 1);
-            }
-            break;
-        case GammaType::G22:
-            for (unsigned int i = 0; i < gammaStops; i++)
-            {
-                float stop = (float)i / (gammaStops - 1);
-                gammaArray[i] = stop <= 0.0031308f ? stop * 12.92f : 1.055f * std::powf(stop, 1.0f/2.4f) - 0.055f;
-            }
-            break;
-        case GammaType::G709:
-            for (unsigned int i = 0; i < gammaStops; i++)
-            {
-                float stop = (float)i / (gammaStops - 1);
-                gammaArray[i] = stop < 0.018f ? stop * 4.5f : 1.099f * std::powf(stop, 0.45f) - 0.099f;
-            }
-            break;
-        default:
-            // Right now this explicitly only supports linear and 2.2
-            throw winrt::hresult_invalid_argument();
+            // Re-gamma operation
+            gammaArray[i] = Regamma(destGamma, stop);
         }
-    }
-    else if (destGamma == GammaType::G10)
-    {
-        // De-gamma operation
-        switch (sourceGamma)
+        else if (destGamma == GammaType::G10)
+        {
+            // De-gamma operation
+            gammaArray[i] = Degamma(sourceGamma, stop);
+        }
+        else
+        {
+            gammaArray[i] = Regamma(destGamma, Degamma(sourceGamma, stop) * scale);
+        }
+
+        if (precision == TransferCurvePrecision::Float16)
         {
-        case GammaType::G10:
-            for (unsigned long i = 0; i < gammaStops; i++)
-            {
-                gammaArray[i] = (float)i / (gammaStops - 1);
-            }
-            break;
-        case GammaType::G22:
-            for (unsigned long i = 0; i < gammaStops; i++)
-            {
-                float stop = (float)i / (gammaStops - 1);
-                gammaArray[i] = stop <= 0.04045f ? stop / 12.92f : std::powf((stop + 0.055f) / 1.055f, 2.4f);
-            }
-            break;
-        case GammaType::G709:
-            for (unsigned long i = 0; i < gammaStops; i++)
-            {
-                float stop = (float)i / (gammaStops - 1);
-                gammaArray[i] = stop < 0.081f ? stop / 4.5f : std::powf((stop + 0.099f) / 1.099f, 1.0f / 0.45f);
-            }
-            break;
-        default:
-            // Right now this explicitly only supports linear and 2.2
-            throw winrt::hresult_invalid_argument();
+            using namespace winrt::MicrosoftDisplayCaptureTools::Libraries;
+            gammaArray[i] = HalfFloat::ToFloat(HalfFloat::FromFloat(gammaArray[i]));
         }
     }
-    else
+
+    return gammaArray;
+}
+
+/// <summary>
+/// Returns the transfer curve between two gamma types, sampled at gammaStops evenly spaced stops. Curves are built once
+/// per process and shared, so callers must not modify them.
+/// </summary>
+export std::shared_ptr<const std::vector<float>> GetGammaTransferCurve(
+    const GammaType sourceGamma,
+    const GammaType destGamma,
+    unsigned long gammaStops,
+    TransferCurvePrecision precision = TransferCurvePrecision::Float32)
+{
+    if (gammaStops < 2)
     {
-        // Right now this explicitly only supports going to/from linear
         throw winrt::hresult_invalid_argument();
     }
 
-    return gammaArray;
+    using CurveKey = std::tuple<GammaType, GammaType, unsigned long, TransferCurvePrecision>;
+    static std::mutex curvesLock;
+    static std::map<CurveKey, std::shared_ptr<const std::vector<float>>> curves;
+
+    std::lock_guard lock(curvesLock);
+    auto& curve = curves[CurveKey(sourceGamma, destGamma, gammaStops, precision)];
+    if (!curve)
+    {
+        curve = std::make_shared<const std::vector<float>>(BuildGammaTransferCurve(sourceGamma, destGamma, gammaStops, precision));
+    }
+
+    return curve;
+}
+
+export std::vector<float> CreateGammaTransferCurve(
+    const GammaType sourceGamma, 
+    const GammaType destGamma,
+    unsigned long gammaStops)
+{
+    return *GetGammaTransferCurve(sourceGamma, destGamma, gammaStops);
+}
+
+/// <summary>
+/// Applies a transfer curve to values in place, interpolating linearly between its stops.
+/// </summary>
+export void ApplyTransferCurve(std::span<const float> curve, std::span<float> values)
+{
+    winrt::BasicDisplayConfiguration::Rendering::ApplyColorCurve(
+        curve, winrt::BasicDisplayConfiguration::Rendering::CurveLookup::Linear, values);
 }
 
 export winrt::com_ptr<IDXGISurface> GetNativeDxgiSurface(const winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DSurface& surface)
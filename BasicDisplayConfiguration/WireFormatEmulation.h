@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ColorPipeline.h"
+#include "WireFormatCoefficients.h"
+
+//
+// Emulation of what happens to a frame on its way over the display wire.
+//
+// The prediction is idealized linear color, but a sink only ever sees what the source encoded: values clipped to the
+// wire's primaries and peak (reference white for SDR, 10000 nits for PQ), run through its transfer function, converted
+// to YCbCr, averaged down to the wire's chroma resolution and quantized to its bit depth and range. The sink then
+// decodes that back to linear color. Emulating both halves makes the prediction carry the same error a correct capture
+// does, so captures can be held to a tight PSNR limit on non-RGB wire formats instead of it being loosened for every
+// test.
+//
+// The source half uses the standard forward transform, the sink half decodes exactly as the Tanager does (see
+// WireFormatCoefficients.h). Pixels go through a block at a time, one array per channel, so that every step is a
+// simple loop. The transfer functions are the expensive part, so runs of identical pixels, which most test content is
+// made of, only go through them once.
+//
+namespace winrt::BasicDisplayConfiguration::Rendering {
+
+    enum class ChromaSubsampling
+    {
+        // 4:4:4, every pixel carries its own chroma
+        None,
+        // 4:2:2, each pair of pixels along a row shares chroma
+        Horizontal,
+        // 4:2:0, each 2x2 block of pixels shares chroma
+        HorizontalAndVertical
+    };
+
+    // How color is carried over the wire. YCbCr formats have a matrix, RGB formats don't and can't be subsampled.
+    struct WireFormatEmulation
+    {
+        uint32_t BitDepth = 8;
+        bool LimitedRange = false;
+        ChromaSubsampling Subsampling = ChromaSubsampling::None;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::YcbcrMatrix Matrix =
+            MicrosoftDisplayCaptureTools::Libraries::WireFormat::YcbcrMatrix::None;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::TransferFunction Transfer =
+            MicrosoftDisplayCaptureTools::Libraries::WireFormat::TransferFunction::Bt709;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::ColorPrimaries Primaries =
+            MicrosoftDisplayCaptureTools::Libraries::WireFormat::ColorPrimaries::Bt709;
+
+        bool operator==(const WireFormatEmulation&) const = default;
+    };
+
+    class CompiledWireFormatEmulation
+    {
+    public:
+        explicit CompiledWireFormatEmulation(const WireFormatEmulation& format) :
+            m_isYcbcr(format.Matrix != MicrosoftDisplayCaptureTools::Libraries::WireFormat::YcbcrMatrix::None),
+            m_subsampling(m_isYcbcr ? format.Subsampling : ChromaSubsampling::None),
+            m_transfer(format.Transfer),
+            m_linearScale(MicrosoftDisplayCaptureTools::Libraries::WireFormat::GetLinearScale(format.Transfer))
+        {
+            namespace WireFormat = MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+            m_fromWirePrimaries = WireFormat::GetPrimariesMatrix(format.Primaries);
+            m_toWirePrimaries = WireFormat::InvertMatrix(m_fromWirePrimaries);
+            m_fromYcbcr = WireFormat::GetYcbcrMatrix(format.Matrix);
+            m_toYcbcr = WireFormat::InvertMatrix(m_fromYcbcr);
+
+            // Channels are in the order the sink reads them, R G B for RGB and Cb Y Cr for YCbCr
+            m_quantizers = {
+                WireFormat::GetQuantizerRange(format.BitDepth, format.LimitedRange, m_isYcbcr),
+                WireFormat::GetQuantizerRange(format.BitDepth, format.LimitedRange, false),
+                WireFormat::GetQuantizerRange(format.BitDepth, format.LimitedRange, m_isYcbcr)};
+
+            // The sink dequantizes each code with a lookup table, for RGB the transfer function is folded in too
+            const auto constants = WireFormat::GetDequantizerConstants(format.BitDepth, format.LimitedRange, m_isYcbcr);
+            const auto buildTable = [&](uint32_t min, uint32_t levels) {
+                std::vector<float> table(size_t(1) << format.BitDepth);
+                for (uint32_t code = 0; code < table.size(); code++)
+                {
+                    const float value = WireFormat::Dequantize(code, min, levels, constants.PeakForBitDepth);
+                    table[code] = m_isYcbcr ? value : WireFormat::Linearize(m_transfer, value);
+                }
+                return table;
+            };
+
+            m_dequantize = {
+                buildTable(constants.A_min, constants.A_levels),
+                buildTable(constants.B_min, constants.B_levels),
+                buildTable(constants.C_min, constants.C_levels)};
+        }
+
+        // Whether pairs of rows share chroma, in which case they have to go over the wire together
+        bool PairsRows() const
+        {
+            return m_subsampling == ChromaSubsampling::HorizontalAndVertical;
+        }
+
+        // Sends the first count pixels of a block of linear color over the wire and back, in place. The block starts on an
+        // even column. With 4:2:0, pairedBlock holds the same columns of the other row of the pair, or is null when the
+        // frame has no other row for it. Alpha is left alone.
+        void Apply(ColorBlock& block, ColorBlock* pairedBlock, size_t count) const
+        {
+            const bool paired = PairsRows() && pairedBlock;
+
+            WireBlock wire;
+            WireBlock pairedWire;
+            Encode(block, count, wire);
+            if (paired)
+            {
+                Encode(*pairedBlock, count, pairedWire);
+            }
+
+            // Chroma (A and C) is averaged over the pixels that share it
+            if (m_subsampling != ChromaSubsampling::None)
+            {
+                for (size_t i = 0; i < count; i += 2)
+                {
+                    const size_t next = (std::min)(i + 1, count - 1);
+                    const float pixels = (next != i ? 2.0f : 1.0f) * (paired ? 2.0f : 1.0f);
+
+                    float a = wire.A[i] + (next != i ? wire.A[next] : 0.0f);
+                    float c = wire.C[i] + (next != i ? wire.C[next] : 0.0f);
+                    if (paired)
+                    {
+                        a += pairedWire.A[i] + (next != i ? pairedWire.A[next] : 0.0f);
+                        c += pairedWire.C[i] + (next != i ? pairedWire.C[next] : 0.0f);
+                    }
+
+                    wire.A[i] = wire.A[next] = a / pixels;
+                    wire.C[i] = wire.C[next] = c / pixels;
+                    if (paired)
+                    {
+                        pairedWire.A[i] = pairedWire.A[next] = wire.A[i];
+                        pairedWire.C[i] = pairedWire.C[next] = wire.C[i];
+                    }
+                }
+            }
+
+            Quantize(wire, count);
+            if (paired)
+            {
+                Quantize(pairedWire, count);
+            }
+            else if (PairsRows())
+            {
+                // A last row without a partner is an even row, for which the sink reads Cr from the line below. There is
+                // none, so it reads this line's field again, which holds Cb.
+                std::copy(wire.A, wire.A + count, wire.C);
+            }
+
+            Decode(wire, count, block);
+            if (paired)
+            {
+                Decode(pairedWire, count, *pairedBlock);
+            }
+        }
+
+    private:
+        // The values on the wire, in the order the sink reads them (R G B or Cb Y Cr). Normalized to [0, 1] until they are
+        // quantized, after which they hold code values.
+        struct WireBlock
+        {
+            alignas(32) float A[ColorBlockSize];
+            alignas(32) float B[ColorBlockSize];
+            alignas(32) float C[ColorBlockSize];
+        };
+
+        static bool SameAsPrevious(const float* r, const float* g, const float* b, size_t i)
+        {
+            return i != 0 && r[i] == r[i - 1] && g[i] == g[i - 1] && b[i] == b[i - 1];
+        }
+
+        // Linear scRGB to normalized wire values, as the source does it
+        void Encode(const ColorBlock& block, size_t count, WireBlock& wire) const
+        {
+            namespace WireFormat = MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+            const auto& primaries = m_toWirePrimaries;
+            const auto& ycbcr = m_toYcbcr;
+
+            // The transfer function takes linear values normalized to its peak, which for PQ is far above scRGB's 1.0
+            const float toTransfer = 1.0f / m_linearScale;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (SameAsPrevious(block.R, block.G, block.B, i))
+                {
+                    wire.A[i] = wire.A[i - 1];
+                    wire.B[i] = wire.B[i - 1];
+                    wire.C[i] = wire.C[i - 1];
+                    continue;
+                }
+
+                // The wire can't carry anything outside of its primaries or above its peak
+                const float r = block.R[i] * toTransfer, g = block.G[i] * toTransfer, b = block.B[i] * toTransfer;
+                const float wireR = WireFormat::Encode(m_transfer, std::clamp(primaries[0][0] * r + primaries[0][1] * g + primaries[0][2] * b, 0.0f, 1.0f));
+                const float wireG = WireFormat::Encode(m_transfer, std::clamp(primaries[1][0] * r + primaries[1][1] * g + primaries[1][2] * b, 0.0f, 1.0f));
+                const float wireB = WireFormat::Encode(m_transfer, std::clamp(primaries[2][0] * r + primaries[2][1] * g + primaries[2][2] * b, 0.0f, 1.0f));
+
+                if (!m_isYcbcr)
+                {
+                    wire.A[i] = wireR;
+                    wire.B[i] = wireG;
+                    wire.C[i] = wireB;
+                    continue;
+                }
+
+                wire.A[i] = ycbcr[1][0] * wireR + ycbcr[1][1] * wireG + ycbcr[1][2] * wireB + 0.5f;
+                wire.B[i] = ycbcr[0][0] * wireR + ycbcr[0][1] * wireG + ycbcr[0][2] * wireB;
+                wire.C[i] = ycbcr[2][0] * wireR + ycbcr[2][1] * wireG + ycbcr[2][2] * wireB + 0.5f;
+            }
+        }
+
+        void Quantize(WireBlock& wire, size_t count) const
+        {
+            namespace WireFormat = MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                wire.A[i] = static_cast<float>(WireFormat::Quantize(wire.A[i], m_quantizers[0]));
+                wire.B[i] = static_cast<float>(WireFormat::Quantize(wire.B[i], m_quantizers[1]));
+                wire.C[i] = static_cast<float>(WireFormat::Quantize(wire.C[i], m_quantizers[2]));
+            }
+        }
+
+        // Code values back to linear scRGB, as the Tanager decoder does it
+        void Decode(const WireBlock& wire, size_t count, ColorBlock& block) const
+        {
+            namespace WireFormat = MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+            const auto& primaries = m_fromWirePrimaries;
+            const auto& ycbcr = m_fromYcbcr;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (SameAsPrevious(wire.A, wire.B, wire.C, i))
+                {
+                    block.R[i] = block.R[i - 1];
+                    block.G[i] = block.G[i - 1];
+                    block.B[i] = block.B[i - 1];
+                    continue;
+                }
+
+                float r = m_dequantize[0][static_cast<uint32_t>(wire.A[i])];
+                float g = m_dequantize[1][static_cast<uint32_t>(wire.B[i])];
+                float b = m_dequantize[2][static_cast<uint32_t>(wire.C[i])];
+
+                if (m_isYcbcr)
+                {
+                    const float luma = g;
+                    const float chromaB = r - 0.5f;
+                    const float chromaR = b - 0.5f;
+
+                    r = WireFormat::Linearize(m_transfer, ycbcr[0][0] * luma + ycbcr[0][1] * chromaB + ycbcr[0][2] * chromaR);
+                    g = WireFormat::Linearize(m_transfer, ycbcr[1][0] * luma + ycbcr[1][1] * chromaB + ycbcr[1][2] * chromaR);
+                    b = WireFormat::Linearize(m_transfer, ycbcr[2][0] * luma + ycbcr[2][1] * chromaB + ycbcr[2][2] * chromaR);
+                }
+
+                block.R[i] = (primaries[0][0] * r + primaries[0][1] * g + primaries[0][2] * b) * m_linearScale;
+                block.G[i] = (primaries[1][0] * r + primaries[1][1] * g + primaries[1][2] * b) * m_linearScale;
+                block.B[i] = (primaries[2][0] * r + primaries[2][1] * g + primaries[2][2] * b) * m_linearScale;
+            }
+        }
+
+        const bool m_isYcbcr;
+        const ChromaSubsampling m_subsampling;
+        const MicrosoftDisplayCaptureTools::Libraries::WireFormat::TransferFunction m_transfer;
+        const float m_linearScale;
+
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::Matrix m_toWirePrimaries;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::Matrix m_fromWirePrimaries;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::Matrix m_toYcbcr;
+        MicrosoftDisplayCaptureTools::Libraries::WireFormat::Matrix m_fromYcbcr;
+
+        std::array<MicrosoftDisplayCaptureTools::Libraries::WireFormat::QuantizerRange, 3> m_quantizers;
+        std::array<std::vector<float>, 3> m_dequantize;
+    };
+
+} // namespace winrt::BasicDisplayConfiguration::Rendering
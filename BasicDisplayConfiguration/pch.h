@@ -25,6 +25,7 @@
 #include "winrt/MicrosoftDisplayCaptureTools.Framework.h"
 #include "winrt/MicrosoftDisplayCaptureTools.ConfigurationTools.h"
 
+#include "DisplayToolComInterop.h"
 #include "TestRuntime.h"
 
 #include <map>
@@ -53,6 +54,16 @@
 // #include <Microsoft.Graphics.Canvas.h> // Can't be included without WinAppSDK
 #include <Microsoft.Graphics.Canvas.native.h>
 
+// Portable prediction rendering
+#include "ColorPipeline.h"
+#include "WireFormatEmulation.h"
+#include "CpuPredictionRenderer.h"
+#include "ContentCache.h"
+#include "PredictionCache.h"
+#include "PatternRasterizer.h"
+#include "BitmapBufferPool.h"
+#include "CursorConversion.h"
+
 namespace ABI::Microsoft::Graphics::Canvas {
 
 // Declare the ICanvasDevice interface since we can't include the real Microsoft.Graphics.Canvas.h header
@@ -12,13 +12,6 @@ enum class ComputeShaders
     //
     sRGB_8bpc_to_scRGB_16bpc,
 
-    // Frame Difference Computation
-    // -------------------------------------------
-    // This shader will take two frames and compute the squared difference between the individual pixels in a series of
-    // buckets that will then be summed together on the CPU side to compute a PSNR.
-    //
-    FrameSquaredDifferenceBucketSum,
-
     // Skip
     // -------------------------------------------
     // Not a real shader, this is just a hint used to indicate that the pipeline stage should be skipped.
@@ -37,9 +30,6 @@ public:
     winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame ProcessDataToFrame(
         winrt::Windows::Media::Capture::CapturedFrame frame);
 
-    double ComputePSNR(winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame target,
-				   winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame capture);
-
 private:
     FrameProcessor();
 
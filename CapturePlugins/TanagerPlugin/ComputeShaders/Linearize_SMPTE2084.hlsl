@@ -6,7 +6,7 @@ void main(uint3 DTid : SV_DispatchThreadID)
 {
     float4 color = inputTexture[DTid.xy];
     
-    color.xyz = pow(max(pow(color.xyz, (1 / 78.84375) - 0.8359375), 0) / 
+    color.xyz = pow(max(pow(color.xyz, (1 / 78.84375)) - 0.8359375, 0) / 
         (18.8515625 - 18.6875 * pow(color.xyz, (1 / 78.84375))), 1 / 0.1593017578);
     
     outputTexture[DTid.xy]= color;
@@ -34,6 +34,7 @@ namespace winrt::TanagerPlugin::implementation
         virtual winrt::hstring GetDeviceId() = 0;
         virtual std::vector<MicrosoftDisplayCaptureTools::CaptureCard::IDisplayInput> EnumerateDisplayInputs() = 0;
         virtual std::vector<byte> ReadEndPointData(UINT32 dataSize) = 0;
+        virtual std::unique_ptr<MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource> OpenEndPointDataStream(UINT32 dataSize) = 0;
         virtual std::vector<byte> FpgaRead(unsigned short address, UINT16 dataSize) = 0;
         virtual void FpgaWrite(unsigned short address, std::vector<byte> data) = 0;
 
@@ -45,6 +46,37 @@ namespace winrt::TanagerPlugin::implementation
         virtual MicrosoftDisplayCaptureTools::CaptureCard::ControllerFirmwareState GetFirmwareState() = 0;
     };
 
+    // Turns the FPGA read sequencer off once a frame has been read from a board, however the read ends. Anything left of
+    // the frame is dropped first, so that a failed decode doesn't leave data in the pipe for the next capture to read.
+    class ReadSequencerGuard
+    {
+    public:
+        ReadSequencerGuard(IMicrosoftCaptureBoard& board, MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource& source) :
+            m_board(board), m_source(source)
+        {
+        }
+
+        ReadSequencerGuard(const ReadSequencerGuard&) = delete;
+        ReadSequencerGuard& operator=(const ReadSequencerGuard&) = delete;
+
+        ~ReadSequencerGuard()
+        {
+            try
+            {
+                m_source.Discard();
+                m_board.FpgaWrite(0x10, std::vector<byte>({3}));
+            }
+            catch (...)
+            {
+                MicrosoftDisplayCaptureTools::Framework::Helpers::Logger().LogWarning(L"Failed to turn off the read sequencer after reading a frame.");
+            }
+        }
+
+    private:
+        IMicrosoftCaptureBoard& m_board;
+        MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource& m_source;
+    };
+
     struct Controller : ControllerT<Controller>
     {
         Controller();
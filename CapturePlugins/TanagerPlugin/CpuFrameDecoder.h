@@ -0,0 +1,497 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "HalfFloat.h"
+#include "WireFormatCoefficients.h"
+
+//
+// CPU implementation of the Tanager decode pipeline.
+//
+// This mirrors the compute shader pipeline in FrameProcessor (sampler -> dequantizer -> YCbCr -> linearize -> colorspace)
+// but runs every stage back-to-back on a small tile of a scanline, so the intermediates never leave the cache and no
+// full-resolution intermediate textures are needed. It only depends on the standard library so that it can be built and
+// validated on machines without a D3D stack.
+//
+// The coefficients of each stage are shared with the prediction's wire format emulation, see WireFormatCoefficients.h.
+//
+// Every supported combination of pixel layout, bit depth, range and color pipeline is compiled into its own kernel, so
+// all stage selection and matrix coefficients are resolved at compile time. A dispatch table picks the kernel once per
+// frame.
+//
+// Because the input to the dequantizer is one of at most 2^N code values, dequantization (and for RGB data also
+// linearization) is done with per-channel lookup tables. These are built once per format and shared between frames.
+//
+namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
+
+    // How pixels are packed into the 64-bit words read out of the Tanager's DRAM.
+    enum class RawPixelLayout
+    {
+        Rgb444,
+        Ycbcr444,
+        Ycbcr422,
+        Ycbcr420,
+    };
+
+    using Libraries::WireFormat::ColorPrimaries;
+    using Libraries::WireFormat::DequantizerConstants;
+    using Libraries::WireFormat::GetDequantizerConstants;
+    using Libraries::WireFormat::TransferFunction;
+    using Libraries::WireFormat::YcbcrMatrix;
+
+    struct CpuDecodeDescriptor
+    {
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t BitDepth;
+        bool LimitedRange;
+        RawPixelLayout Layout;
+        YcbcrMatrix Matrix;
+        TransferFunction Transfer;
+        ColorPrimaries Primaries;
+    };
+
+    // Everything that determines which decode kernel is used for a frame.
+    struct DecodeKernelKey
+    {
+        RawPixelLayout Layout;
+        uint32_t BitDepth;
+        bool LimitedRange;
+        YcbcrMatrix Matrix;
+        TransferFunction Transfer;
+        ColorPrimaries Primaries;
+
+        constexpr bool operator==(const DecodeKernelKey&) const = default;
+    };
+
+    // Per-channel tables mapping every code value straight to its dequantized value. For RGB data the transfer function is
+    // folded in as well, so the tables produce linear values.
+    struct CodeValueTables
+    {
+        std::vector<float> A;
+        std::vector<float> B;
+        std::vector<float> C;
+    };
+
+    // Everything that affects the contents of a set of code value tables.
+    struct CodeValueTablesKey
+    {
+        uint32_t BitDepth;
+        bool LimitedRange;
+        bool IsYcbcr;
+        TransferFunction Transfer;
+
+        constexpr auto operator<=>(const CodeValueTablesKey&) const = default;
+    };
+
+    namespace DecodeKernels {
+
+        using namespace Libraries::WireFormat;
+
+        // Matches the sRGB encode and float to uint conversion at the end of the colorspace shaders.
+        inline uint32_t EncodeSrgb8(float value)
+        {
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            value *= 255.0f;
+
+            if (!(value > 0.0f))
+            {
+                return 0;
+            }
+
+            return value >= 255.0f ? 255 : static_cast<uint32_t>(value);
+        }
+
+        // Reads a 64-bit word from the raw buffer, reads past the end of the buffer return 0 just like the structured
+        // buffer loads in the sampler shaders.
+        inline uint64_t ReadWord(std::span<const uint8_t> raw, size_t wordIndex)
+        {
+            if ((wordIndex + 1) * sizeof(uint64_t) > raw.size())
+            {
+                return 0;
+            }
+
+            uint64_t word;
+            std::memcpy(&word, raw.data() + wordIndex * sizeof(uint64_t), sizeof(word));
+            return word;
+        }
+
+        // Everything a kernel needs to know about the frame being decoded.
+        struct DecodeContext
+        {
+            uint32_t Width;
+            uint32_t Height;
+            std::span<const uint8_t> Raw;
+            const CodeValueTables* Tables;
+        };
+
+        template <DecodeKernelKey Key>
+        class DecodeKernel
+        {
+        public:
+            // Decodes rows [firstRow, firstRow + rowCount) of the raw frame. The outputs are full frame sized buffers,
+            // scRgb receives R16G16B16A16_FLOAT pixels and rgba8 receives the sRGB 8bpc approximation.
+            static void DecodeRows(
+                const DecodeContext& context, uint32_t firstRow, uint32_t rowCount, uint64_t* scRgb, uint32_t* rgba8)
+            {
+                const uint32_t width = context.Width;
+                const uint32_t lastRow = (std::min)(firstRow + rowCount, context.Height);
+                for (uint32_t row = firstRow; row < lastRow; row++)
+                {
+                    for (uint32_t x = 0; x < width; x += TileWidth)
+                    {
+                        const uint32_t count = (std::min)(TileWidth, width - x);
+
+                        Tile tile;
+                        Sample(context, row, x, count, tile);
+                        ConvertYcbcr(count, tile);
+                        Linearize(count, tile);
+                        ConvertPrimaries(count, tile);
+
+                        const size_t offset = static_cast<size_t>(row) * width + x;
+                        WriteOutput(count, tile, scRgb + offset, rgba8 + offset);
+                    }
+                }
+            }
+
+        private:
+            static constexpr uint32_t TileWidth = 64;
+
+            // The three channels of a tile, for YCbCr data these hold Cb, Y, Cr in that order until the YCbCr stage.
+            struct Tile
+            {
+                alignas(64) std::array<float, TileWidth> x;
+                alignas(64) std::array<float, TileWidth> y;
+                alignas(64) std::array<float, TileWidth> z;
+            };
+
+            // Each 64-bit word is made up of six 10-bit fields (with a 4-bit pad at the top). 8bpc data uses the top 8
+            // bits of each field.
+            static uint32_t Field(uint64_t word, uint32_t field)
+            {
+                const uint32_t value = static_cast<uint32_t>((word >> (field * 10)) & 0x3FF);
+                return value >> (10 - Key.BitDepth);
+            }
+
+            // Samples the raw data and converts each code value through the channel's lookup table.
+            static void Sample(const DecodeContext& context, uint32_t row, uint32_t x0, uint32_t count, Tile& tile)
+            {
+                const auto raw = context.Raw;
+                const size_t width = context.Width;
+                const uint32_t height = context.Height;
+                const float* tableA = context.Tables->A.data();
+                const float* tableB = context.Tables->B.data();
+                const float* tableC = context.Tables->C.data();
+
+                const size_t rowStart = static_cast<size_t>(row) * width;
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const size_t pixelIndex = rowStart + x0 + i;
+
+                    if constexpr (Key.Layout == RawPixelLayout::Rgb444 || Key.Layout == RawPixelLayout::Ycbcr444)
+                    {
+                        // Two pixels per word, pixel A in fields 0-2 and pixel B in fields 3-5
+                        const uint64_t word = ReadWord(raw, pixelIndex / 2);
+                        const uint32_t base = (pixelIndex % 2) * 3;
+                        tile.x[i] = tableA[Field(word, base + 0)];
+                        tile.y[i] = tableB[Field(word, base + 1)];
+                        tile.z[i] = tableC[Field(word, base + 2)];
+                    }
+                    else if constexpr (Key.Layout == RawPixelLayout::Ycbcr422)
+                    {
+                        // Two pixels per word sharing Cb (field 0) and Cr (field 3), Y in fields 1 and 4
+                        const uint64_t word = ReadWord(raw, pixelIndex / 2);
+                        tile.x[i] = tableA[Field(word, 0)];
+                        tile.y[i] = tableB[Field(word, (pixelIndex % 2) ? 4 : 1)];
+                        tile.z[i] = tableC[Field(word, 3)];
+                    }
+                    else if constexpr (Key.Layout == RawPixelLayout::Ycbcr420)
+                    {
+                        // Four pixels per word with Y in fields 1, 2, 4 and 5. Even lines carry Cb and odd lines carry
+                        // Cr in fields 0 and 3, so the other chroma channel comes from the line above or below.
+                        static constexpr uint32_t lumaFields[4] = {1, 2, 4, 5};
+                        const uint32_t intraPixel = (x0 + i) % 4;
+                        const uint32_t chromaField = intraPixel < 2 ? 0 : 3;
+
+                        const uint64_t current = ReadWord(raw, pixelIndex / 4);
+                        const uint64_t prevLine = row != 0 ? ReadWord(raw, (pixelIndex - width) / 4) : current;
+                        const uint64_t nextLine = row < height - 1 ? ReadWord(raw, (pixelIndex + width) / 4) : current;
+
+                        const bool evenLine = row % 2 == 0;
+                        tile.x[i] = tableA[Field(evenLine ? current : prevLine, chromaField)];
+                        tile.y[i] = tableB[Field(current, lumaFields[intraPixel])];
+                        tile.z[i] = tableC[Field(evenLine ? nextLine : current, chromaField)];
+                    }
+                }
+            }
+
+            static void ConvertYcbcr(uint32_t count, Tile& tile)
+            {
+                if constexpr (Key.Matrix != YcbcrMatrix::None)
+                {
+                    constexpr Matrix mat = GetYcbcrMatrix(Key.Matrix);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        // YCbCr values are read in CbYCr order, flip them to YCbCr.
+                        const float luma = tile.y[i];
+                        const float chromaB = tile.x[i] - 0.5f;
+                        const float chromaR = tile.z[i] - 0.5f;
+
+                        tile.x[i] = mat[0][0] * luma + mat[0][1] * chromaB + mat[0][2] * chromaR;
+                        tile.y[i] = mat[1][0] * luma + mat[1][1] * chromaB + mat[1][2] * chromaR;
+                        tile.z[i] = mat[2][0] * luma + mat[2][1] * chromaB + mat[2][2] * chromaR;
+                    }
+                }
+            }
+
+            static float LinearizeChannel(float value)
+            {
+                if constexpr (Key.Transfer == TransferFunction::Bt709)
+                {
+                    return LinearizeBt709(value);
+                }
+                else if constexpr (Key.Transfer == TransferFunction::OpRgb)
+                {
+                    return LinearizeOpRgb(value);
+                }
+                else
+                {
+                    return LinearizeSmpte2084(value);
+                }
+            }
+
+            static void Linearize(uint32_t count, Tile& tile)
+            {
+                // RGB data is already linearized by the lookup tables, YCbCr data has to go through the matrix first.
+                if constexpr (Key.Matrix != YcbcrMatrix::None)
+                {
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        tile.x[i] = LinearizeChannel(tile.x[i]);
+                        tile.y[i] = LinearizeChannel(tile.y[i]);
+                        tile.z[i] = LinearizeChannel(tile.z[i]);
+                    }
+                }
+            }
+
+            static void ConvertPrimaries(uint32_t count, Tile& tile)
+            {
+                if constexpr (Key.Primaries != ColorPrimaries::Bt709)
+                {
+                    constexpr Matrix mat = GetPrimariesMatrix(Key.Primaries);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        const float r = tile.x[i], g = tile.y[i], b = tile.z[i];
+                        tile.x[i] = mat[0][0] * r + mat[0][1] * g + mat[0][2] * b;
+                        tile.y[i] = mat[1][0] * r + mat[1][1] * g + mat[1][2] * b;
+                        tile.z[i] = mat[2][0] * r + mat[2][1] * g + mat[2][2] * b;
+                    }
+                }
+            }
+
+            static void WriteOutput(uint32_t count, const Tile& tile, uint64_t* scRgb, uint32_t* rgba8)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    scRgb[i] = Libraries::HalfFloat::PackRgba(tile.x[i], tile.y[i], tile.z[i], 1.0f);
+                    rgba8[i] = EncodeSrgb8(tile.x[i]) | (EncodeSrgb8(tile.y[i]) << 8) | (EncodeSrgb8(tile.z[i]) << 16) |
+                               0xFF000000;
+                }
+            }
+        };
+
+        using DecodeRowsFunction = void (*)(const DecodeContext&, uint32_t, uint32_t, uint64_t*, uint32_t*);
+
+        // The color pipelines that the Tanager shader selection can produce for RGB and for YCbCr data. Any other
+        // combination is rejected before getting here, so no kernels are generated for them.
+        struct ColorPipeline
+        {
+            YcbcrMatrix Matrix;
+            TransferFunction Transfer;
+            ColorPrimaries Primaries;
+        };
+
+        constexpr ColorPipeline RgbPipelines[] = {
+            {YcbcrMatrix::None, TransferFunction::Bt709, ColorPrimaries::Bt709},         // BT.709
+            {YcbcrMatrix::None, TransferFunction::Bt709, ColorPrimaries::Smpte170M},     // SMPTE 170M
+            {YcbcrMatrix::None, TransferFunction::OpRgb, ColorPrimaries::OpRgb},         // opRGB
+            {YcbcrMatrix::None, TransferFunction::Smpte2084, ColorPrimaries::Bt2020},    // BT.2020 RGB
+        };
+
+        constexpr ColorPipeline YcbcrPipelines[] = {
+            {YcbcrMatrix::Bt709, TransferFunction::Bt709, ColorPrimaries::Bt709},        // BT.709
+            {YcbcrMatrix::Bt601, TransferFunction::Bt709, ColorPrimaries::Smpte170M},    // SMPTE 170M
+            {YcbcrMatrix::Bt601, TransferFunction::OpRgb, ColorPrimaries::OpRgb},        // opYCC
+            {YcbcrMatrix::Bt2020, TransferFunction::Smpte2084, ColorPrimaries::Bt2020},  // BT.2020 YCbCr
+        };
+
+        constexpr RawPixelLayout SupportedLayouts[] = {
+            RawPixelLayout::Rgb444, RawPixelLayout::Ycbcr444, RawPixelLayout::Ycbcr422, RawPixelLayout::Ycbcr420};
+        constexpr uint32_t SupportedBitDepths[] = {8, 10};
+
+        constexpr size_t SupportedKernelCount =
+            std::size(SupportedLayouts) * std::size(SupportedBitDepths) * 2 * std::size(RgbPipelines);
+
+        constexpr std::array<DecodeKernelKey, SupportedKernelCount> SupportedKernels = [] {
+            static_assert(std::size(RgbPipelines) == std::size(YcbcrPipelines));
+
+            std::array<DecodeKernelKey, SupportedKernelCount> keys{};
+            size_t index = 0;
+            for (auto layout : SupportedLayouts)
+            {
+                for (auto bitDepth : SupportedBitDepths)
+                {
+                    for (bool limitedRange : {false, true})
+                    {
+                        for (auto& pipeline : layout == RawPixelLayout::Rgb444 ? RgbPipelines : YcbcrPipelines)
+                        {
+                            keys[index++] = {
+                                layout, bitDepth, limitedRange, pipeline.Matrix, pipeline.Transfer, pipeline.Primaries};
+                        }
+                    }
+                }
+            }
+            return keys;
+        }();
+
+        struct DispatchEntry
+        {
+            DecodeKernelKey Key;
+            DecodeRowsFunction DecodeRows;
+        };
+
+        template <size_t... Index>
+        constexpr auto MakeDispatchTable(std::index_sequence<Index...>)
+        {
+            return std::array<DispatchEntry, sizeof...(Index)>{
+                DispatchEntry{SupportedKernels[Index], &DecodeKernel<SupportedKernels[Index]>::DecodeRows}...};
+        }
+
+        inline constexpr auto DispatchTable = MakeDispatchTable(std::make_index_sequence<SupportedKernelCount>{});
+
+    } // namespace DecodeKernels
+
+    // Returns the (shared, immutable) code value tables for a format, building them on first use.
+    inline std::shared_ptr<const CodeValueTables> GetCodeValueTables(const CodeValueTablesKey& key)
+    {
+        static std::mutex cacheLock;
+        static std::map<CodeValueTablesKey, std::shared_ptr<const CodeValueTables>> cache;
+
+        auto lock = std::scoped_lock(cacheLock);
+        if (auto cached = cache.find(key); cached != cache.end())
+        {
+            return cached->second;
+        }
+
+        const auto constants = GetDequantizerConstants(key.BitDepth, key.LimitedRange, key.IsYcbcr);
+        const size_t codeCount = size_t(1) << key.BitDepth;
+
+        auto BuildTable = [&](uint32_t min, uint32_t levels) {
+            std::vector<float> table(codeCount);
+            for (uint32_t code = 0; code < codeCount; code++)
+            {
+                const float value = DecodeKernels::Dequantize(code, min, levels, constants.PeakForBitDepth);
+                table[code] = key.IsYcbcr ? value : DecodeKernels::Linearize(key.Transfer, value);
+            }
+            return table;
+        };
+
+        auto tables = std::make_shared<CodeValueTables>();
+        tables->A = BuildTable(constants.A_min, constants.A_levels);
+        tables->B = BuildTable(constants.B_min, constants.B_levels);
+        tables->C = BuildTable(constants.C_min, constants.C_levels);
+
+        cache[key] = tables;
+        return tables;
+    }
+
+    class CpuFrameDecoder
+    {
+    public:
+        explicit CpuFrameDecoder(const CpuDecodeDescriptor& descriptor) : m_descriptor(descriptor)
+        {
+            const DecodeKernelKey key{
+                descriptor.Layout,
+                descriptor.BitDepth,
+                descriptor.LimitedRange,
+                descriptor.Matrix,
+                descriptor.Transfer,
+                descriptor.Primaries};
+
+            for (auto& entry : DecodeKernels::DispatchTable)
+            {
+                if (entry.Key == key)
+                {
+                    m_decodeRows = entry.DecodeRows;
+                    break;
+                }
+            }
+
+            if (m_decodeRows != nullptr)
+            {
+                const bool isYcbcr = descriptor.Layout != RawPixelLayout::Rgb444;
+                m_tables = GetCodeValueTables({descriptor.BitDepth, descriptor.LimitedRange, isYcbcr, descriptor.Transfer});
+            }
+        }
+
+        const CpuDecodeDescriptor& Descriptor() const
+        {
+            return m_descriptor;
+        }
+
+        // Whether a decode kernel exists for the descriptor this decoder was created with.
+        bool IsSupported() const
+        {
+            return m_decodeRows != nullptr;
+        }
+
+        // Decodes rows [firstRow, firstRow + rowCount) of the raw frame. The outputs are full frame sized buffers, scRgb
+        // receives R16G16B16A16_FLOAT pixels and rgba8 receives the sRGB 8bpc approximation. Rows can be decoded in any
+        // order and from multiple threads as long as the row ranges don't overlap.
+        void DecodeRows(
+            std::span<const uint8_t> raw, uint32_t firstRow, uint32_t rowCount, uint64_t* scRgb, uint32_t* rgba8) const
+        {
+            const DecodeKernels::DecodeContext context{m_descriptor.Width, m_descriptor.Height, raw, m_tables.get()};
+            m_decodeRows(context, firstRow, rowCount, scRgb, rgba8);
+        }
+
+        // The number of leading rows that can be decoded once the first bytesAvailable bytes of the raw frame are in
+        // place. A 4:2:0 row also reads chroma from the line below it, so it has to wait for that line too.
+        uint32_t RowsAvailable(size_t bytesAvailable) const
+        {
+            if (m_descriptor.Width == 0)
+            {
+                return 0;
+            }
+
+            const size_t pixelsPerWord = m_descriptor.Layout == RawPixelLayout::Ycbcr420 ? 4 : 2;
+            const size_t completeRows = bytesAvailable / sizeof(uint64_t) * pixelsPerWord / m_descriptor.Width;
+            if (completeRows >= m_descriptor.Height)
+            {
+                return m_descriptor.Height;
+            }
+
+            if (m_descriptor.Layout == RawPixelLayout::Ycbcr420)
+            {
+                return completeRows == 0 ? 0 : static_cast<uint32_t>(completeRows - 1);
+            }
+
+            return static_cast<uint32_t>(completeRows);
+        }
+
+    private:
+        const CpuDecodeDescriptor m_descriptor;
+        DecodeKernels::DecodeRowsFunction m_decodeRows{nullptr};
+        std::shared_ptr<const CodeValueTables> m_tables;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
+
+    //
+    // Where the raw bytes of a captured frame come from. On hardware this is the FX3's bulk-in pipe, but anything that
+    // can hand out the frame in order (such as a recording of an earlier capture) can drive the decode.
+    //
+    class IFrameDataSource
+    {
+    public:
+        virtual ~IFrameDataSource() = default;
+
+        // Copies the next bytes of the frame into destination, blocking until at least one byte is available. Returns the
+        // number of bytes copied, 0 once the source has no more data.
+        virtual size_t Read(std::span<uint8_t> destination) = 0;
+
+        // Drops whatever is left of the frame, for when a read ends early. Nothing of this frame may be left to be read as
+        // the start of the next one.
+        virtual void Discard() = 0;
+    };
+
+    //
+    // Replays previously captured frame data in fixed size chunks, the way it arrives from the bulk-in pipe. An optional
+    // delay per chunk approximates the transfer rate of the real link, so streaming decode can be exercised without a
+    // capture board attached.
+    //
+    class RecordedFrameDataSource : public IFrameDataSource
+    {
+    public:
+        RecordedFrameDataSource(
+            std::vector<uint8_t> data, size_t chunkSize, std::chrono::microseconds chunkDelay = std::chrono::microseconds(0)) :
+            m_data(std::move(data)), m_chunkSize((std::max)(chunkSize, size_t(1))), m_chunkDelay(chunkDelay)
+        {
+        }
+
+        size_t Read(std::span<uint8_t> destination) override
+        {
+            const size_t count = (std::min)({destination.size(), m_chunkSize, m_data.size() - m_offset});
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            if (m_chunkDelay.count() != 0)
+            {
+                std::this_thread::sleep_for(m_chunkDelay);
+            }
+
+            std::memcpy(destination.data(), m_data.data() + m_offset, count);
+            m_offset += count;
+            return count;
+        }
+
+        void Discard() override
+        {
+            m_offset = m_data.size();
+        }
+
+    private:
+        const std::vector<uint8_t> m_data;
+        const size_t m_chunkSize;
+        const std::chrono::microseconds m_chunkDelay;
+        size_t m_offset = 0;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing
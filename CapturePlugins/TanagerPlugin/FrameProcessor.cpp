@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "FrameProcessor.h"
+#include "StreamingFrameDecoder.h"
+#include "ThreadPool.h"
+#include "CaptureComparison.h"
 
 namespace PrecompiledShaders {
 #include "ComputeShaders/Sampler_444_8bpc.h"
@@ -20,7 +23,6 @@ namespace PrecompiledShaders {
 #include "ComputeShaders/Color_SMPTE170M.h"
 #include "ComputeShaders/Color_opRGB.h"
 #include "ComputeShaders/Color_DCI_P3.h"
-#include "ComputeShaders/FrameSquaredDifferenceBucketSum.h"
 } // namespace PrecompiledShaders
 
 namespace winrt {
@@ -51,6 +53,7 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
 	FrameProcessor::FrameProcessor()
 	{
         bool useWarp = !RuntimeSettings().GetSettingValueAsBool(L"RenderOnHardware");
+        m_useCpuDecode = useWarp;
         D3D_DRIVER_TYPE driverType = useWarp ? D3D_DRIVER_TYPE_WARP : D3D_DRIVER_TYPE_HARDWARE;
 
         UINT uCreationFlags = D3D11_CREATE_DEVICE_SINGLETHREADED;
@@ -168,14 +171,6 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
                 PrecompiledShaders::Color_DCI_P3, sizeof(PrecompiledShaders::Color_DCI_P3), nullptr, shader.put()));
             break;
             
-        case ComputeShaders::FrameSquaredDifferenceBucketSum:
-            winrt::check_hresult(m_d3dDevice->CreateComputeShader(
-                PrecompiledShaders::FrameSquaredDifferenceBucketSum,
-                sizeof(PrecompiledShaders::FrameSquaredDifferenceBucketSum),
-                nullptr,
-                shader.put()));
-            break;
-
         default:
 			Logger().LogAssert(L"Attempted to load an unimplemented shader");
 			throw winrt::hresult_not_implemented();
@@ -358,6 +353,230 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
 		}
     }
 
+    CpuDecodeDescriptor FrameProcessor::GetCpuDecodeDescriptor(
+        IteIt68051Plugin::VideoTiming* timing, IteIt68051Plugin::AviInfoframe* aviInfoframe, IteIt68051Plugin::ColorInformation* colorInfo)
+    {
+        CpuDecodeDescriptor descriptor{};
+        descriptor.Width = static_cast<uint32_t>(timing->hActive);
+        descriptor.Height = static_cast<uint32_t>(timing->vActive);
+        descriptor.BitDepth = colorInfo->outputColorInfo.colorDepth;
+        descriptor.LimitedRange = aviInfoframe->GetPixelRange() != IteIt68051Plugin::AviPixelRange::Full;
+
+        // Use the same selection logic as the shader pipeline, so that both paths support (and reject) the same formats.
+        switch (GetSamplerShader(timing, aviInfoframe, colorInfo))
+        {
+        case ComputeShaders::Sampler_444_8bpc:
+        case ComputeShaders::Sampler_444_10bpc:
+            descriptor.Layout = aviInfoframe->GetColorFormat() == IteIt68051Plugin::AviColorFormat::RGB ? RawPixelLayout::Rgb444
+                                                                                                       : RawPixelLayout::Ycbcr444;
+            break;
+        case ComputeShaders::Sampler_422_8bpc:
+        case ComputeShaders::Sampler_422_10bpc:
+            descriptor.Layout = RawPixelLayout::Ycbcr422;
+            break;
+        case ComputeShaders::Sampler_420_8bpc:
+        case ComputeShaders::Sampler_420_10bpc:
+            descriptor.Layout = RawPixelLayout::Ycbcr420;
+            break;
+        default:
+            Logger().LogAssert(L"Unexpected sampler selected for CPU decode.");
+            throw winrt::hresult_not_implemented();
+        }
+
+        switch (GetColorFormatShader(timing, aviInfoframe, colorInfo))
+        {
+        case ComputeShaders::Skip:
+            descriptor.Matrix = YcbcrMatrix::None;
+            break;
+        case ComputeShaders::Ycbcr_ITUR_BT601:
+            descriptor.Matrix = YcbcrMatrix::Bt601;
+            break;
+        case ComputeShaders::Ycbcr_ITUR_BT709:
+            descriptor.Matrix = YcbcrMatrix::Bt709;
+            break;
+        case ComputeShaders::Ycbcr_ITUR_BT2020:
+            descriptor.Matrix = YcbcrMatrix::Bt2020;
+            break;
+        default:
+            Logger().LogAssert(L"Unexpected color format conversion selected for CPU decode.");
+            throw winrt::hresult_not_implemented();
+        }
+
+        switch (GetTransferFunctionShader(timing, aviInfoframe, colorInfo))
+        {
+        case ComputeShaders::Linearize_ITUR_BT709:
+            descriptor.Transfer = TransferFunction::Bt709;
+            break;
+        case ComputeShaders::Linearize_opRGB:
+            descriptor.Transfer = TransferFunction::OpRgb;
+            break;
+        case ComputeShaders::Linearize_SMPTE2084:
+            descriptor.Transfer = TransferFunction::Smpte2084;
+            break;
+        default:
+            Logger().LogAssert(L"Unexpected transfer function selected for CPU decode.");
+            throw winrt::hresult_not_implemented();
+        }
+
+        switch (GetColorspaceShader(timing, aviInfoframe, colorInfo))
+        {
+        case ComputeShaders::Color_ITUR_709:
+            descriptor.Primaries = ColorPrimaries::Bt709;
+            break;
+        case ComputeShaders::Color_SMPTE170M:
+            descriptor.Primaries = ColorPrimaries::Smpte170M;
+            break;
+        case ComputeShaders::Color_ITUR_2020:
+            descriptor.Primaries = ColorPrimaries::Bt2020;
+            break;
+        case ComputeShaders::Color_opRGB:
+            descriptor.Primaries = ColorPrimaries::OpRgb;
+            break;
+        case ComputeShaders::Color_DCI_P3:
+            descriptor.Primaries = ColorPrimaries::DciP3;
+            break;
+        default:
+            Logger().LogAssert(L"Unexpected colorspace conversion selected for CPU decode.");
+            throw winrt::hresult_not_implemented();
+        }
+
+        return descriptor;
+    }
+
+    winrt::IRawFrame FrameProcessor::ProcessDataToFrameOnCpu(
+        IteIt68051Plugin::VideoTiming* timing,
+        IteIt68051Plugin::AviInfoframe* aviInfoframe,
+        IteIt68051Plugin::ColorInformation* colorInfo,
+        std::span<uint8_t> data,
+        IFrameDataSource* source)
+    {
+        // This will log errors and throw if the frame's data can't be processed, exactly as the shader selection does.
+        const CpuFrameDecoder decoder(GetCpuDecodeDescriptor(timing, aviInfoframe, colorInfo));
+        if (!decoder.IsSupported())
+        {
+            Logger().LogError(L"No CPU decode kernel available for this color format, bit depth and colorimetry.");
+            throw winrt::hresult_not_implemented();
+        }
+
+        const uint32_t width = decoder.Descriptor().Width;
+        const uint32_t height = decoder.Descriptor().Height;
+        if (width == 0 || height == 0)
+        {
+            Logger().LogError(L"Invalid timing passed to ProcessDataToFrameOnCpu.");
+            throw winrt::hresult_invalid_argument();
+        }
+
+        winrt::Buffer scRGBBuffer(width * height * sizeof(uint64_t));
+        scRGBBuffer.Length(scRGBBuffer.Capacity());
+
+        winrt::Buffer rgba8Buffer(width * height * sizeof(uint32_t));
+        rgba8Buffer.Length(rgba8Buffer.Capacity());
+
+        // The decoder doesn't hold any per-frame state, so bands of rows are decoded concurrently on the shared thread
+        // pool without taking the D3D rendering lock. There are several bands per worker so that work stealing can even
+        // out bands that take longer than others. Bands are also kept small so that when streaming, little is left to
+        // decode once the last of the data has arrived.
+        auto& threadPool = Libraries::ThreadPool::Default();
+        const uint32_t rowsPerBand = std::clamp(height / (threadPool.ThreadCount() * 4), 1u, MaxCpuDecodeRowsPerBand);
+
+        StreamingFrameDecoder streamingDecoder(
+            decoder,
+            data,
+            reinterpret_cast<uint64_t*>(scRGBBuffer.data()),
+            reinterpret_cast<uint32_t*>(rgba8Buffer.data()),
+            threadPool,
+            rowsPerBand);
+
+        const auto decodeStart = std::chrono::steady_clock::now();
+        if (source != nullptr)
+        {
+            const size_t received = streamingDecoder.Receive(*source);
+            if (received != data.size())
+            {
+                Logger().LogError(
+                    winrt::hstring(L"Frame data ended early, expected ") + std::to_wstring(data.size()) + L" bytes, received " +
+                    std::to_wstring(received));
+                throw winrt::hresult_error(E_UNEXPECTED);
+            }
+        }
+        const auto dataEnd = std::chrono::steady_clock::now();
+        streamingDecoder.Finish();
+        const auto decodeEnd = std::chrono::steady_clock::now();
+
+        const double decodeTime = std::chrono::duration<double, std::milli>(decodeEnd - decodeStart).count();
+        const double tailTime = std::chrono::duration<double, std::milli>(decodeEnd - dataEnd).count();
+        const auto& bandTimes = streamingDecoder.BandTimes();
+        const auto& bandWorkers = streamingDecoder.BandWorkers();
+
+        auto renderableApproximation = winrt::SoftwareBitmap::CreateCopyFromBuffer(
+            rgba8Buffer, winrt::BitmapPixelFormat::Rgba8, timing->hActive, timing->vActive);
+
+        auto frame = winrt::make<Frame>(winrt::SizeInt32{timing->hActive, timing->vActive}, scRGBBuffer, renderableApproximation);
+
+        // Record how the decode was spread across the pool, so scaling can be checked on machines with many cores. When
+        // streaming, the decode time includes waiting on the transfer and the tail time is how long decoding continued
+        // after the last of the data arrived.
+        {
+            auto properties = frame.Properties();
+            properties.Insert(L"CpuDecodeTimeMs", winrt::box_value(decodeTime));
+            properties.Insert(L"CpuDecodeStreamed", winrt::box_value(source != nullptr));
+            properties.Insert(L"CpuDecodeTailTimeMs", winrt::box_value(tailTime));
+            properties.Insert(L"CpuDecodeThreadCount", winrt::box_value(threadPool.ThreadCount()));
+            properties.Insert(L"CpuDecodeRowsPerBand", winrt::box_value(rowsPerBand));
+            properties.Insert(L"CpuDecodeBandTimesMs", winrt::PropertyValue::CreateDoubleArray(bandTimes));
+            properties.Insert(L"CpuDecodeBandWorkers", winrt::PropertyValue::CreateUInt32Array(bandWorkers));
+
+            const auto [fastestBand, slowestBand] = std::minmax_element(bandTimes.begin(), bandTimes.end());
+            Logger().LogNote(
+                winrt::hstring(source != nullptr ? L"Streamed CPU decode took " : L"CPU decode took ") +
+                std::to_wstring(decodeTime) + L"ms (" + std::to_wstring(tailTime) + L"ms after the last data) using " +
+                std::to_wstring(threadPool.ThreadCount()) + L" threads, " + std::to_wstring(streamingDecoder.BandCount()) +
+                L" bands of " + std::to_wstring(rowsPerBand) + L" rows (fastest band " + std::to_wstring(*fastestBand) +
+                L"ms, slowest " + std::to_wstring(*slowestBand) + L"ms)");
+        }
+
+        return frame;
+    }
+
+    winrt::IRawFrame FrameProcessor::ProcessDataStreamToFrame(
+        IteIt68051Plugin::VideoTiming* timing,
+        IteIt68051Plugin::AviInfoframe* aviInfoframe,
+        IteIt68051Plugin::ColorInformation* colorInfo,
+        IFrameDataSource& source,
+        uint32_t size)
+    {
+        if (timing == nullptr || aviInfoframe == nullptr || colorInfo == nullptr || size == 0)
+        {
+            Logger().LogError(L"Invalid arguments passed to ProcessDataStreamToFrame.");
+            throw winrt::hresult_invalid_argument();
+        }
+
+        std::vector<uint8_t> data(size);
+        if (m_useCpuDecode)
+        {
+            // Decode bands of rows as soon as the data for them has arrived
+            return ProcessDataToFrameOnCpu(timing, aviInfoframe, colorInfo, data, &source);
+        }
+
+        // The shader pipeline needs the whole frame up front
+        size_t received = 0;
+        while (received < data.size())
+        {
+            const size_t bytesRead = source.Read(std::span(data).subspan(received));
+            if (bytesRead == 0)
+            {
+                Logger().LogError(
+                    winrt::hstring(L"Frame data ended early, expected ") + std::to_wstring(data.size()) + L" bytes, received " +
+                    std::to_wstring(received));
+                throw winrt::hresult_error(E_UNEXPECTED);
+            }
+
+            received += bytesRead;
+        }
+
+        return ProcessDataToFrame(timing, aviInfoframe, colorInfo, data.data(), size);
+    }
+
 	winrt::IRawFrame FrameProcessor::ProcessDataToFrame(
 		IteIt68051Plugin::VideoTiming* timing,
 		IteIt68051Plugin::AviInfoframe* aviInfoframe,
@@ -371,6 +590,11 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
 			throw winrt::hresult_invalid_argument();
 		}
 
+        if (m_useCpuDecode)
+        {
+            return ProcessDataToFrameOnCpu(timing, aviInfoframe, colorInfo, std::span(data, size), nullptr);
+        }
+
         // We don't want to be doing running multiple shader passes on the same device at the same time.
 		auto lock = std::scoped_lock(m_d3dRenderingMutex);
 
@@ -470,63 +694,18 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
             winrt::check_hresult(m_d3dDevice->CreateUnorderedAccessView(dequantizedData.get(), &uavDesc, dequantizedDataView.put()));
 
             // The constant buffer definition for the dequantizer shader indicates how many levels there are for
-            // each channel, what the peak value is, and what the minimum quantized value is.
-            //
-            // Peak = 2^N (where N is the bit depth)
-            // Levels = how many levels has the output been quantized to (Generally 219*N^(N-8))
-            // Min = what is the minimum value that the output has been quantized to (generally 16*N^(N-8))
-            struct DequantizerConstantBuffer
-            {
-                uint32_t PeakForBitDepth;
-                uint32_t A_min, A_levels;
-                uint32_t B_min, B_levels;
-                uint32_t C_min, C_levels;
-                uint32_t pad; // included because CS constant buffers must be 16-byte aligned
-            };
-
-            auto ConstantBuffer = std::make_shared<DequantizerConstantBuffer>();
-
-            uint32_t bitDepth = colorInfo->outputColorInfo.colorDepth;
-            ConstantBuffer->PeakForBitDepth = (uint32_t)pow(2, bitDepth) - 1;
-            
-            if (aviInfoframe->GetPixelRange() == IteIt68051Plugin::AviPixelRange::Full)
-            {
-                ConstantBuffer->A_min = 0;
-                ConstantBuffer->A_levels = ConstantBuffer->PeakForBitDepth;
-
-                ConstantBuffer->B_min = 0;
-                ConstantBuffer->B_levels = ConstantBuffer->PeakForBitDepth;
-
-                ConstantBuffer->C_min = 0;
-                ConstantBuffer->C_levels = ConstantBuffer->PeakForBitDepth;
-            }
-            else
-            {
-                uint32_t bitDepthModifier = (uint32_t)pow(2, bitDepth - 8);
-                ConstantBuffer->A_min = 16 * bitDepthModifier;
-                ConstantBuffer->A_levels = (235 - 16) * bitDepthModifier;
-
-                switch (aviInfoframe->GetColorFormat())
-                {
-                case IteIt68051Plugin::AviColorFormat::RGB:
-                    ConstantBuffer->B_min = 16 * bitDepthModifier;
-                    ConstantBuffer->B_levels = (235 - 16) * bitDepthModifier;
-                    ConstantBuffer->C_min = 16 * bitDepthModifier;
-                    ConstantBuffer->C_levels = (235 - 16) * bitDepthModifier;
-                    break;
-                default:
-                    ConstantBuffer->B_min = 16 * bitDepthModifier;
-                    ConstantBuffer->B_levels = (240 - 16) * bitDepthModifier;
-                    ConstantBuffer->C_min = 16 * bitDepthModifier;
-                    ConstantBuffer->C_levels = (240 - 16) * bitDepthModifier;
-                }
-            }
+            // each channel, what the peak value is, and what the minimum quantized value is. These are shared with the
+            // CPU decoder so that both paths dequantize identically.
+            auto ConstantBuffer = std::make_shared<DequantizerConstants>(GetDequantizerConstants(
+                colorInfo->outputColorInfo.colorDepth,
+                aviInfoframe->GetPixelRange() != IteIt68051Plugin::AviPixelRange::Full,
+                aviInfoframe->GetColorFormat() != IteIt68051Plugin::AviColorFormat::RGB));
 
             D3D11_BUFFER_DESC desc = {};
             desc.Usage = D3D11_USAGE_DYNAMIC;
             desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
             desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-            desc.ByteWidth = sizeof(DequantizerConstantBuffer);
+            desc.ByteWidth = sizeof(DequantizerConstants);
             desc.MiscFlags = 0;
             desc.StructureByteStride = 0;
 
@@ -725,182 +904,58 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
         return winrt::make<Frame>(winrt::SizeInt32{timing->hActive, timing->vActive}, scRGBBuffer, renderableApproximation);
     }
 
-    static winrt::IAsyncOperation<double> AddPixelSums(std::span<float> pixelSums)
-    {
-        co_await winrt::resume_background();
-
-        double sum = 0.0;
-        for (uint32_t i = 0; i < pixelSums.size(); i++)
-        {
-            sum += pixelSums[i];
-        }
-
-        co_return sum;
-    }
-
-    double FrameProcessor::ComputePSNR(winrt::IRawFrame target, winrt::IRawFrame capture)
+    // Create a single frame capture object from the raw captured data.
+    TanagerDisplayCapture::TanagerDisplayCapture(
+        std::vector<byte> pixels,
+        IteIt68051Plugin::VideoTiming* timing,
+        IteIt68051Plugin::AviInfoframe* aviInfoframe,
+        IteIt68051Plugin::ColorInformation* colorInfo)
     {
-        if (target == nullptr || capture == nullptr)
+        if (timing == nullptr || aviInfoframe == nullptr || colorInfo == nullptr || pixels.empty())
         {
-            Logger().LogError(L"Invalid arguments passed to ComputePSNR.");
+            Logger().LogError(L"Invalid arguments passed to TanagerDisplayCapture constructor");
             throw winrt::hresult_invalid_argument();
         }
 
-        auto lock = std::scoped_lock(m_d3dRenderingMutex);
-
-
-        winrt::com_ptr<ID3D11Texture2D> targetTexture{nullptr};
-        winrt::com_ptr<ID3D11ShaderResourceView> targetTextureView{nullptr};
-        {
-            D3D11_TEXTURE2D_DESC textureDesc = {};
-            textureDesc.Width = target.Resolution().Width;
-            textureDesc.Height = target.Resolution().Height;
-            textureDesc.MipLevels = 1;
-            textureDesc.ArraySize = 1;
-            textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-            textureDesc.SampleDesc.Count = 1;
-            textureDesc.SampleDesc.Quality = 0;
-            textureDesc.Usage = D3D11_USAGE_DEFAULT;
-            textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-            textureDesc.CPUAccessFlags = 0;
-            textureDesc.MiscFlags = 0;
-
-            D3D11_SUBRESOURCE_DATA InitData = {};
-            InitData.pSysMem = target.Data().data();
-            InitData.SysMemPitch = target.Resolution().Width * sizeof(uint64_t);
-            InitData.SysMemSlicePitch = 0;
-            winrt::check_hresult(m_d3dDevice->CreateTexture2D(&textureDesc, &InitData, targetTexture.put()));
-
-            // Create target texture SRV
-            D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-            srvDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-            srvDesc.Texture2D.MipLevels = 1;
-            winrt::check_hresult(m_d3dDevice->CreateShaderResourceView(targetTexture.get(), &srvDesc, targetTextureView.put()));
-        }
-
-        winrt::com_ptr<ID3D11Texture2D> captureTexture{nullptr};
-        winrt::com_ptr<ID3D11ShaderResourceView> captureTextureView{nullptr};
+        // Process the frame data
         {
-            D3D11_TEXTURE2D_DESC textureDesc = {};
-            textureDesc.Width = capture.Resolution().Width;
-            textureDesc.Height = capture.Resolution().Height;
-            textureDesc.MipLevels = 1;
-            textureDesc.ArraySize = 1;
-            textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-            textureDesc.SampleDesc.Count = 1;
-            textureDesc.SampleDesc.Quality = 0;
-            textureDesc.Usage = D3D11_USAGE_DEFAULT;
-            textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-            textureDesc.CPUAccessFlags = 0;
-            textureDesc.MiscFlags = 0;
+            m_frames = winrt::single_threaded_vector<winrt::IRawFrame>();
 
-            D3D11_SUBRESOURCE_DATA InitData = {};
-            InitData.pSysMem = capture.Data().data();
-            InitData.SysMemPitch = capture.Resolution().Width * sizeof(uint64_t);
-            InitData.SysMemSlicePitch = 0;
-            winrt::check_hresult(m_d3dDevice->CreateTexture2D(&textureDesc, &InitData, captureTexture.put()));
+            auto frame = FrameProcessor::GetInstance().ProcessDataToFrame(
+                timing, aviInfoframe, colorInfo, pixels.data(), static_cast<uint32_t>(pixels.size()));
 
-            // Create target texture SRV
-            D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-            srvDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-            srvDesc.Texture2D.MipLevels = 1;
-            winrt::check_hresult(m_d3dDevice->CreateShaderResourceView(captureTexture.get(), &srvDesc, captureTextureView.put()));
+            m_frames.Append(frame);
         }
 
-        uint32_t numPixels = capture.Resolution().Width * capture.Resolution().Height;
-
-        // The buffer and view that will hold the output of the summing shader
-        winrt::com_ptr<ID3D11Texture2D> sumTexture{nullptr};
-        winrt::com_ptr<ID3D11UnorderedAccessView> sumTextureView{nullptr};
+        // Set up the properties
         {
-            D3D11_TEXTURE2D_DESC desc = {};
-            desc.Format = DXGI_FORMAT_R32_FLOAT;
-            desc.Width = capture.Resolution().Width;
-            desc.Height = capture.Resolution().Height;
-            desc.MipLevels = 1;
-            desc.ArraySize = 1;
-            desc.SampleDesc.Count = 1;
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-            winrt::check_hresult(m_d3dDevice->CreateTexture2D(&desc, 0, sumTexture.put()));
-
-            // Create output buffer UAV
-            D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-            uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
-            uavDesc.Format = DXGI_FORMAT_R32_FLOAT;
-            uavDesc.Texture1D.MipSlice = 0;
-            winrt::check_hresult(m_d3dDevice->CreateUnorderedAccessView(sumTexture.get(), &uavDesc, sumTextureView.put()));
-        }
+            // The properties are the same for all frames in the set
+			m_properties = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
 
-        // Run the shader
-        {
-            auto sumShader = GetShader(ComputeShaders::FrameSquaredDifferenceBucketSum);
-            m_d3dDeviceContext->CSSetShader(sumShader.get(), nullptr, 0);
-            ID3D11ShaderResourceView* ppSRV[2] = {captureTextureView.get(), targetTextureView.get()};
-            m_d3dDeviceContext->CSSetShaderResources(0, 2, ppSRV);
-            ID3D11UnorderedAccessView* ppUAView[1] = {sumTextureView.get() };
-            m_d3dDeviceContext->CSSetUnorderedAccessViews(0, 1, ppUAView, nullptr);
-            m_d3dDeviceContext->Dispatch(capture.Resolution().Width, capture.Resolution().Height, 1);
+            // The properties for this specific _Tanager_ capture
+            m_extendedProps = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
         }
+        
+    }
 
-        ClearShaderState();
-
-        // Map the sum array and sum the values
-		{
-            auto mappedData = GetBufferFromTexture<float>(sumTexture.get());
-
-			auto sumTexturePtr = reinterpret_cast<float*>(mappedData.data());
-            double sum = 0;
-
-            std::span<float> pixelSums(sumTexturePtr, numPixels);
-
-            constexpr uint32_t threadCount = 8;
-            auto threads = std::array<winrt::IAsyncOperation<double>, threadCount>();
-            for (uint32_t i = 0; i < threadCount - 1; i++)
-            {
-                auto subSpan = pixelSums.subspan(i * numPixels / threadCount, numPixels / threadCount);
-                threads[i] = std::move(AddPixelSums(subSpan));
-            }
-
-            // In the last thread account for any pixels that don't fall into a whole number of threadCount buckets
-            threads[threadCount - 1] = std::move(AddPixelSums(pixelSums.subspan((threadCount - 1) * numPixels / threadCount, std::dynamic_extent)));
-
-            for (auto& sumThread : threads)
-            {
-                sum += sumThread.get();
-            }
-
-			// Compute the PSNR
-			double mse = sum / (static_cast<double>(numPixels) * 3); // 3 channels, so we divide the squared sum by 3
-			double psnr = 20.0 * log10((7.5 * 7.5) / mse); // 7.5 is the peak value for the scRGB format of our intermediates
-
-			return psnr;
-		}
-
-        return 0;
-	}
-
-    // Create a single frame capture object from the raw captured data.
     TanagerDisplayCapture::TanagerDisplayCapture(
-        std::vector<byte> pixels,
+        IFrameDataSource& source,
+        uint32_t size,
         IteIt68051Plugin::VideoTiming* timing,
         IteIt68051Plugin::AviInfoframe* aviInfoframe,
         IteIt68051Plugin::ColorInformation* colorInfo)
     {
-        if (timing == nullptr || aviInfoframe == nullptr || colorInfo == nullptr || pixels.empty())
+        if (timing == nullptr || aviInfoframe == nullptr || colorInfo == nullptr || size == 0)
         {
             Logger().LogError(L"Invalid arguments passed to TanagerDisplayCapture constructor");
             throw winrt::hresult_invalid_argument();
         }
 
-        // Process the frame data
+        // Process the frame data while it is read
         {
             m_frames = winrt::single_threaded_vector<winrt::IRawFrame>();
 
-            auto frame = FrameProcessor::GetInstance().ProcessDataToFrame(
-                timing, aviInfoframe, colorInfo, pixels.data(), static_cast<uint32_t>(pixels.size()));
+            auto frame = FrameProcessor::GetInstance().ProcessDataStreamToFrame(timing, aviInfoframe, colorInfo, source, size);
 
             m_frames.Append(frame);
         }
@@ -908,12 +963,11 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
         // Set up the properties
         {
             // The properties are the same for all frames in the set
-			m_properties = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
+            m_properties = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
 
             // The properties for this specific _Tanager_ capture
             m_extendedProps = winrt::single_threaded_map<winrt::hstring, winrt::IInspectable>();
         }
-        
     }
 
     bool TanagerDisplayCapture::CompareCaptureToPrediction(winrt::hstring name, winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrameSet prediction)
@@ -945,27 +999,13 @@ namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
                 return false;
             }
 
-            auto psnr = FrameProcessor::GetInstance().ComputePSNR(predictedFrame, capturedFrame);
+            const auto options = Libraries::FrameComparison::ComparisonOptionsFromSettings(PsnrLimitDefault);
+            const auto comparison = Libraries::FrameComparison::CompareRawFrames(predictedFrame, capturedFrame, options);
+            Libraries::FrameComparison::LogComparisonReport(comparison, index, capturedFrameRes.Width, options.PsnrLimit);
 
-            auto PsnrLimit = PsnrLimitDefault;
-            if (RuntimeSettings().GetSettingValue(PsnrOverrideKey))
-			{
-                PsnrLimit = RuntimeSettings().GetSettingValueAsDouble(PsnrOverrideKey);
-			}
-
-            if (psnr < PsnrLimit)
-            {
-                Logger().LogError(
-					winrt::hstring(L"PSNR for frame ") + std::to_wstring(index) + L" was " + std::to_wstring(psnr) +
-					L", which is below the threshold of " + std::to_wstring(PsnrLimit));
-
-				return false;
-			}
-            else
+            if (!comparison.Passed)
             {
-                Logger().LogNote(
-                    winrt::hstring(L"PSNR for frame ") + std::to_wstring(index) + L" was " + std::to_wstring(psnr) + 
-                    L", which is above the threshold of " + std::to_wstring(PsnrLimit));
+                return false;
             }
         }
 
@@ -1,4 +1,6 @@
 #pragma once
+#include "CpuFrameDecoder.h"
+#include "FrameDataSource.h"
 
 namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing
 {
@@ -71,13 +73,6 @@ enum class ComputeShaders
     Color_DCI_P3,
     Color_source_defined,
 
-    // Frame Difference Computation
-    // -------------------------------------------
-    // This shader will take two frames and compute the squared difference between the individual pixels in a series of 
-    // buckets that will then be summed together on the CPU side to compute a PSNR.
-    //
-    FrameSquaredDifferenceBucketSum,
-
     // Skip
     // -------------------------------------------
     // Not a real shader, this is just a hint used to indicate that the pipeline stage should be skipped.
@@ -99,8 +94,13 @@ public:
                      uint8_t* data,
                      uint32_t size);
 
-    double ComputePSNR(winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame target,
-              winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame capture);
+    // Processes a frame whose data is read from source as it arrives. With the CPU decoder, rows are decoded while the
+    // rest of the frame is still being transferred.
+    winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame ProcessDataStreamToFrame(IteIt68051Plugin::VideoTiming* timing,
+                     IteIt68051Plugin::AviInfoframe* aviInfoframe,
+                     IteIt68051Plugin::ColorInformation* colorInfo,
+                     IFrameDataSource& source,
+                     uint32_t size);
 
 private:
     FrameProcessor();
@@ -134,12 +134,31 @@ private:
         									  IteIt68051Plugin::AviInfoframe* aviInfoframe,
         									  IteIt68051Plugin::ColorInformation* colorInfo);
 
+    // Describes the same pipeline that the shader selection above builds, for use by the CPU decoder.
+    static CpuDecodeDescriptor GetCpuDecodeDescriptor(IteIt68051Plugin::VideoTiming* timing,
+                                                      IteIt68051Plugin::AviInfoframe* aviInfoframe,
+                                                      IteIt68051Plugin::ColorInformation* colorInfo);
+
+    // Decodes the frame in data on the CPU. If source is set, data is filled from it first and rows are decoded as soon
+    // as they have arrived.
+    winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame ProcessDataToFrameOnCpu(IteIt68051Plugin::VideoTiming* timing,
+                     IteIt68051Plugin::AviInfoframe* aviInfoframe,
+                     IteIt68051Plugin::ColorInformation* colorInfo,
+                     std::span<uint8_t> data,
+                     IFrameDataSource* source);
+
+    // The largest band of rows handed to a single CPU decode task.
+    static constexpr uint32_t MaxCpuDecodeRowsPerBand = 16;
 
     winrt::com_ptr<ID3D11Device> m_d3dDevice{nullptr};
     winrt::com_ptr<ID3D11DeviceContext> m_d3dDeviceContext{nullptr};
     std::map<ComputeShaders, winrt::com_ptr<ID3D11ComputeShader>> m_shaderCache;
 
     std::mutex m_d3dRenderingMutex;
+
+    // When not rendering on hardware, frames are decoded with the fused CPU pipeline instead of running the compute
+    // shaders on WARP.
+    bool m_useCpuDecode{false};
 };
 
 struct TanagerDisplayCapture : winrt::implements<TanagerDisplayCapture,
@@ -153,6 +172,14 @@ struct TanagerDisplayCapture : winrt::implements<TanagerDisplayCapture,
         IteIt68051Plugin::AviInfoframe* aviInfoframe,
         IteIt68051Plugin::ColorInformation* colorInfo);
 
+    // Constructor for creating a single-frame capture that is decoded as its data is read from source
+    TanagerDisplayCapture(
+        IFrameDataSource& source,
+        uint32_t size,
+        IteIt68051Plugin::VideoTiming* timing,
+        IteIt68051Plugin::AviInfoframe* aviInfoframe,
+        IteIt68051Plugin::ColorInformation* colorInfo);
+
     // Methods from IDisplayCapture
     bool CompareCaptureToPrediction(winrt::hstring name, winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrameSet prediction);
     winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrameSet GetFrameData();
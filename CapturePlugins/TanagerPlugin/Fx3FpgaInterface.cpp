@@ -78,6 +78,69 @@ namespace winrt::TanagerPlugin::implementation
         return buffer;
 	}
 
+    // Reads a frame from the bulk-in pipe a chunk at a time, so that the data that has already arrived can be processed
+    // while the rest is still being transferred.
+    class BulkInPipeDataSource : public MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource
+    {
+    public:
+        // 1MB is a multiple of every USB max packet size, so no chunk ends with a short packet
+        static constexpr UINT32 ChunkSize = 1024 * 1024;
+
+        BulkInPipeDataSource(UsbBulkInPipe bulkInPipe, UINT32 dataSize) :
+            m_bulkInPipe(bulkInPipe), m_reader(bulkInPipe.InputStream()), m_remaining(dataSize)
+        {
+        }
+
+        size_t Read(std::span<uint8_t> destination) override
+        {
+            const UINT32 count = static_cast<UINT32>(min(destination.size(), static_cast<size_t>(min(ChunkSize, m_remaining))));
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            const UINT32 loaded = m_reader.LoadAsync(count).get();
+            m_reader.ReadBytes(winrt::array_view<uint8_t>(destination.data(), loaded));
+            m_remaining -= loaded;
+            return loaded;
+        }
+
+        void Discard() override
+        {
+            // The FX3 sends the whole transfer it was asked for, so the rest of it is read and thrown away. If that fails
+            // the pipe is flushed, which is the best that can be done.
+            if (m_remaining == 0)
+            {
+                return;
+            }
+
+            try
+            {
+                std::vector<uint8_t> scratch(min(ChunkSize, m_remaining));
+                while (m_remaining > 0 && Read(scratch) != 0)
+                {
+                }
+            }
+            catch (...)
+            {
+            }
+
+            m_remaining = 0;
+            m_bulkInPipe.FlushBuffer();
+        }
+
+    private:
+        UsbBulkInPipe m_bulkInPipe;
+        DataReader m_reader;
+        UINT32 m_remaining;
+    };
+
+    std::unique_ptr<MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource> Fx3FpgaInterface::OpenEndPointDataStream(UINT32 dataSize)
+    {
+        auto bulkInPipe = m_usbDevice.DefaultInterface().BulkInPipes().GetAt(0);
+        return std::make_unique<BulkInPipeDataSource>(bulkInPipe, dataSize);
+    }
+
 	void Fx3FpgaInterface::FlashFpgaFirmware(winrt::hstring uri)
 	{
 		throw winrt::hresult_not_implemented();
@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.h"
 #include "Controller.h"
+#include "FrameDataSource.h"
 #include <vector>
 
 namespace winrt::TanagerPlugin::implementation
@@ -13,6 +14,7 @@ namespace winrt::TanagerPlugin::implementation
         void Write(unsigned short address, std::vector<byte> data);
         std::vector<byte> Read(unsigned short address, UINT16 size);
         std::vector<byte> ReadEndPointData(UINT32 dataSize);
+        std::unique_ptr<MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource> OpenEndPointDataStream(UINT32 dataSize);
         void FlashFpgaFirmware(winrt::hstring uri);
         void FlashFx3Firmware(winrt::hstring uri);
         struct FirmwareVersionInfo GetFirmwareVersionInfo();
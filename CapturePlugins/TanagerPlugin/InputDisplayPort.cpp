@@ -239,13 +239,11 @@ MicrosoftDisplayCaptureTools::CaptureCard::IDisplayCapture TanagerDisplayInputDi
     // initiate read sequencer
     parent->FpgaWrite(0x10, std::vector<byte>({2}));
 
-    // read frame
-    auto frameData = parent->ReadEndPointData(bufferSizeInDWords * 4);
+    // read frame, decoding it as it arrives - the read sequencer is turned off when this returns or throws
+    auto frameData = parent->OpenEndPointDataStream(bufferSizeInDWords * 4);
+    ReadSequencerGuard readSequencer(*parent, *frameData);
 
-    // turn off read sequencer
-    parent->FpgaWrite(0x10, std::vector<byte>({3}));
-
-    return winrt::make<winrt::TanagerDisplayCapture>(frameData, timing.get(), aviInfoframe.get(), colorData.get());
+    return winrt::make<winrt::TanagerDisplayCapture>(*frameData, bufferSizeInDWords * 4, timing.get(), aviInfoframe.get(), colorData.get());
 }
 
 void TanagerDisplayInputDisplayPort::FinalizeDisplayState()
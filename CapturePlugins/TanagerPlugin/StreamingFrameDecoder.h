@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "CpuFrameDecoder.h"
+#include "FrameDataSource.h"
+#include "ThreadPool.h"
+
+namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing {
+
+    //
+    // Decodes a frame while its raw data is still arriving.
+    //
+    // The frame is split into bands of whole rows. As data is received the decoder works out which rows are complete
+    // (including the following line for 4:2:0) and queues every band that is now fully covered on the thread pool, so by
+    // the time the last chunk arrives only the final band is left to decode. Handing the whole frame over at once through
+    // Finish() gives the same result as a plain parallel decode.
+    //
+    class StreamingFrameDecoder
+    {
+    public:
+        // raw must be the full size of the frame, it is filled by Receive() (or already filled by the caller). scRgb and
+        // rgba8 are full frame sized outputs as for CpuFrameDecoder::DecodeRows.
+        StreamingFrameDecoder(
+            const CpuFrameDecoder& decoder,
+            std::span<uint8_t> raw,
+            uint64_t* scRgb,
+            uint32_t* rgba8,
+            Libraries::ThreadPool& pool,
+            uint32_t rowsPerBand) :
+            m_decoder(decoder),
+            m_raw(raw),
+            m_scRgb(scRgb),
+            m_rgba8(rgba8),
+            m_pool(pool),
+            m_rowsPerBand((std::max)(rowsPerBand, 1u)),
+            m_bandCount((decoder.Descriptor().Height + m_rowsPerBand - 1) / m_rowsPerBand),
+            m_bandTimes(m_bandCount),
+            m_bandWorkers(m_bandCount),
+            m_bands(pool)
+        {
+        }
+
+        StreamingFrameDecoder(const StreamingFrameDecoder&) = delete;
+        StreamingFrameDecoder& operator=(const StreamingFrameDecoder&) = delete;
+
+        // Reads from the source until the frame is full or the source runs out, queueing bands for decode as their rows
+        // arrive. Returns the number of bytes received.
+        size_t Receive(IFrameDataSource& source)
+        {
+            while (m_received < m_raw.size())
+            {
+                const size_t bytesRead = source.Read(m_raw.subspan(m_received));
+                if (bytesRead == 0)
+                {
+                    break;
+                }
+
+                m_received += bytesRead;
+                QueueBands(m_decoder.RowsAvailable(m_received));
+            }
+
+            return m_received;
+        }
+
+        // Queues everything that hasn't been queued yet and waits for the whole frame to be decoded. Any data that was
+        // never received is decoded as whatever the raw buffer already held.
+        void Finish()
+        {
+            QueueBands(m_decoder.Descriptor().Height);
+            m_bands.Wait();
+        }
+
+        uint32_t RowsPerBand() const
+        {
+            return m_rowsPerBand;
+        }
+
+        uint32_t BandCount() const
+        {
+            return m_bandCount;
+        }
+
+        // How long each band took to decode, and which pool worker decoded it. Only valid after Finish().
+        const std::vector<double>& BandTimes() const
+        {
+            return m_bandTimes;
+        }
+
+        const std::vector<uint32_t>& BandWorkers() const
+        {
+            return m_bandWorkers;
+        }
+
+    private:
+        void QueueBands(uint32_t rowsAvailable)
+        {
+            const uint32_t height = m_decoder.Descriptor().Height;
+            while (m_queuedBands < m_bandCount)
+            {
+                const uint32_t band = m_queuedBands;
+                const uint32_t firstRow = band * m_rowsPerBand;
+                if ((std::min)(firstRow + m_rowsPerBand, height) > rowsAvailable)
+                {
+                    break;
+                }
+
+                m_bands.Run([this, band, firstRow] {
+                    const auto bandStart = std::chrono::steady_clock::now();
+
+                    m_decoder.DecodeRows(m_raw, firstRow, m_rowsPerBand, m_scRgb, m_rgba8);
+
+                    const auto bandEnd = std::chrono::steady_clock::now();
+                    m_bandTimes[band] = std::chrono::duration<double, std::milli>(bandEnd - bandStart).count();
+                    m_bandWorkers[band] = m_pool.CurrentWorkerIndex();
+                });
+
+                m_queuedBands++;
+            }
+        }
+
+        const CpuFrameDecoder& m_decoder;
+        const std::span<uint8_t> m_raw;
+        uint64_t* const m_scRgb;
+        uint32_t* const m_rgba8;
+        Libraries::ThreadPool& m_pool;
+
+        const uint32_t m_rowsPerBand;
+        const uint32_t m_bandCount;
+        size_t m_received = 0;
+        uint32_t m_queuedBands = 0;
+
+        std::vector<double> m_bandTimes;
+        std::vector<uint32_t> m_bandWorkers;
+
+        // Declared last so that it is destroyed first, any bands still running are waited on while the rest of the
+        // decoder's state is still alive.
+        Libraries::ThreadPool::TaskGroup m_bands;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing
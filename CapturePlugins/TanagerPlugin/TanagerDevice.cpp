@@ -76,6 +76,11 @@ TanagerDevice::TanagerDevice(winrt::hstring deviceId) :
 		return m_fpga.ReadEndPointData(dataSize);
 	}
 
+	std::unique_ptr<MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource> TanagerDevice::OpenEndPointDataStream(UINT32 dataSize)
+	{
+		return m_fpga.OpenEndPointDataStream(dataSize);
+	}
+
 	void TanagerDevice::FlashFpgaFirmware(winrt::hstring filePath)
 	{
         m_fpga.FlashFpgaFirmware(filePath);
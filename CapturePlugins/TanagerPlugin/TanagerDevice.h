@@ -4,7 +4,6 @@ namespace winrt::TanagerPlugin::implementation
 {
     // The psnr limit we use to determine if a match is good enough to be considered a match by default
     constexpr double PsnrLimitDefault = 50.0;
-    constexpr LPCWSTR PsnrOverrideKey = L"psnrlimit";
 
     // This is a temporary limit while we're bringing up some of the hardware on board.
     constexpr uint32_t MaxDescriptorByteSize = 512;
@@ -27,6 +26,7 @@ namespace winrt::TanagerPlugin::implementation
         void FpgaWrite(unsigned short address, std::vector<byte> data) override;
         std::vector<byte> FpgaRead(unsigned short address, UINT16 data) override;
         std::vector<byte> ReadEndPointData(UINT32 dataSize) override;
+        std::unique_ptr<MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing::IFrameDataSource> OpenEndPointDataStream(UINT32 dataSize) override;
         void SelectDisplayPortEDID(USHORT value);
         void I2cWriteData(uint16_t i2cAddress, uint8_t address, std::vector<byte> data);
 
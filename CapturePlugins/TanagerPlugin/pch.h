@@ -34,6 +34,8 @@
 #include <ranges>
 #include <iterator>
 #include <mutex>
+#include <chrono>
+#include <thread>
 #include <span>
 
 #include "IteIt68051.h"
@@ -2,6 +2,7 @@
 #include "MicrosoftDisplayCaptureTools.h"
 #include "Framework.Core.g.cpp"
 #include "Utils.h"
+#include "CaptureComparison.h"
 
 namespace winrt
 {
@@ -30,9 +31,12 @@ namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation {
 Core::Core() : Core(winrt::make<winrt::Logger>().as<ILogger>(), nullptr) {}
 
 // Constructor taking a caller-defined logging class and a runtime settings object (which can be null)
-Core::Core(ILogger const& logger, IRuntimeSettings const& settings) : m_logger(logger), m_runtimeSettings(settings)
+Core::Core(ILogger const& logger, IRuntimeSettings const& settings) :
+    m_logger(logger),
+    m_configFileSettings(winrt::make_self<ConfigFileRuntimeSettings>(settings)),
+    m_runtimeSettings(m_configFileSettings.as<IRuntimeSettings>())
 {
-    Runtime::CreateRuntime(logger, settings);
+    Runtime::CreateRuntime(logger, m_runtimeSettings);
 
     m_logger.LogNote(L"Initializing MicrosoftDisplayCaptureTools v" + this->Version().ToString());
 }
@@ -254,6 +258,43 @@ void Core::LoadConfigFile(hstring const& configFile)
         }
     }
 
+    // Parse the comparison tolerance out of the config file, it becomes the default for the matching runtime settings
+    {
+        auto testCaseValue = jsonObject.TryLookup(L"TestCase");
+        if (testCaseValue && testCaseValue.ValueType() == winrt::JsonValueType::Object)
+        {
+            auto toleranceValue = testCaseValue.GetObjectW().TryLookup(L"ComparisonTolerance");
+            if (toleranceValue && toleranceValue.ValueType() == winrt::JsonValueType::Object)
+            {
+                auto tolerance = toleranceValue.GetObjectW();
+
+                // Without PerPixel the percentage isn't used, and comparisons are by PSNR alone. Without a PixelBudget the
+                // pixels over the percentage are counted and reported, but frames still pass or fail by PSNR alone.
+                if (tolerance.GetNamedBoolean(L"PerPixel", false))
+                {
+                    auto percentageError = tolerance.GetNamedNumber(L"PercentageError", 0);
+                    m_configFileSettings->SetConfigFileValue(hstring(Libraries::FrameComparison::PixelToleranceKey), winrt::to_hstring(percentageError));
+
+                    if (tolerance.HasKey(L"PixelBudget"))
+                    {
+                        auto pixelBudget = tolerance.GetNamedNumber(L"PixelBudget", 0);
+                        m_configFileSettings->SetConfigFileValue(hstring(Libraries::FrameComparison::PixelToleranceBudgetKey), winrt::to_hstring(pixelBudget));
+
+                        m_logger.LogConfig(
+                            L"Per-pixel comparison tolerance: " + winrt::to_hstring(percentageError) + L"% of SDR white, with up to " +
+                            winrt::to_hstring(pixelBudget) + L"% of pixels allowed over it");
+                    }
+                    else
+                    {
+                        m_logger.LogConfig(
+                            L"Per-pixel comparison tolerance: " + winrt::to_hstring(percentageError) +
+                            L"% of SDR white, pixels over it are reported only as no PixelBudget is set");
+                    }
+                }
+            }
+        }
+    }
+
     // Parse test system information out of the config file
     {
         auto testSystemConfigDataValue = jsonObject.TryLookup(L"TestSystem");
@@ -5,6 +5,8 @@
 #include "winrt/MicrosoftDisplayCaptureTools.ConfigurationTools.h"
 #include "winrt/MicrosoftDisplayCaptureTools.Display.h"
 
+#include "Utils.h"
+
 namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation
 {
     // Constant names used for automatically discovering installed plugins for this framework. These assume that items are
@@ -122,7 +124,9 @@ namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation
         // The logging system for this framework instance
         const ILogger m_logger;
 
-        // The runtime settings wrapper for this framework instance
+        // The runtime settings wrapper for this framework instance, which adds the settings from the configuration file to
+        // those the caller provided
+        const winrt::com_ptr<ConfigFileRuntimeSettings> m_configFileSettings;
         const IRuntimeSettings m_runtimeSettings;
 
         // Has a test locked components
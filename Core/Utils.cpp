@@ -73,4 +73,75 @@ winrt::MicrosoftDisplayCaptureTools::Framework::ILogger Runtime::Logger()
     return m_logger;
 }
 
+ConfigFileRuntimeSettings::ConfigFileRuntimeSettings(winrt::MicrosoftDisplayCaptureTools::Framework::IRuntimeSettings settings) :
+    m_settings(settings)
+{
+}
+
+void ConfigFileRuntimeSettings::SetConfigFileValue(hstring const& settingName, hstring const& value)
+{
+    std::scoped_lock lock(m_configFileValuesLock);
+    m_configFileValues[settingName] = value;
+}
+
+bool ConfigFileRuntimeSettings::HasCallerSetting(hstring const& settingName)
+{
+    return m_settings && m_settings.GetSettingValue(settingName);
+}
+
+std::optional<hstring> ConfigFileRuntimeSettings::GetConfigFileValue(hstring const& settingName)
+{
+    std::scoped_lock lock(m_configFileValuesLock);
+    auto value = m_configFileValues.find(settingName);
+    if (value == m_configFileValues.end())
+    {
+        return std::nullopt;
+    }
+
+    return value->second;
+}
+
+winrt::Windows::Foundation::IInspectable ConfigFileRuntimeSettings::GetSettingValue(hstring const& settingName)
+{
+    if (HasCallerSetting(settingName))
+    {
+        return m_settings.GetSettingValue(settingName);
+    }
+
+    auto value = GetConfigFileValue(settingName);
+    return value ? winrt::box_value(*value) : nullptr;
+}
+
+bool ConfigFileRuntimeSettings::GetSettingValueAsBool(hstring const& settingName)
+{
+    if (HasCallerSetting(settingName))
+    {
+        return m_settings.GetSettingValueAsBool(settingName);
+    }
+
+    auto value = GetConfigFileValue(settingName);
+    return value && _wcsicmp(value->c_str(), L"true") == 0;
+}
+
+hstring ConfigFileRuntimeSettings::GetSettingValueAsString(hstring const& settingName)
+{
+    if (HasCallerSetting(settingName))
+    {
+        return m_settings.GetSettingValueAsString(settingName);
+    }
+
+    return GetConfigFileValue(settingName).value_or(L"");
+}
+
+double ConfigFileRuntimeSettings::GetSettingValueAsDouble(hstring const& settingName)
+{
+    if (HasCallerSetting(settingName))
+    {
+        return m_settings.GetSettingValueAsDouble(settingName);
+    }
+
+    auto value = GetConfigFileValue(settingName);
+    return value ? _wtof(value->c_str()) : 0;
+}
+
 } // namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation
@@ -2,6 +2,9 @@
 #include "Framework.Version.g.h"
 #include "Framework.Runtime.g.h"
 
+#include <map>
+#include <optional>
+
 namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation {
 struct Version : VersionT<Version>
 {
@@ -37,6 +40,29 @@ struct Runtime : RuntimeT<Runtime>
     winrt::MicrosoftDisplayCaptureTools::Framework::ILogger m_logger;
 };
 
+// Runtime settings that fall back to values from the configuration file for any setting the caller's settings don't
+// have, so that a setting given on the command line overrides the file.
+struct ConfigFileRuntimeSettings : winrt::implements<ConfigFileRuntimeSettings, winrt::MicrosoftDisplayCaptureTools::Framework::IRuntimeSettings>
+{
+    ConfigFileRuntimeSettings(winrt::MicrosoftDisplayCaptureTools::Framework::IRuntimeSettings settings);
+
+    void SetConfigFileValue(hstring const& settingName, hstring const& value);
+
+    winrt::Windows::Foundation::IInspectable GetSettingValue(hstring const& settingName);
+    bool GetSettingValueAsBool(hstring const& settingName);
+    hstring GetSettingValueAsString(hstring const& settingName);
+    double GetSettingValueAsDouble(hstring const& settingName);
+
+private:
+    bool HasCallerSetting(hstring const& settingName);
+    std::optional<hstring> GetConfigFileValue(hstring const& settingName);
+
+    const winrt::MicrosoftDisplayCaptureTools::Framework::IRuntimeSettings m_settings;
+
+    std::mutex m_configFileValuesLock;
+    std::map<hstring, hstring> m_configFileValues;
+};
+
 } // namespace winrt::MicrosoftDisplayCaptureTools::Framework::implementation
 namespace winrt::MicrosoftDisplayCaptureTools::Framework::factory_implementation {
 struct Version : VersionT<Version, implementation::Version>
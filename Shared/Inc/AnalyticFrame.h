@@ -0,0 +1,266 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries {
+
+    //
+    // A frame of R16G16B16A16_FLOAT (scRGB) pixels described as rectangles of constant color.
+    //
+    // Predictions of flat test content (checkerboards, solid fills) are fully described by a few rectangles, so they can be
+    // compared against without ever being rendered. The rectangles are resolved up front into bands of rows that share the
+    // same spans of constant color, which is all a comparison needs to walk the frame one row span at a time. Frames can
+    // still be rendered into a pixel buffer for anything that needs the pixels themselves.
+    //
+    class AnalyticFrame
+    {
+    public:
+        // The IRawFrame property holding the serialized description (a UInt64 array) of frames that have one
+        static constexpr const wchar_t* PropertyName = L"AnalyticFrame";
+
+        struct Rectangle
+        {
+            uint32_t Left = 0;
+            uint32_t Top = 0;
+            uint32_t Right = 0;
+            uint32_t Bottom = 0;
+            uint64_t Pixel = 0;
+        };
+
+        // Pixels [Left, Right) of a row
+        struct Span
+        {
+            uint32_t Left = 0;
+            uint32_t Right = 0;
+            uint64_t Pixel = 0;
+        };
+
+        // The rectangles are painted over the background in order and clipped to the frame.
+        AnalyticFrame(uint32_t width, uint32_t height, uint64_t background, std::vector<Rectangle> rectangles) :
+            m_width(width), m_height(height), m_background(background), m_rectangles(std::move(rectangles))
+        {
+            for (auto& rectangle : m_rectangles)
+            {
+                rectangle.Right = (std::min)(rectangle.Right, m_width);
+                rectangle.Bottom = (std::min)(rectangle.Bottom, m_height);
+            }
+
+            std::erase_if(m_rectangles, [](const Rectangle& rectangle) {
+                return rectangle.Left >= rectangle.Right || rectangle.Top >= rectangle.Bottom;
+            });
+
+            BuildBands();
+        }
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        uint64_t Background() const
+        {
+            return m_background;
+        }
+
+        std::span<const Rectangle> Rectangles() const
+        {
+            return m_rectangles;
+        }
+
+        // The spans covering row y from left to right. Neighboring spans never hold the same pixel.
+        std::span<const Span> RowSpans(uint32_t y) const
+        {
+            const auto nextBand = std::upper_bound(
+                m_bands.begin(), m_bands.end(), y, [](uint32_t row, const Band& band) { return row < band.Top; });
+
+            return std::prev(nextBand)->Spans;
+        }
+
+        // Calls function(left, right, pixels, repeated) for the spans of row y, the same way TiledFrame::ForEachRun does.
+        // Every span is one repeated pixel.
+        template <typename Function>
+        void ForEachRun(uint32_t y, Function&& function) const
+        {
+            for (const auto& span : RowSpans(y))
+            {
+                function(span.Left, span.Right, &span.Pixel, true);
+            }
+        }
+
+        // Writes rows [firstRow, firstRow + rowCount) into a full frame sized pixel buffer
+        void RenderRows(uint32_t firstRow, uint32_t rowCount, uint64_t* pixels) const
+        {
+            const uint32_t lastRow = (std::min)(firstRow + rowCount, m_height);
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                uint64_t* row = pixels + static_cast<size_t>(y) * m_width;
+                for (const auto& span : RowSpans(y))
+                {
+                    std::fill(row + span.Left, row + span.Right, span.Pixel);
+                }
+            }
+        }
+
+        // Flattens the description into integers for an IRawFrame property. The layout is a version, the packed frame
+        // size, the background and the rectangle count, followed by three values per rectangle.
+        std::vector<uint64_t> Serialize() const
+        {
+            std::vector<uint64_t> data;
+            data.reserve(HeaderSize + m_rectangles.size() * ValuesPerRectangle);
+            data.push_back(FormatVersion);
+            data.push_back(Pack(m_width, m_height));
+            data.push_back(m_background);
+            data.push_back(m_rectangles.size());
+
+            for (const auto& rectangle : m_rectangles)
+            {
+                data.push_back(Pack(rectangle.Left, rectangle.Top));
+                data.push_back(Pack(rectangle.Right, rectangle.Bottom));
+                data.push_back(rectangle.Pixel);
+            }
+
+            return data;
+        }
+
+        // Returns nothing if the data isn't a description written by Serialize
+        static std::optional<AnalyticFrame> Deserialize(std::span<const uint64_t> data)
+        {
+            if (data.size() < HeaderSize || data[0] != FormatVersion || data[3] != (data.size() - HeaderSize) / ValuesPerRectangle ||
+                (data.size() - HeaderSize) % ValuesPerRectangle != 0)
+            {
+                return std::nullopt;
+            }
+
+            std::vector<Rectangle> rectangles(data[3]);
+            for (size_t index = 0; index < rectangles.size(); index++)
+            {
+                const auto values = data.subspan(HeaderSize + index * ValuesPerRectangle, ValuesPerRectangle);
+                rectangles[index] = {Low(values[0]), High(values[0]), Low(values[1]), High(values[1]), values[2]};
+            }
+
+            return AnalyticFrame(Low(data[1]), High(data[1]), data[2], std::move(rectangles));
+        }
+
+    private:
+        static constexpr uint64_t FormatVersion = 1;
+        static constexpr size_t HeaderSize = 4;
+        static constexpr size_t ValuesPerRectangle = 3;
+
+        struct Band
+        {
+            uint32_t Top = 0;
+            std::vector<Span> Spans;
+        };
+
+        static uint64_t Pack(uint32_t low, uint32_t high)
+        {
+            return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+        }
+
+        static uint32_t Low(uint64_t value)
+        {
+            return static_cast<uint32_t>(value);
+        }
+
+        static uint32_t High(uint64_t value)
+        {
+            return static_cast<uint32_t>(value >> 32);
+        }
+
+        // Splits the frame into bands at every rectangle's top and bottom edge. Within a band every row is covered by the
+        // same rectangles, so its spans are found by splitting at their left and right edges and taking the topmost
+        // rectangle of each piece. Neighboring bands that end up with the same spans are merged.
+        void BuildBands()
+        {
+            std::vector<uint32_t> rowEdges = {0, m_height};
+            for (const auto& rectangle : m_rectangles)
+            {
+                rowEdges.push_back(rectangle.Top);
+                rowEdges.push_back(rectangle.Bottom);
+            }
+
+            std::sort(rowEdges.begin(), rowEdges.end());
+            rowEdges.erase(std::unique(rowEdges.begin(), rowEdges.end()), rowEdges.end());
+
+            std::vector<const Rectangle*> covering;
+            std::vector<uint32_t> columnEdges;
+            for (size_t edge = 0; edge + 1 < rowEdges.size(); edge++)
+            {
+                const uint32_t top = rowEdges[edge];
+
+                covering.clear();
+                columnEdges = {0, m_width};
+                for (const auto& rectangle : m_rectangles)
+                {
+                    if (rectangle.Top <= top && top < rectangle.Bottom)
+                    {
+                        covering.push_back(&rectangle);
+                        columnEdges.push_back(rectangle.Left);
+                        columnEdges.push_back(rectangle.Right);
+                    }
+                }
+
+                std::sort(columnEdges.begin(), columnEdges.end());
+                columnEdges.erase(std::unique(columnEdges.begin(), columnEdges.end()), columnEdges.end());
+
+                Band band{top, {}};
+                for (size_t column = 0; column + 1 < columnEdges.size(); column++)
+                {
+                    const uint32_t left = columnEdges[column];
+
+                    uint64_t pixel = m_background;
+                    for (auto rectangle = covering.rbegin(); rectangle != covering.rend(); rectangle++)
+                    {
+                        if ((*rectangle)->Left <= left && left < (*rectangle)->Right)
+                        {
+                            pixel = (*rectangle)->Pixel;
+                            break;
+                        }
+                    }
+
+                    if (!band.Spans.empty() && band.Spans.back().Pixel == pixel)
+                    {
+                        band.Spans.back().Right = columnEdges[column + 1];
+                    }
+                    else
+                    {
+                        band.Spans.push_back({left, columnEdges[column + 1], pixel});
+                    }
+                }
+
+                if (m_bands.empty() || !SameSpans(m_bands.back().Spans, band.Spans))
+                {
+                    m_bands.push_back(std::move(band));
+                }
+            }
+
+            // An empty frame still has a (spanless) band for RowSpans to find
+            if (m_bands.empty())
+            {
+                m_bands.push_back({});
+            }
+        }
+
+        static bool SameSpans(const std::vector<Span>& a, const std::vector<Span>& b)
+        {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Span& spanA, const Span& spanB) {
+                return spanA.Left == spanB.Left && spanA.Right == spanB.Right && spanA.Pixel == spanB.Pixel;
+            });
+        }
+
+        uint32_t m_width;
+        uint32_t m_height;
+        uint64_t m_background;
+        std::vector<Rectangle> m_rectangles;
+        std::vector<Band> m_bands;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries
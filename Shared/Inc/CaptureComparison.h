@@ -0,0 +1,250 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <unknwn.h>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Graphics.h>
+#include <winrt/Windows.Storage.Streams.h>
+#include "winrt/MicrosoftDisplayCaptureTools.Framework.h"
+
+#include "FrameComparison.h"
+#include "TestRuntime.h"
+
+//
+// Comparison of a captured IRawFrame against a predicted one, shared by the capture plugins.
+//
+// Picks the cheapest form the prediction is available in (an AnalyticFrame, then a TiledFrame, then the uncompressed
+// buffer) and hands it to FrameComparison, attaching the report to the captured frame and logging a failure.
+//
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries::FrameComparison {
+
+    // The runtime settings that control a comparison. The pixel tolerance ones get their defaults from the
+    // TestCase.ComparisonTolerance section of a configuration file.
+    constexpr const wchar_t* PsnrOverrideKey = L"psnrlimit";
+    // Set to compute the full PSNR of failing frames, rather than stopping once a frame is known to fail.
+    constexpr const wchar_t* PsnrExactKey = L"psnrexact";
+    // Set to count the pixels with a per-channel error over an absolute tolerance, given as a percentage of SDR white (1.0
+    // in scRGB). Frames only fail on that count once a budget is also set, the percentage of pixels allowed over it.
+    constexpr const wchar_t* PixelToleranceKey = L"pixeltolerance";
+    constexpr const wchar_t* PixelToleranceBudgetKey = L"pixeltolerancebudget";
+
+    // The options a capture plugin compares with, from the runtime settings. psnrLimitDefault is the plugin's own limit,
+    // used unless the settings override it.
+    inline ComparisonOptions ComparisonOptionsFromSettings(double psnrLimitDefault)
+    {
+        const auto settings = Framework::Helpers::RuntimeSettings();
+
+        // Unless the exact PSNR was asked for, the comparison stops as soon as the frame is known to be below the limit
+        ComparisonOptions options;
+        options.PsnrLimit = settings.GetSettingValue(PsnrOverrideKey) ? settings.GetSettingValueAsDouble(PsnrOverrideKey) : psnrLimitDefault;
+        options.Exact = settings.GetSettingValueAsBool(PsnrExactKey);
+
+        // The per-pixel tolerance is checked in the same pass as the PSNR, on top of it. Without a budget the pixels over
+        // it are only reported, and frames pass or fail on their PSNR alone.
+        if (settings.GetSettingValue(PixelToleranceKey))
+        {
+            options.PixelTolerance = settings.GetSettingValueAsDouble(PixelToleranceKey) / 100.0;
+
+            if (settings.GetSettingValue(PixelToleranceBudgetKey))
+            {
+                options.EnforcePixelTolerance = true;
+                options.PixelBudget = settings.GetSettingValueAsDouble(PixelToleranceBudgetKey) / 100.0;
+            }
+        }
+
+        return options;
+    }
+
+    // The scRGB fp16 pixels of a frame, along with the buffer that holds them. Frames may build their buffer when Data() is
+    // called rather than keep it, so the pixels are only valid for as long as this is kept around.
+    struct ScRgbPixels
+    {
+        winrt::Windows::Storage::Streams::IBuffer Buffer{nullptr};
+        std::span<const uint64_t> Pixels;
+    };
+
+    // Returns the scRGB fp16 pixels of a frame, checking that its buffer covers the given number of pixels.
+    inline ScRgbPixels GetScRgbPixels(winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& frame, size_t numPixels)
+    {
+        ScRgbPixels pixels;
+        pixels.Buffer = frame.Data();
+        if (pixels.Buffer.Length() < numPixels * sizeof(uint64_t))
+        {
+            Framework::Helpers::Logger().LogError(L"Frame data passed for comparison is smaller than the frame resolution.");
+            throw winrt::hresult_invalid_argument();
+        }
+
+        pixels.Pixels = std::span(reinterpret_cast<const uint64_t*>(pixels.Buffer.data()), numPixels);
+        return pixels;
+    }
+
+    // Predictions of flat content carry a description of their pixels as constant rectangles, which can be compared
+    // against without the prediction ever being rendered. Returns nothing for frames without one.
+    inline std::optional<AnalyticFrame> GetAnalyticFrame(
+        winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& frame, winrt::Windows::Graphics::SizeInt32 resolution)
+    {
+        const auto properties = frame.Properties();
+        if (properties == nullptr || !properties.HasKey(AnalyticFrame::PropertyName))
+        {
+            return std::nullopt;
+        }
+
+        const auto value = properties.Lookup(AnalyticFrame::PropertyName).try_as<winrt::Windows::Foundation::IPropertyValue>();
+        if (value == nullptr || value.Type() != winrt::Windows::Foundation::PropertyType::UInt64Array)
+        {
+            return std::nullopt;
+        }
+
+        winrt::com_array<uint64_t> data;
+        value.GetUInt64Array(data);
+
+        auto analyticFrame = AnalyticFrame::Deserialize(std::span<const uint64_t>(data.data(), data.size()));
+        if (!analyticFrame || analyticFrame->Width() != static_cast<uint32_t>(resolution.Width) ||
+            analyticFrame->Height() != static_cast<uint32_t>(resolution.Height))
+        {
+            return std::nullopt;
+        }
+
+        return analyticFrame;
+    }
+
+    // Predictions can also carry their pixels as tiles, which are compared against in place rather than through the
+    // uncompressed buffer. Returns nothing for frames without them.
+    inline std::optional<TiledFrame> GetTiledFrame(
+        winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& frame, winrt::Windows::Graphics::SizeInt32 resolution)
+    {
+        const auto properties = frame.Properties();
+        if (properties == nullptr || !properties.HasKey(TiledFrame::PropertyName))
+        {
+            return std::nullopt;
+        }
+
+        const auto value = properties.Lookup(TiledFrame::PropertyName).try_as<winrt::Windows::Foundation::IPropertyValue>();
+        if (value == nullptr || value.Type() != winrt::Windows::Foundation::PropertyType::UInt64Array)
+        {
+            return std::nullopt;
+        }
+
+        winrt::com_array<uint64_t> data;
+        value.GetUInt64Array(data);
+
+        auto tiledFrame = TiledFrame::Deserialize(std::span<const uint64_t>(data.data(), data.size()));
+        if (!tiledFrame || tiledFrame->Width() != static_cast<uint32_t>(resolution.Width) ||
+            tiledFrame->Height() != static_cast<uint32_t>(resolution.Height))
+        {
+            return std::nullopt;
+        }
+
+        return tiledFrame;
+    }
+
+    // Attaches a comparison report to the properties of a frame, so that a failure can be looked into without running
+    // the comparison again.
+    inline void AddComparisonReport(winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& frame, ComparisonReport const& report)
+    {
+        using winrt::Windows::Foundation::PropertyValue;
+
+        const auto width = static_cast<size_t>(frame.Resolution().Width);
+        const std::array<uint32_t, 3> maxErrorLocation{
+            static_cast<uint32_t>(report.MaxErrorPixel % width), static_cast<uint32_t>(report.MaxErrorPixel / width), report.MaxErrorChannel};
+
+        auto properties = frame.Properties();
+        properties.Insert(L"ComparisonPsnr", winrt::box_value(report.Psnr));
+        properties.Insert(L"ComparisonComplete", winrt::box_value(report.Complete));
+        properties.Insert(L"ComparisonPixelsCompared", winrt::box_value(static_cast<uint64_t>(report.PixelsCompared)));
+        properties.Insert(L"ComparisonChannelMse", PropertyValue::CreateDoubleArray(report.ChannelMse));
+        properties.Insert(L"ComparisonMaxError", winrt::box_value(report.MaxAbsoluteError));
+        properties.Insert(L"ComparisonMaxErrorLocation", PropertyValue::CreateUInt32Array(maxErrorLocation));
+        properties.Insert(L"ComparisonPixelTolerance", winrt::box_value(report.PixelTolerance));
+        properties.Insert(L"ComparisonPixelsOverTolerance", winrt::box_value(report.PixelsOverTolerance));
+        properties.Insert(L"ComparisonPixelBudgetExceeded", winrt::box_value(report.PixelBudgetExceeded));
+        properties.Insert(L"ComparisonHistogramRange", winrt::box_value(report.HistogramRange));
+        properties.Insert(L"ComparisonErrorHistogram", PropertyValue::CreateUInt64Array(report.ErrorHistogram));
+    }
+
+    // Describes where the frames differ, for the log of a failing comparison.
+    inline winrt::hstring DescribeComparisonReport(ComparisonReport const& report, int32_t width)
+    {
+        constexpr const wchar_t* channelNames[] = {L"red", L"green", L"blue"};
+        return winrt::hstring(L"MSE per channel (R, G, B) was ") + std::to_wstring(report.ChannelMse[0]) + L", " +
+               std::to_wstring(report.ChannelMse[1]) + L", " + std::to_wstring(report.ChannelMse[2]) + L". The largest error was " +
+               std::to_wstring(report.MaxAbsoluteError) + L" in the " + channelNames[report.MaxErrorChannel] + L" channel at (" +
+               std::to_wstring(report.MaxErrorPixel % width) + L", " + std::to_wstring(report.MaxErrorPixel / width) + L"), " +
+               std::to_wstring(report.PixelsOverTolerance) + L" of " + std::to_wstring(report.PixelsCompared) +
+               L" pixels compared were over the tolerance of " + std::to_wstring(report.PixelTolerance);
+    }
+
+    // Compares capture to target and attaches the report to the properties of the captured frame. The comparison stops as
+    // soon as the frame is known to be below the PSNR limit, unless the options ask for an exact comparison.
+    inline ComparisonReport CompareRawFrames(
+        winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& target,
+        winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrame const& capture,
+        ComparisonOptions const& options)
+    {
+        if (target == nullptr || capture == nullptr)
+        {
+            Framework::Helpers::Logger().LogError(L"Invalid arguments passed to CompareRawFrames.");
+            throw winrt::hresult_invalid_argument();
+        }
+
+        const size_t numPixels = static_cast<size_t>(capture.Resolution().Width) * capture.Resolution().Height;
+        const auto analyticTarget = GetAnalyticFrame(target, capture.Resolution());
+        const auto tiledTarget = GetTiledFrame(target, capture.Resolution());
+        const auto capturePixels = GetScRgbPixels(capture, numPixels);
+
+        ComparisonReport report;
+        if (analyticTarget)
+        {
+            report = CompareFrames(*analyticTarget, capturePixels.Pixels, options);
+        }
+        else if (tiledTarget)
+        {
+            report = CompareFrames(*tiledTarget, capturePixels.Pixels, options);
+        }
+        else
+        {
+            const auto targetPixels = GetScRgbPixels(target, numPixels);
+            report = CompareFrames(targetPixels.Pixels, capturePixels.Pixels, options);
+        }
+
+        AddComparisonReport(capture, report);
+        return report;
+    }
+
+    // Logs the outcome of comparing frame index of a capture, with the details of where the frames differ on a failure.
+    inline void LogComparisonReport(ComparisonReport const& report, uint32_t index, int32_t width, double psnrLimit)
+    {
+        const auto logger = Framework::Helpers::Logger();
+
+        if (report.Passed)
+        {
+            logger.LogNote(
+                winrt::hstring(L"PSNR for frame ") + std::to_wstring(index) + L" was " + std::to_wstring(report.Psnr) +
+                L", which is above the threshold of " + std::to_wstring(psnrLimit));
+            return;
+        }
+
+        if (report.PsnrFailed)
+        {
+            logger.LogError(
+                winrt::hstring(L"PSNR for frame ") + std::to_wstring(index) + (report.Complete ? L" was " : L" was at most ") +
+                std::to_wstring(report.Psnr) + L", which is below the threshold of " + std::to_wstring(psnrLimit));
+        }
+
+        if (report.PixelBudgetExceeded)
+        {
+            logger.LogError(
+                winrt::hstring(L"Frame ") + std::to_wstring(index) + (report.Complete ? L" had " : L" had at least ") +
+                std::to_wstring(report.PixelsOverTolerance) + L" pixels over the per-pixel tolerance, which is more than the " +
+                std::to_wstring(report.PixelBudget) + L" allowed");
+        }
+
+        logger.LogNote(DescribeComparisonReport(report, width));
+    }
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries::FrameComparison
@@ -0,0 +1,740 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "AnalyticFrame.h"
+#include "HalfFloat.h"
+#include "ThreadPool.h"
+#include "TiledFrame.h"
+
+//
+// CPU comparison of R16G16B16A16_FLOAT (scRGB) frames.
+//
+// Both frames are read directly from their buffers, converted from half to float with F16C or NEON where available and
+// the squared RGB differences are summed in the same pass, so no intermediate per-pixel buffer is ever created. The frame
+// is split into fixed size blocks that are summed in double precision on the thread pool and then combined pairwise. The
+// accumulation order depends only on the frame size, so the result is the same on every run, for any number of threads,
+// and for the scalar and vector paths alike. CompareFrames gathers the per-channel error, the largest error and an error
+// histogram in the same pass, for a report on where two frames differ. A prediction held as an AnalyticFrame or a
+// TiledFrame can be compared against as it is, one run of pixels at a time.
+//
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries::FrameComparison {
+
+    // The peak value for the scRGB format of our intermediates.
+    constexpr double ScRgbPeak = 7.5;
+
+    // The number of bins in the error histogram of a ComparisonReport.
+    constexpr uint32_t HistogramBins = 256;
+
+    namespace Details {
+
+        // Pixels per block, every block is summed independently so that the result doesn't depend on how blocks are
+        // distributed across threads.
+        constexpr size_t BlockPixels = 16384;
+
+        // Running sums of the squared difference for each channel (RGBA), kept separately for even and odd pixels. This
+        // is exactly the layout a 256-bit register pair sees, which is what keeps the vector and scalar results identical.
+        struct BlockAccumulator
+        {
+            double Even[4]{};
+            double Odd[4]{};
+
+            double Total() const
+            {
+                return (Even[0] + Even[1] + Even[2]) + (Odd[0] + Odd[1] + Odd[2]);
+            }
+
+            double Channel(uint32_t channel) const
+            {
+                return Even[channel] + Odd[channel];
+            }
+        };
+
+        // Per-pixel statistics for a report, gathered in the same pass as the squared differences. A pixel's error is the
+        // largest absolute difference of its R, G and B channels. Pixel indices are relative to the block they came from.
+        struct PixelStatistics
+        {
+            PixelStatistics(double tolerance, double histogramRange) :
+                Tolerance(static_cast<float>(tolerance)),
+                HistogramScale(static_cast<float>(HistogramBins / histogramRange)),
+                QuietLimit(static_cast<float>((std::min)(tolerance, histogramRange / HistogramBins * (1.0 - 1e-6))))
+            {
+            }
+
+            float Tolerance;
+            float HistogramScale;
+
+            // A pixel with no channel error above this is in the first bin and within the tolerance, which is the case for
+            // nearly every pixel of a good capture. The vector paths count these with a compare rather than through Count().
+            float QuietLimit;
+
+            float MaxError = 0.0f;
+            size_t MaxErrorPixel = 0;
+            uint32_t MaxErrorChannel = 0;
+            uint64_t PixelsOverTolerance = 0;
+            std::array<uint64_t, HistogramBins> Histogram{};
+
+            // error holds the absolute R, G and B differences of the pixel.
+            void Record(const float* error, size_t pixel)
+            {
+                uint32_t channel = error[1] > error[0] ? 1 : 0;
+                channel = error[2] > error[channel] ? 2 : channel;
+
+                // A NaN in any channel counts as over the tolerance and goes in the last bin, but is never the maximum
+                if (std::isnan(error[0]) || std::isnan(error[1]) || std::isnan(error[2]))
+                {
+                    Count(std::numeric_limits<float>::infinity());
+                    return;
+                }
+
+                Count(error[channel]);
+                if (error[channel] > MaxError)
+                {
+                    MaxError = error[channel];
+                    MaxErrorPixel = pixel;
+                    MaxErrorChannel = channel;
+                }
+            }
+
+            // Adds a pixel that is already known to hold no NaN and no new maximum, given its largest channel error. It has
+            // no branches on the error for the vector paths to mispredict on a noisy capture.
+            void Count(float pixelError)
+            {
+                const float bin = (std::min)(pixelError * HistogramScale, static_cast<float>(HistogramBins - 1));
+                Histogram[static_cast<uint32_t>(bin)]++;
+                PixelsOverTolerance += pixelError > Tolerance ? 1 : 0;
+            }
+
+            // Adds the statistics of a block starting at firstPixel. Ties for the maximum go to the lowest pixel, so the
+            // result doesn't depend on the order blocks are merged in.
+            void Merge(const PixelStatistics& block, size_t firstPixel)
+            {
+                for (uint32_t bin = 0; bin < HistogramBins; bin++)
+                {
+                    Histogram[bin] += block.Histogram[bin];
+                }
+
+                PixelsOverTolerance += block.PixelsOverTolerance;
+
+                const size_t blockMaxPixel = firstPixel + block.MaxErrorPixel;
+                if (block.MaxError > MaxError || (block.MaxError == MaxError && blockMaxPixel < MaxErrorPixel))
+                {
+                    MaxError = block.MaxError;
+                    MaxErrorPixel = blockMaxPixel;
+                    MaxErrorChannel = block.MaxErrorChannel;
+                }
+            }
+        };
+
+        // Accumulates pixels [first, count) of the block, a points at the pixel compared against b[first]. With ConstantA,
+        // a is a single pixel that every pixel of b is compared against.
+        template <bool Detailed, bool ConstantA = false>
+        inline void AccumulateScalar(
+            const uint64_t* a, const uint64_t* b, size_t first, size_t count, BlockAccumulator& accumulator, PixelStatistics* statistics)
+        {
+            for (size_t i = first; i < count; i++)
+            {
+                double* sums = (i % 2) ? accumulator.Odd : accumulator.Even;
+                float error[4];
+                for (uint32_t channel = 0; channel < 4; channel++)
+                {
+                    const float valueA = HalfFloat::ToFloat(static_cast<uint16_t>(a[ConstantA ? 0 : i - first] >> (channel * 16)));
+                    const float valueB = HalfFloat::ToFloat(static_cast<uint16_t>(b[i] >> (channel * 16)));
+                    const float difference = valueA - valueB;
+                    sums[channel] += static_cast<double>(difference * difference);
+                    error[channel] = std::fabs(difference);
+                }
+
+                if constexpr (Detailed)
+                {
+                    statistics->Record(error, i);
+                }
+            }
+        }
+
+#if defined(_M_X64) || defined(__x86_64__)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FRAME_COMPARISON_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define FRAME_COMPARISON_TARGET_F16C
+#endif
+
+        // F16C needs AVX, which in turn needs the OS to save the YMM registers.
+        inline bool CpuSupportsF16c()
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            const bool f16c = (info[2] & (1 << 29)) != 0;
+            return osxsave && avx && f16c && (_xgetbv(0) & 0x6) == 0x6;
+#else
+            return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+        }
+
+        inline bool UseF16c()
+        {
+            static const bool useF16c = CpuSupportsF16c();
+            return useF16c;
+        }
+
+        // Four pixels per iteration, each 128-bit half of a load is two pixels which convert to eight floats. Adds pixels
+        // from first (which must be even) on to the accumulator and returns where it stopped, the caller finishes the rest.
+        // a is indexed as in AccumulateScalar.
+        template <bool Detailed, bool ConstantA = false>
+        FRAME_COMPARISON_TARGET_F16C inline size_t AccumulateF16c(
+            const uint64_t* a, const uint64_t* b, size_t first, size_t count, BlockAccumulator& accumulator, PixelStatistics* statistics)
+        {
+            __m256d even = _mm256_loadu_pd(accumulator.Even);
+            __m256d odd = _mm256_loadu_pd(accumulator.Odd);
+            const __m256i constantA = ConstantA ? _mm256_set1_epi64x(static_cast<long long>(a[0])) : _mm256_setzero_si256();
+
+            const __m256 absoluteMask = _mm256_castsi256_ps(_mm256_set_epi32(0, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0, 0x7fffffff, 0x7fffffff, 0x7fffffff));
+            __m256 maxError = Detailed ? _mm256_set1_ps(statistics->MaxError) : _mm256_setzero_ps();
+            const __m256 quietLimit = Detailed ? _mm256_set1_ps(statistics->QuietLimit) : _mm256_setzero_ps();
+            uint64_t quietPixels = 0;
+
+            const size_t vectorEnd = first + ((count - first) & ~size_t(3));
+            for (size_t i = first; i < vectorEnd; i += 4)
+            {
+                const __m256i pixelsA = ConstantA ? constantA : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + (i - first)));
+                const __m256i pixelsB = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+                for (int half = 0; half < 2; half++)
+                {
+                    const __m128i halvesA = half ? _mm256_extractf128_si256(pixelsA, 1) : _mm256_castsi256_si128(pixelsA);
+                    const __m128i halvesB = half ? _mm256_extractf128_si256(pixelsB, 1) : _mm256_castsi256_si128(pixelsB);
+
+                    const __m256 difference = _mm256_sub_ps(_mm256_cvtph_ps(halvesA), _mm256_cvtph_ps(halvesB));
+                    const __m256 squared = _mm256_mul_ps(difference, difference);
+
+                    even = _mm256_add_pd(even, _mm256_cvtps_pd(_mm256_castps256_ps128(squared)));
+                    odd = _mm256_add_pd(odd, _mm256_cvtps_pd(_mm256_extractf128_ps(squared, 1)));
+
+                    if constexpr (Detailed)
+                    {
+                        // Absolute R, G and B errors of the two pixels, alpha is cleared
+                        const __m256 error = _mm256_and_ps(difference, absoluteMask);
+
+                        if (_mm256_movemask_ps(_mm256_cmp_ps(error, maxError, _CMP_NLE_UQ)) != 0)
+                        {
+                            // A new maximum or a NaN
+                            alignas(32) float errors[8];
+                            _mm256_store_ps(errors, error);
+                            statistics->Record(errors, i + half * 2);
+                            statistics->Record(errors + 4, i + half * 2 + 1);
+                            maxError = _mm256_set1_ps(statistics->MaxError);
+                        }
+                        else if (_mm256_movemask_ps(_mm256_cmp_ps(error, quietLimit, _CMP_GT_OQ)) == 0)
+                        {
+                            quietPixels += 2;
+                        }
+                        else
+                        {
+                            // Largest channel error of each pixel, in the low lane of its 128-bit half
+                            __m256 largest = _mm256_max_ps(error, _mm256_permute_ps(error, _MM_SHUFFLE(2, 3, 0, 1)));
+                            largest = _mm256_max_ps(largest, _mm256_permute_ps(largest, _MM_SHUFFLE(1, 0, 3, 2)));
+                            statistics->Count(_mm256_cvtss_f32(largest));
+                            statistics->Count(_mm_cvtss_f32(_mm256_extractf128_ps(largest, 1)));
+                        }
+                    }
+                }
+            }
+
+            if constexpr (Detailed)
+            {
+                statistics->Histogram[0] += quietPixels;
+            }
+
+            _mm256_storeu_pd(accumulator.Even, even);
+            _mm256_storeu_pd(accumulator.Odd, odd);
+            return vectorEnd;
+        }
+
+#undef FRAME_COMPARISON_TARGET_F16C
+
+#elif defined(_M_ARM64) || defined(__aarch64__)
+
+        // Two pixels per iteration, each 128-bit load is two pixels which convert to two float32x4 vectors. Adds pixels
+        // from first (which must be even) on to the accumulator and returns where it stopped, the caller finishes the rest.
+        // a is indexed as in AccumulateScalar.
+        template <bool Detailed, bool ConstantA = false>
+        inline size_t AccumulateNeon(
+            const uint64_t* a, const uint64_t* b, size_t first, size_t count, BlockAccumulator& accumulator, PixelStatistics* statistics)
+        {
+            float64x2_t evenRg = vld1q_f64(accumulator.Even), evenBa = vld1q_f64(accumulator.Even + 2);
+            float64x2_t oddRg = vld1q_f64(accumulator.Odd), oddBa = vld1q_f64(accumulator.Odd + 2);
+            const uint16x8_t constantA = vreinterpretq_u16_u64(vdupq_n_u64(a[0]));
+            uint64_t quietPixels = 0;
+
+            const size_t vectorEnd = first + ((count - first) & ~size_t(1));
+            for (size_t i = first; i < vectorEnd; i += 2)
+            {
+                const uint16x8_t pixelsA = ConstantA ? constantA : vld1q_u16(reinterpret_cast<const uint16_t*>(a + (i - first)));
+                const uint16x8_t pixelsB = vld1q_u16(reinterpret_cast<const uint16_t*>(b + i));
+
+                const float32x4_t evenDifference = vsubq_f32(
+                    vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(pixelsA))), vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(pixelsB))));
+                const float32x4_t oddDifference = vsubq_f32(
+                    vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(pixelsA))), vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(pixelsB))));
+
+                const float32x4_t evenSquared = vmulq_f32(evenDifference, evenDifference);
+                const float32x4_t oddSquared = vmulq_f32(oddDifference, oddDifference);
+
+                evenRg = vaddq_f64(evenRg, vcvt_f64_f32(vget_low_f32(evenSquared)));
+                evenBa = vaddq_f64(evenBa, vcvt_high_f64_f32(evenSquared));
+                oddRg = vaddq_f64(oddRg, vcvt_f64_f32(vget_low_f32(oddSquared)));
+                oddBa = vaddq_f64(oddBa, vcvt_high_f64_f32(oddSquared));
+
+                if constexpr (Detailed)
+                {
+                    // Alpha is cleared, the largest R, G or B error of each pixel is then the largest lane
+                    const float32x4_t evenError = vsetq_lane_f32(0.0f, vabsq_f32(evenDifference), 3);
+                    const float32x4_t oddError = vsetq_lane_f32(0.0f, vabsq_f32(oddDifference), 3);
+                    const float evenLargest = vmaxvq_f32(evenError);
+                    const float oddLargest = vmaxvq_f32(oddError);
+
+                    // A NaN makes the largest lane NaN, which fails the comparison like a new maximum does
+                    if (!(evenLargest <= statistics->MaxError) || !(oddLargest <= statistics->MaxError))
+                    {
+                        float errors[8];
+                        vst1q_f32(errors, evenError);
+                        vst1q_f32(errors + 4, oddError);
+                        statistics->Record(errors, i);
+                        statistics->Record(errors + 4, i + 1);
+                    }
+                    else if ((std::max)(evenLargest, oddLargest) <= statistics->QuietLimit)
+                    {
+                        quietPixels += 2;
+                    }
+                    else
+                    {
+                        statistics->Count(evenLargest);
+                        statistics->Count(oddLargest);
+                    }
+                }
+            }
+
+            if constexpr (Detailed)
+            {
+                statistics->Histogram[0] += quietPixels;
+            }
+
+            vst1q_f64(accumulator.Even, evenRg);
+            vst1q_f64(accumulator.Even + 2, evenBa);
+            vst1q_f64(accumulator.Odd, oddRg);
+            vst1q_f64(accumulator.Odd + 2, oddBa);
+            return vectorEnd;
+        }
+
+#endif
+
+        // Sums a block of pixels, gathering the per-pixel statistics as well when Detailed is set.
+        template <bool Detailed>
+        inline BlockAccumulator AccumulateBlock(const uint64_t* a, const uint64_t* b, size_t count, PixelStatistics* statistics)
+        {
+            BlockAccumulator accumulator;
+            size_t done = 0;
+
+#if defined(_M_X64) || defined(__x86_64__)
+            if (UseF16c())
+            {
+                done = AccumulateF16c<Detailed>(a, b, 0, count, accumulator, statistics);
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            done = AccumulateNeon<Detailed>(a, b, 0, count, accumulator, statistics);
+#endif
+
+            AccumulateScalar<Detailed>(a + done, b, done, count, accumulator, statistics);
+            return accumulator;
+        }
+
+        // Adds pixels [first, last) of a block to the accumulator, comparing them against the run of predicted pixels at
+        // predicted, or against the one pixel at predicted when Repeated. Each pixel lands in the same sum, in the same
+        // order, as it would comparing against a materialized frame, so the result is bit for bit the same.
+        template <bool Detailed, bool Repeated>
+        inline void AccumulateRun(
+            const uint64_t* predicted, const uint64_t* block, size_t first, size_t last, BlockAccumulator& accumulator, PixelStatistics* statistics)
+        {
+            // The vector kernels start on an even pixel
+            if (first % 2 != 0 && first < last)
+            {
+                AccumulateScalar<Detailed, Repeated>(predicted, block, first, first + 1, accumulator, statistics);
+                predicted += Repeated ? 0 : 1;
+                first++;
+            }
+
+            size_t done = first;
+#if defined(_M_X64) || defined(__x86_64__)
+            if (UseF16c())
+            {
+                done = AccumulateF16c<Detailed, Repeated>(predicted, block, first, last, accumulator, statistics);
+            }
+#elif defined(_M_ARM64) || defined(__aarch64__)
+            done = AccumulateNeon<Detailed, Repeated>(predicted, block, first, last, accumulator, statistics);
+#endif
+
+            AccumulateScalar<Detailed, Repeated>(predicted + (Repeated ? 0 : done - first), block, done, last, accumulator, statistics);
+        }
+
+        inline double PairwiseSum(std::span<const double> values)
+        {
+            if (values.size() <= 2)
+            {
+                return values.empty() ? 0.0 : (values.size() == 1 ? values[0] : values[0] + values[1]);
+            }
+
+            const size_t middle = values.size() / 2;
+            return PairwiseSum(values.first(middle)) + PairwiseSum(values.subspan(middle));
+        }
+
+    } // namespace Details
+
+    // Returns the sum of the squared differences of the R, G and B channels of every pixel, alpha is ignored. Only the
+    // pixels present in both frames are compared, callers are expected to have checked that the frames match in size.
+    inline double SumSquaredDifference(
+        std::span<const uint64_t> frameA, std::span<const uint64_t> frameB, ThreadPool& pool = ThreadPool::Default())
+    {
+        const size_t pixelCount = (std::min)(frameA.size(), frameB.size());
+        const size_t blockCount = (pixelCount + Details::BlockPixels - 1) / Details::BlockPixels;
+
+        std::vector<double> blockSums(blockCount);
+        pool.ParallelFor(static_cast<uint32_t>(blockCount), [&](uint32_t block) {
+            const size_t first = block * Details::BlockPixels;
+            const size_t count = (std::min)(Details::BlockPixels, pixelCount - first);
+            blockSums[block] = Details::AccumulateBlock<false>(frameA.data() + first, frameB.data() + first, count, nullptr).Total();
+        });
+
+        return Details::PairwiseSum(blockSums);
+    }
+
+    // No pixels have no error, so an empty frame has an infinite PSNR like an identical one.
+    inline double PsnrFromSquaredDifference(double squaredDifference, size_t pixelCount)
+    {
+        if (pixelCount == 0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        const double mse = squaredDifference / (static_cast<double>(pixelCount) * 3); // 3 channels
+        return 20.0 * std::log10((ScRgbPeak * ScRgbPeak) / mse);
+    }
+
+    // The mean squared error per color channel.
+    inline double ComputeMse(std::span<const uint64_t> frameA, std::span<const uint64_t> frameB)
+    {
+        const size_t pixelCount = (std::min)(frameA.size(), frameB.size());
+        if (pixelCount == 0)
+        {
+            return 0.0;
+        }
+
+        return SumSquaredDifference(frameA, frameB) / (static_cast<double>(pixelCount) * 3);
+    }
+
+    inline double ComputePsnr(std::span<const uint64_t> frameA, std::span<const uint64_t> frameB)
+    {
+        const size_t pixelCount = (std::min)(frameA.size(), frameB.size());
+        return PsnrFromSquaredDifference(SumSquaredDifference(frameA, frameB), pixelCount);
+    }
+
+    struct ComparisonOptions
+    {
+        // Frames with a PSNR below this fail.
+        double PsnrLimit = 0.0;
+
+        // Compare failing frames in full rather than stopping as soon as the frame is known to fail.
+        bool Exact = false;
+
+        // Pixels with an error above this in any of R, G or B are counted as over the tolerance.
+        double PixelTolerance = 1.0 / 255;
+
+        // Fail frames with more than PixelBudget (a fraction of all pixels) over the tolerance, whatever their PSNR.
+        // Otherwise the count is only reported.
+        bool EnforcePixelTolerance = false;
+        double PixelBudget = 0.0;
+
+        // The range of errors covered by the histogram, errors at or beyond it go in the last bin.
+        double HistogramRange = 1.0;
+    };
+
+    struct ComparisonReport
+    {
+        // Whether the PSNR is at or above the limit and, if the pixel tolerance is enforced, no more pixels than the
+        // budget are over it.
+        bool Passed = false;
+
+        // Whether every pixel was compared. If not, the comparison stopped as soon as the pixels seen so far guaranteed a
+        // failure. Psnr is then an upper bound, the real PSNR is no higher than it, and every other statistic only covers
+        // the PixelsCompared pixels that were looked at.
+        bool Complete = false;
+
+        // Why the frame failed, either or both may be set. For an incomplete comparison these only say what was already
+        // certain when it stopped.
+        bool PsnrFailed = false;
+        bool PixelBudgetExceeded = false;
+
+        size_t PixelCount = 0;
+        size_t PixelsCompared = 0;
+
+        double Psnr = 0.0;
+
+        // Mean squared error of the R, G and B channels.
+        std::array<double, 3> ChannelMse{};
+
+        // The largest absolute error of any channel, the pixel index (row major) it was found at and which channel.
+        double MaxAbsoluteError = 0.0;
+        size_t MaxErrorPixel = 0;
+        uint32_t MaxErrorChannel = 0;
+
+        double PixelTolerance = 0.0;
+        uint64_t PixelsOverTolerance = 0;
+
+        // The most pixels that may be over the tolerance, only meaningful when the tolerance is enforced.
+        uint64_t PixelBudget = 0;
+
+        // Count of pixels by their largest channel error, bin i covers [i, i + 1) * HistogramRange / HistogramBins.
+        double HistogramRange = 0.0;
+        std::array<uint64_t, HistogramBins> ErrorHistogram{};
+    };
+
+    namespace Details {
+
+        // Compares pixelCount pixels a block at a time, accumulateBlock(first, count, statistics) sums the block of count
+        // pixels starting at first.
+        template <typename AccumulateFunction>
+        inline ComparisonReport Compare(
+            size_t pixelCount, AccumulateFunction&& accumulateBlock, const ComparisonOptions& options, ThreadPool& pool)
+        {
+            const size_t blockCount = (pixelCount + BlockPixels - 1) / BlockPixels;
+
+            // Inverting the PSNR formula gives the largest total squared difference that still passes. A little slack keeps
+            // rounding from failing a frame early that the full pairwise sum would have passed.
+            const double mseLimit = (ScRgbPeak * ScRgbPeak) / std::pow(10.0, options.PsnrLimit / 20.0);
+            const double errorLimit = mseLimit * static_cast<double>(pixelCount) * 3 * (1.0 + 1e-9);
+            const uint64_t pixelBudget = static_cast<uint64_t>(options.PixelBudget * static_cast<double>(pixelCount));
+
+            std::vector<BlockAccumulator> blocks(blockCount);
+            std::atomic<double> errorSoFar{0.0};
+            std::atomic<size_t> pixelsCompared{0};
+            std::atomic<bool> failed{false};
+            std::atomic<bool> errorOverLimit{false};
+
+            PixelStatistics statistics(options.PixelTolerance, options.HistogramRange);
+            std::mutex statisticsLock;
+
+            pool.ParallelFor(static_cast<uint32_t>(blockCount), [&](uint32_t block) {
+                if (failed.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+
+                const size_t first = block * BlockPixels;
+                const size_t count = (std::min)(BlockPixels, pixelCount - first);
+
+                PixelStatistics blockStatistics(options.PixelTolerance, options.HistogramRange);
+                blocks[block] = accumulateBlock(first, count, &blockStatistics);
+
+                // Like the error, the count of pixels over the tolerance only grows, so once it is over the budget the
+                // frame has failed
+                bool overBudget = false;
+                {
+                    std::lock_guard lock(statisticsLock);
+                    statistics.Merge(blockStatistics, first);
+                    overBudget = options.EnforcePixelTolerance && statistics.PixelsOverTolerance > pixelBudget;
+                }
+
+                pixelsCompared.fetch_add(count, std::memory_order_relaxed);
+
+                // NaNs never compare greater, so frames containing them are always compared in full like ComputePsnr does
+                const double blockSum = blocks[block].Total();
+                double total = errorSoFar.load(std::memory_order_relaxed);
+                while (!errorSoFar.compare_exchange_weak(total, total + blockSum, std::memory_order_relaxed))
+                {
+                }
+
+                if (total + blockSum > errorLimit)
+                {
+                    errorOverLimit.store(true, std::memory_order_relaxed);
+                }
+
+                if (!options.Exact && (total + blockSum > errorLimit || overBudget))
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            });
+
+            ComparisonReport report;
+            report.PixelCount = pixelCount;
+            report.PixelsCompared = pixelsCompared.load();
+
+            // The block that crossed a limit may also have been the last one left, in which case nothing was skipped
+            report.Complete = report.PixelsCompared == pixelCount;
+
+            // Blocks that were skipped are all zero, so they add nothing to the sums. Summing the blocks in order rather
+            // than taking the running total keeps the PSNR of a frame that stopped early independent of the order in which
+            // threads finished.
+            std::vector<double> sums(blockCount);
+            std::transform(blocks.begin(), blocks.end(), sums.begin(), [](const BlockAccumulator& block) { return block.Total(); });
+            const double squaredDifference = PairwiseSum(sums);
+            report.Psnr = PsnrFromSquaredDifference(squaredDifference, pixelCount);
+            if (report.Complete)
+            {
+                report.PsnrFailed = report.Psnr < options.PsnrLimit;
+            }
+            else
+            {
+                report.PsnrFailed = errorOverLimit.load() || squaredDifference > errorLimit;
+            }
+
+            report.PixelBudgetExceeded = options.EnforcePixelTolerance && statistics.PixelsOverTolerance > pixelBudget;
+            report.Passed = !report.PsnrFailed && !report.PixelBudgetExceeded;
+
+            // With no pixels compared (an empty frame) there is no error in any channel
+            for (uint32_t channel = 0; channel < 3 && report.PixelsCompared > 0; channel++)
+            {
+                std::transform(blocks.begin(), blocks.end(), sums.begin(), [channel](const BlockAccumulator& block) {
+                    return block.Channel(channel);
+                });
+                report.ChannelMse[channel] = PairwiseSum(sums) / static_cast<double>(report.PixelsCompared);
+            }
+
+            report.MaxAbsoluteError = statistics.MaxError;
+            report.MaxErrorPixel = statistics.MaxErrorPixel;
+            report.MaxErrorChannel = statistics.MaxErrorChannel;
+            report.PixelTolerance = options.PixelTolerance;
+            report.PixelsOverTolerance = statistics.PixelsOverTolerance;
+            report.PixelBudget = pixelBudget;
+            report.HistogramRange = options.HistogramRange;
+            report.ErrorHistogram = statistics.Histogram;
+            return report;
+        }
+
+        // Sums a block of a frame against a prediction that is read a run of pixels at a time, an AnalyticFrame or a
+        // TiledFrame
+        template <typename RunFrame>
+        inline BlockAccumulator AccumulateRunBlock(
+            const RunFrame& predicted, const uint64_t* frame, size_t first, size_t count, PixelStatistics* statistics)
+        {
+            BlockAccumulator accumulator;
+            const uint64_t* block = frame + first;
+            const size_t width = predicted.Width();
+
+            for (size_t rowStart = first - first % width; rowStart < first + count; rowStart += width)
+            {
+                predicted.ForEachRun(
+                    static_cast<uint32_t>(rowStart / width), [&](uint32_t left, uint32_t right, const uint64_t* pixels, bool repeated) {
+                        // The run clipped to the block, relative to the block
+                        const size_t runFirst = (std::max)(rowStart + left, first);
+                        const size_t runLast = (std::min)(rowStart + right, first + count);
+                        if (runFirst >= runLast)
+                        {
+                            return;
+                        }
+
+                        if (repeated)
+                        {
+                            AccumulateRun<true, true>(pixels, block, runFirst - first, runLast - first, accumulator, statistics);
+                        }
+                        else
+                        {
+                            AccumulateRun<true, false>(
+                                pixels + (runFirst - rowStart - left), block, runFirst - first, runLast - first, accumulator, statistics);
+                        }
+                    });
+            }
+
+            return accumulator;
+        }
+
+        template <typename RunFrame>
+        inline ComparisonReport CompareRuns(
+            const RunFrame& predicted, std::span<const uint64_t> frame, const ComparisonOptions& options, ThreadPool& pool)
+        {
+            const size_t pixelCount = (std::min)(static_cast<size_t>(predicted.Width()) * predicted.Height(), frame.size());
+            return Compare(
+                pixelCount,
+                [&](size_t first, size_t count, PixelStatistics* statistics) {
+                    return AccumulateRunBlock(predicted, frame.data(), first, count, statistics);
+                },
+                options,
+                pool);
+        }
+
+    } // namespace Details
+
+    //
+    // Compares two frames against a PSNR limit, and optionally a per-pixel tolerance, producing a full report of where they
+    // differ in the same pass.
+    //
+    // Alongside the squared differences each pixel's absolute error is checked against the tolerance and the histogram.
+    // Nearly every pixel of a good capture falls in the first bin, which the vector paths check for several channels at a
+    // time, so the report costs little over the PSNR alone. The integer statistics are merged per block and don't depend
+    // on the number of threads.
+    //
+    // The error summed so far is a lower bound on the error of the whole frame, so once it goes over what the limit allows
+    // the frame has failed and the blocks that haven't started yet are skipped. The same goes for the count of pixels over
+    // the tolerance when it is enforced. There is no useful upper bound on what the remaining pixels could add (fp16 values
+    // are unbounded), so a passing frame is always compared in full and gets the same PSNR as ComputePsnr. Setting Exact
+    // compares failing frames in full as well, for when the numbers are wanted.
+    //
+    inline ComparisonReport CompareFrames(
+        std::span<const uint64_t> frameA,
+        std::span<const uint64_t> frameB,
+        const ComparisonOptions& options,
+        ThreadPool& pool = ThreadPool::Default())
+    {
+        return Details::Compare(
+            (std::min)(frameA.size(), frameB.size()),
+            [&](size_t first, size_t count, Details::PixelStatistics* statistics) {
+                return Details::AccumulateBlock<true>(frameA.data() + first, frameB.data() + first, count, statistics);
+            },
+            options,
+            pool);
+    }
+
+    //
+    // Compares a frame against a prediction described by an AnalyticFrame, without rendering the prediction. The frame is
+    // walked one constant span at a time, comparing every pixel of the span against the same predicted pixel, and the
+    // report is bit for bit the one CompareFrames gives against the rendered prediction.
+    //
+    inline ComparisonReport CompareFrames(
+        const AnalyticFrame& predicted,
+        std::span<const uint64_t> frame,
+        const ComparisonOptions& options,
+        ThreadPool& pool = ThreadPool::Default())
+    {
+        return Details::CompareRuns(predicted, frame, options, pool);
+    }
+
+    // Compares a frame against a prediction held as a TiledFrame, reading the tiles as they are. The report is bit for bit
+    // the one CompareFrames gives against the decoded prediction.
+    inline ComparisonReport CompareFrames(
+        const TiledFrame& predicted,
+        std::span<const uint64_t> frame,
+        const ComparisonOptions& options,
+        ThreadPool& pool = ThreadPool::Default())
+    {
+        return Details::CompareRuns(predicted, frame, options, pool);
+    }
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries::FrameComparison
@@ -0,0 +1,69 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries::HalfFloat {
+
+    // Converts an IEEE 754 binary32 value to binary16 using round-to-nearest-even, matching what the D3D runtime does
+    // when a shader writes to a R16G16B16A16_FLOAT resource. NaNs stay NaNs, out of range values become infinities.
+    inline uint16_t FromFloat(float value)
+    {
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        const uint32_t sign = bits & 0x80000000;
+        bits ^= sign;
+
+        uint32_t half;
+        if (bits >= 0x47800000)
+        {
+            // Too large for a half (2^16 and up), infinity or NaN. Keep NaNs quiet.
+            half = bits > 0x7F800000 ? 0x7E00 | ((bits & 0x007FFFFF) >> 13) : 0x7C00;
+        }
+        else if (bits < 0x38800000)
+        {
+            // The result is a half denormal (or zero). Adding 0.5 lines the half's mantissa up with the bottom of the
+            // float's, so the FPU does the round-to-nearest-even for us.
+            const uint32_t denormalMagic = 0x3F000000;
+            half = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + std::bit_cast<float>(denormalMagic)) - denormalMagic;
+        }
+        else
+        {
+            // Rebias the exponent and round to nearest even on the 13 dropped mantissa bits. A carry out of the mantissa
+            // correctly bumps the exponent (and rounds up to infinity at the top).
+            const uint32_t mantissaOdd = (bits >> 13) & 1;
+            bits += 0xC8000FFF + mantissaOdd;
+            half = bits >> 13;
+        }
+
+        return static_cast<uint16_t>((sign >> 16) | half);
+    }
+
+    // Converts an IEEE 754 binary16 value to binary32, this is always exact.
+    inline float ToFloat(uint16_t value)
+    {
+        const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1F;
+        const uint32_t mantissa = value & 0x03FF;
+
+        if (exponent == 0)
+        {
+            // Zero or denormal, mantissa * 2^-24 is exactly representable as a float
+            const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            return sign ? -magnitude : magnitude;
+        }
+
+        if (exponent == 0x1F)
+        {
+            return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+        }
+
+        return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    // Packs a linear RGBA value into a single R16G16B16A16_FLOAT pixel as laid out in memory.
+    inline uint64_t PackRgba(float r, float g, float b, float a)
+    {
+        return static_cast<uint64_t>(FromFloat(r)) | (static_cast<uint64_t>(FromFloat(g)) << 16) |
+               (static_cast<uint64_t>(FromFloat(b)) << 32) | (static_cast<uint64_t>(FromFloat(a)) << 48);
+    }
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries::HalfFloat
@@ -0,0 +1,279 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries {
+
+    //
+    // A small work-stealing thread pool for data-parallel CPU work (frame decoding, comparisons, prediction rendering).
+    //
+    // Each worker owns a queue, work submitted by ParallelFor is spread across the queues and idle workers steal from the
+    // others, so uneven work items still keep every core busy. The thread calling ParallelFor helps execute the work
+    // instead of blocking, which also makes it safe to call ParallelFor from inside a work item. Any number of
+    // ParallelFor calls may run concurrently, there is no lock held across the work itself.
+    //
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(uint32_t threadCount = (std::max)(1u, std::thread::hardware_concurrency())) :
+            m_queues((std::max)(1u, threadCount))
+        {
+            m_workers.reserve(m_queues.size());
+            for (uint32_t index = 0; index < m_queues.size(); index++)
+            {
+                m_workers.emplace_back([this, index] { WorkerLoop(index); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                auto lock = std::scoped_lock(m_wakeLock);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // The process-wide pool, sized to the machine.
+        static ThreadPool& Default()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        uint32_t ThreadCount() const
+        {
+            return static_cast<uint32_t>(m_workers.size());
+        }
+
+        // The index of the pool worker running the calling code, or ThreadCount() when called from outside the pool.
+        uint32_t CurrentWorkerIndex() const
+        {
+            return CurrentWorker().Pool == this ? CurrentWorker().Index : ThreadCount();
+        }
+
+        // A set of tasks that can be added to over time and then waited on together. Tasks start running as soon as they
+        // are added, which lets a producer hand out work as its input becomes available. The group must outlive its
+        // tasks, the destructor waits for any that are still running.
+        class TaskGroup
+        {
+        public:
+            explicit TaskGroup(ThreadPool& pool) : m_pool(pool), m_state(std::make_shared<State>())
+            {
+            }
+
+            ~TaskGroup()
+            {
+                WaitForTasks();
+            }
+
+            TaskGroup(const TaskGroup&) = delete;
+            TaskGroup& operator=(const TaskGroup&) = delete;
+
+            template <typename Body>
+            void Run(Body&& body)
+            {
+                m_state->Remaining.fetch_add(1, std::memory_order_relaxed);
+                m_pool.Push(m_nextQueue++ % m_pool.m_queues.size(), [state = m_state, body = std::forward<Body>(body)]() mutable {
+                    try
+                    {
+                        body();
+                    }
+                    catch (...)
+                    {
+                        auto lock = std::scoped_lock(state->Lock);
+                        if (!state->Error)
+                        {
+                            state->Error = std::current_exception();
+                        }
+                    }
+
+                    if (state->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    {
+                        auto lock = std::scoped_lock(state->Lock);
+                        state->Done.notify_all();
+                    }
+                });
+            }
+
+            // Helps run queued work until every task added so far has completed. If any of them threw, the first
+            // exception is rethrown here.
+            void Wait()
+            {
+                WaitForTasks();
+
+                auto lock = std::scoped_lock(m_state->Lock);
+                if (m_state->Error)
+                {
+                    std::rethrow_exception(std::exchange(m_state->Error, nullptr));
+                }
+            }
+
+        private:
+            struct State
+            {
+                std::atomic<uint32_t> Remaining{0};
+                std::mutex Lock;
+                std::condition_variable Done;
+                std::exception_ptr Error;
+            };
+
+            void WaitForTasks()
+            {
+                // Help out until the group is done, then wait for any tasks still running on other threads
+                while (m_state->Remaining.load(std::memory_order_acquire) != 0)
+                {
+                    if (!m_pool.RunOne(m_pool.CurrentWorkerIndex() % m_pool.m_queues.size()))
+                    {
+                        auto lock = std::unique_lock(m_state->Lock);
+                        m_state->Done.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                            return m_state->Remaining.load(std::memory_order_acquire) == 0;
+                        });
+                    }
+                }
+            }
+
+            ThreadPool& m_pool;
+            std::shared_ptr<State> m_state;
+            size_t m_nextQueue = 0;
+        };
+
+        // Runs body(index) for every index in [0, count) and returns once all of them have completed. If any invocation
+        // throws, the first exception is rethrown here after the remaining work has finished.
+        template <typename Body>
+        void ParallelFor(uint32_t count, Body&& body)
+        {
+            TaskGroup group(*this);
+            for (uint32_t index = 0; index < count; index++)
+            {
+                group.Run([&body, index] { body(index); });
+            }
+
+            group.Wait();
+        }
+
+    private:
+        using Task = std::function<void()>;
+
+        struct WorkQueue
+        {
+            std::mutex Lock;
+            std::deque<Task> Tasks;
+        };
+
+        struct WorkerIdentity
+        {
+            const ThreadPool* Pool = nullptr;
+            uint32_t Index = 0;
+        };
+
+        static WorkerIdentity& CurrentWorker()
+        {
+            static thread_local WorkerIdentity identity;
+            return identity;
+        }
+
+        void Push(size_t queueIndex, Task task)
+        {
+            {
+                auto lock = std::scoped_lock(m_queues[queueIndex].Lock);
+                m_queues[queueIndex].Tasks.push_back(std::move(task));
+            }
+
+            {
+                auto lock = std::scoped_lock(m_wakeLock);
+                m_pending++;
+            }
+            m_wake.notify_one();
+        }
+
+        // Runs a single task, preferring the given queue and stealing from the others when it is empty. Returns false if
+        // there was no work anywhere.
+        bool RunOne(size_t preferredQueue)
+        {
+            Task task;
+            for (size_t offset = 0; offset < m_queues.size() && !task; offset++)
+            {
+                auto& queue = m_queues[(preferredQueue + offset) % m_queues.size()];
+                auto lock = std::scoped_lock(queue.Lock);
+                if (queue.Tasks.empty())
+                {
+                    continue;
+                }
+
+                // Owners take the most recently pushed work, thieves take the oldest
+                if (offset == 0)
+                {
+                    task = std::move(queue.Tasks.back());
+                    queue.Tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.Tasks.front());
+                    queue.Tasks.pop_front();
+                }
+            }
+
+            if (!task)
+            {
+                return false;
+            }
+
+            {
+                auto lock = std::scoped_lock(m_wakeLock);
+                m_pending--;
+            }
+
+            task();
+            return true;
+        }
+
+        void WorkerLoop(uint32_t index)
+        {
+            CurrentWorker() = {this, index};
+
+            while (true)
+            {
+                if (RunOne(index))
+                {
+                    continue;
+                }
+
+                auto lock = std::unique_lock(m_wakeLock);
+                m_wake.wait(lock, [&] { return m_stopping || m_pending != 0; });
+                if (m_stopping && m_pending == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        std::vector<WorkQueue> m_queues;
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_wakeLock;
+        std::condition_variable m_wake;
+        size_t m_pending = 0;
+        bool m_stopping = false;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries
@@ -0,0 +1,527 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries {
+
+    //
+    // A frame of R16G16B16A16_FLOAT (scRGB) pixels held as 64x64 tiles. Each tile is stored as a single color, as runs of
+    // identical pixels or as raw pixels, whichever is smallest.
+    //
+    // Predictions and captures of the standard patterns are mostly long runs of identical pixels, so at 4K and 8K a tiled
+    // frame is a small fraction of the uncompressed buffer. Rows are read through ForEachRun, which hands out runs of one
+    // repeated pixel or of consecutive raw pixels, so comparisons, previews and writers work on the tiles as they are
+    // rather than decompressing the frame first.
+    //
+    // Tiles are immutable and shared between copies of a frame, so a copy only costs a pointer per tile. Setting tiles
+    // of the copy replaces them there and leaves the frame it was copied from as it was, which is how a frame that only
+    // differs from another in a few places is made from it.
+    //
+    // Like an AnalyticFrame, a tiled frame crosses between the projects of the solution serialized into an IRawFrame
+    // property, so no C++ object is ever shared between modules.
+    //
+    class TiledFrame
+    {
+    public:
+        static constexpr uint32_t TileSize = 64;
+
+        // The IRawFrame property holding the serialized tiles (a UInt64 array) of frames that have them
+        static constexpr const wchar_t* PropertyName = L"TiledFrame";
+
+        enum class TileKind : uint8_t
+        {
+            Solid,
+            RunLength,
+            Raw
+        };
+
+        // Every tile starts out as solid transparent black
+        TiledFrame(uint32_t width, uint32_t height) :
+            m_width(width),
+            m_height(height),
+            m_tilesAcross((width + TileSize - 1) / TileSize),
+            m_tilesDown((height + TileSize - 1) / TileSize),
+            m_tiles(static_cast<size_t>(m_tilesAcross) * m_tilesDown, EmptyTile())
+        {
+        }
+
+        // Encodes a full frame sized buffer of pixels
+        static TiledFrame FromPixels(
+            std::span<const uint64_t> pixels, uint32_t width, uint32_t height, ThreadPool& pool = ThreadPool::Default())
+        {
+            TiledFrame frame(width, height);
+            if (pixels.size() < static_cast<size_t>(width) * height)
+            {
+                return frame;
+            }
+
+            pool.ParallelFor(frame.m_tilesDown, [&](uint32_t tileRow) {
+                frame.SetTileRow(tileRow, pixels.data() + static_cast<size_t>(tileRow) * TileSize * width, width);
+            });
+
+            return frame;
+        }
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        uint32_t TilesAcross() const
+        {
+            return m_tilesAcross;
+        }
+
+        uint32_t TilesDown() const
+        {
+            return m_tilesDown;
+        }
+
+        TileKind Kind(uint32_t tileX, uint32_t tileY) const
+        {
+            return m_tiles[static_cast<size_t>(tileY) * m_tilesAcross + tileX]->Kind;
+        }
+
+        // Encodes the row of tiles covering rows [tileRow * TileSize, tileRow * TileSize + TileSize) of the frame. pixels
+        // points at the first of those rows and rows are rowPitch pixels apart. Different rows of tiles can be set from
+        // different threads at the same time.
+        void SetTileRow(uint32_t tileRow, const uint64_t* pixels, size_t rowPitch)
+        {
+            for (uint32_t tileX = 0; tileX < m_tilesAcross; tileX++)
+            {
+                SetTile(tileX, tileRow, pixels + static_cast<size_t>(tileX) * TileSize, rowPitch);
+            }
+        }
+
+        // Encodes a single tile, pixels points at its top left pixel and rows are rowPitch pixels apart. Different tiles
+        // can be set from different threads at the same time.
+        void SetTile(uint32_t tileX, uint32_t tileY, const uint64_t* pixels, size_t rowPitch)
+        {
+            const uint32_t tileWidth = (std::min)(TileSize, m_width - tileX * TileSize);
+            const uint32_t tileHeight = (std::min)(TileSize, m_height - tileY * TileSize);
+
+            auto tile = std::make_shared<Tile>();
+            EncodeTile(*tile, pixels, rowPitch, tileWidth, tileHeight);
+            m_tiles[static_cast<size_t>(tileY) * m_tilesAcross + tileX] = std::move(tile);
+        }
+
+        // Calls function(left, right, pixels, repeated) for the runs covering row y from left to right. pixels points at
+        // the right - left pixels of the run, or at the one pixel repeated across it when repeated is set. Repeated runs
+        // of the same pixel in neighboring tiles are handed out as one.
+        template <typename Function>
+        void ForEachRun(uint32_t y, Function&& function) const
+        {
+            const uint32_t tileY = y / TileSize;
+            const uint32_t row = y % TileSize;
+            const std::shared_ptr<const Tile>* tiles = m_tiles.data() + static_cast<size_t>(tileY) * m_tilesAcross;
+
+            // The repeated run waiting to see if the next run continues it
+            const uint64_t* repeatedPixel = nullptr;
+            uint32_t repeatedLeft = 0, repeatedRight = 0;
+
+            const auto addRun = [&](uint32_t left, uint32_t right, const uint64_t* pixels, bool repeated) {
+                if (repeated && repeatedPixel && *pixels == *repeatedPixel)
+                {
+                    repeatedRight = right;
+                    return;
+                }
+
+                if (repeatedPixel)
+                {
+                    function(repeatedLeft, repeatedRight, repeatedPixel, true);
+                    repeatedPixel = nullptr;
+                }
+
+                if (repeated)
+                {
+                    repeatedPixel = pixels;
+                    repeatedLeft = left;
+                    repeatedRight = right;
+                }
+                else
+                {
+                    function(left, right, pixels, false);
+                }
+            };
+
+            for (uint32_t tileX = 0; tileX < m_tilesAcross; tileX++)
+            {
+                const Tile& tile = *tiles[tileX];
+                const uint32_t left = tileX * TileSize;
+                const uint32_t right = (std::min)(left + TileSize, m_width);
+
+                switch (tile.Kind)
+                {
+                case TileKind::Solid:
+                    addRun(left, right, &tile.Pixel, true);
+                    break;
+
+                case TileKind::Raw:
+                    addRun(left, right, tile.Pixels.data() + static_cast<size_t>(row) * (right - left), false);
+                    break;
+
+                case TileKind::RunLength:
+                    for (uint32_t run = tile.RowRuns[row], runLeft = left; run < tile.RowRuns[row + 1]; run++)
+                    {
+                        const uint32_t runRight = left + tile.Runs[run].Right;
+                        addRun(runLeft, runRight, &tile.Runs[run].Pixel, true);
+                        runLeft = runRight;
+                    }
+                    break;
+                }
+            }
+
+            if (repeatedPixel)
+            {
+                function(repeatedLeft, repeatedRight, repeatedPixel, true);
+            }
+        }
+
+        // Decodes rows [firstRow, firstRow + rowCount) into pixels, which holds rowCount rows of Width() pixels
+        void CopyRows(uint32_t firstRow, uint32_t rowCount, uint64_t* pixels) const
+        {
+            const uint32_t lastRow = (std::min)(firstRow + rowCount, m_height);
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                uint64_t* row = pixels + static_cast<size_t>(y - firstRow) * m_width;
+                ForEachRun(y, [row](uint32_t left, uint32_t right, const uint64_t* runPixels, bool repeated) {
+                    if (repeated)
+                    {
+                        std::fill(row + left, row + right, *runPixels);
+                    }
+                    else
+                    {
+                        std::copy(runPixels, runPixels + (right - left), row + left);
+                    }
+                });
+            }
+        }
+
+        // The memory held by the tiles, tiles shared with other frames are counted by each of them
+        size_t SizeInBytes() const
+        {
+            size_t size = m_tiles.size() * sizeof(std::shared_ptr<const Tile>);
+            for (const auto& tile : m_tiles)
+            {
+                size += sizeof(Tile) + tile->RowRuns.capacity() * sizeof(uint32_t) + tile->Runs.capacity() * sizeof(Run) +
+                        tile->Pixels.capacity() * sizeof(uint64_t);
+            }
+
+            return size;
+        }
+
+        // Flattens the tiles into integers for an IRawFrame property. The layout is a version and the packed frame size,
+        // followed by each tile in row major order. A tile starts with its kind, and for run length tiles the run count in
+        // the upper half. Solid tiles follow it with their pixel, run length tiles with the packed start of each row's
+        // runs and then the right edge and pixel of each run, and raw tiles with their pixels.
+        std::vector<uint64_t> Serialize() const
+        {
+            size_t size = HeaderSize;
+            for (const auto& tile : m_tiles)
+            {
+                size += 1 + (tile->Kind == TileKind::Solid ? 1 : (tile->RowRuns.size() + 1) / 2 + tile->Runs.size() * 2 + tile->Pixels.size());
+            }
+
+            std::vector<uint64_t> data;
+            data.reserve(size);
+            data.push_back(FormatVersion);
+            data.push_back(Pack(m_width, m_height));
+
+            for (const auto& tile : m_tiles)
+            {
+                switch (tile->Kind)
+                {
+                case TileKind::Solid:
+                    data.push_back(static_cast<uint64_t>(TileKind::Solid));
+                    data.push_back(tile->Pixel);
+                    break;
+
+                case TileKind::RunLength:
+                    data.push_back(Pack(static_cast<uint32_t>(TileKind::RunLength), static_cast<uint32_t>(tile->Runs.size())));
+                    for (size_t row = 0; row < tile->RowRuns.size(); row += 2)
+                    {
+                        data.push_back(Pack(tile->RowRuns[row], row + 1 < tile->RowRuns.size() ? tile->RowRuns[row + 1] : 0));
+                    }
+
+                    for (const auto& run : tile->Runs)
+                    {
+                        data.push_back(run.Right);
+                        data.push_back(run.Pixel);
+                    }
+                    break;
+
+                case TileKind::Raw:
+                    data.push_back(static_cast<uint64_t>(TileKind::Raw));
+                    data.insert(data.end(), tile->Pixels.begin(), tile->Pixels.end());
+                    break;
+                }
+            }
+
+            return data;
+        }
+
+        // Returns nothing if the data isn't a frame written by Serialize
+        static std::optional<TiledFrame> Deserialize(std::span<const uint64_t> data)
+        {
+            if (data.size() < HeaderSize || data[0] != FormatVersion)
+            {
+                return std::nullopt;
+            }
+
+            // Every tile takes at least two values, which bounds the frame size before anything is allocated for it
+            const size_t tileCount = (static_cast<size_t>(Low(data[1])) + TileSize - 1) / TileSize *
+                                     ((static_cast<size_t>(High(data[1])) + TileSize - 1) / TileSize);
+            if (tileCount > (data.size() - HeaderSize) / 2)
+            {
+                return std::nullopt;
+            }
+
+            TiledFrame frame(Low(data[1]), High(data[1]));
+            size_t offset = HeaderSize;
+            for (uint32_t tileY = 0; tileY < frame.m_tilesDown; tileY++)
+            {
+                for (uint32_t tileX = 0; tileX < frame.m_tilesAcross; tileX++)
+                {
+                    const uint32_t tileWidth = (std::min)(TileSize, frame.m_width - tileX * TileSize);
+                    const uint32_t tileHeight = (std::min)(TileSize, frame.m_height - tileY * TileSize);
+
+                    auto tile = std::make_shared<Tile>();
+                    if (offset >= data.size() || !DeserializeTile(*tile, data, offset, tileWidth, tileHeight))
+                    {
+                        return std::nullopt;
+                    }
+
+                    frame.m_tiles[static_cast<size_t>(tileY) * frame.m_tilesAcross + tileX] = std::move(tile);
+                }
+            }
+
+            if (offset != data.size())
+            {
+                return std::nullopt;
+            }
+
+            return frame;
+        }
+
+    private:
+        static constexpr uint64_t FormatVersion = 1;
+        static constexpr size_t HeaderSize = 2;
+
+        static uint64_t Pack(uint32_t low, uint32_t high)
+        {
+            return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+        }
+
+        static uint32_t Low(uint64_t value)
+        {
+            return static_cast<uint32_t>(value);
+        }
+
+        static uint32_t High(uint64_t value)
+        {
+            return static_cast<uint32_t>(value >> 32);
+        }
+
+        // A run of a row of a tile, which starts where the previous run of the row ends
+        struct Run
+        {
+            uint32_t Right = 0;
+            uint64_t Pixel = 0;
+        };
+
+        struct Tile
+        {
+            TileKind Kind = TileKind::Solid;
+
+            // Solid tiles
+            uint64_t Pixel = 0;
+
+            // Run length tiles, the runs of row y are [RowRuns[y], RowRuns[y + 1])
+            std::vector<uint32_t> RowRuns;
+            std::vector<Run> Runs;
+
+            // Raw tiles, row by row
+            std::vector<uint64_t> Pixels;
+        };
+
+        // The solid transparent black tile every frame starts out with
+        static const std::shared_ptr<const Tile>& EmptyTile()
+        {
+            static const std::shared_ptr<const Tile> tile = std::make_shared<const Tile>();
+            return tile;
+        }
+
+        // Reads the tile starting at data[offset] and moves offset past it. Everything ForEachRun relies on is checked, so
+        // data that didn't come from Serialize is rejected rather than read out of bounds.
+        static bool DeserializeTile(Tile& tile, std::span<const uint64_t> data, size_t& offset, uint32_t width, uint32_t height)
+        {
+            const uint64_t header = data[offset++];
+            const size_t remaining = data.size() - offset;
+
+            switch (static_cast<TileKind>(Low(header)))
+            {
+            case TileKind::Solid:
+                if (High(header) != 0 || remaining < 1)
+                {
+                    return false;
+                }
+
+                tile.Pixel = data[offset++];
+                return true;
+
+            case TileKind::RunLength: {
+                const size_t runCount = High(header);
+                const size_t rowRunWords = (static_cast<size_t>(height) + 2) / 2;
+                if (remaining < rowRunWords || (remaining - rowRunWords) / 2 < runCount)
+                {
+                    return false;
+                }
+
+                tile.Kind = TileKind::RunLength;
+                tile.RowRuns.resize(height + 1);
+                for (uint32_t row = 0; row <= height; row++)
+                {
+                    const uint64_t packed = data[offset + row / 2];
+                    tile.RowRuns[row] = row % 2 == 0 ? Low(packed) : High(packed);
+                }
+                offset += rowRunWords;
+
+                tile.Runs.resize(runCount);
+                for (auto& run : tile.Runs)
+                {
+                    if (data[offset] > width)
+                    {
+                        return false;
+                    }
+
+                    run.Right = static_cast<uint32_t>(data[offset]);
+                    run.Pixel = data[offset + 1];
+                    offset += 2;
+                }
+
+                // Every row has at least one run, the runs of a row move right and the last one ends at the tile's edge
+                if (tile.RowRuns[0] != 0 || tile.RowRuns[height] != runCount ||
+                    std::adjacent_find(tile.RowRuns.begin(), tile.RowRuns.end(), std::greater_equal<uint32_t>()) != tile.RowRuns.end())
+                {
+                    return false;
+                }
+
+                for (uint32_t row = 0; row < height; row++)
+                {
+                    if (tile.Runs[tile.RowRuns[row]].Right == 0 || tile.Runs[tile.RowRuns[row + 1] - 1].Right != width)
+                    {
+                        return false;
+                    }
+
+                    for (uint32_t run = tile.RowRuns[row] + 1; run < tile.RowRuns[row + 1]; run++)
+                    {
+                        if (tile.Runs[run].Right <= tile.Runs[run - 1].Right)
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                return true;
+            }
+
+            case TileKind::Raw: {
+                const size_t pixelCount = static_cast<size_t>(width) * height;
+                if (High(header) != 0 || remaining < pixelCount)
+                {
+                    return false;
+                }
+
+                tile.Kind = TileKind::Raw;
+                tile.Pixels.assign(data.begin() + offset, data.begin() + offset + pixelCount);
+                offset += pixelCount;
+                return true;
+            }
+            }
+
+            return false;
+        }
+
+        // Tries the run length encoding first and gives up on it as soon as it is no smaller than the raw pixels
+        static void EncodeTile(Tile& tile, const uint64_t* pixels, size_t rowPitch, uint32_t width, uint32_t height)
+        {
+            tile = Tile{};
+
+            const size_t rawSize = static_cast<size_t>(width) * height * sizeof(uint64_t);
+            const size_t maxRuns = (rawSize - (height + 1) * sizeof(uint32_t)) / sizeof(Run);
+
+            tile.RowRuns.reserve(height + 1);
+            bool runLength = true;
+            for (uint32_t y = 0; y < height && runLength; y++)
+            {
+                const uint64_t* row = pixels + y * rowPitch;
+                tile.RowRuns.push_back(static_cast<uint32_t>(tile.Runs.size()));
+
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    if (x != 0 && row[x] == tile.Runs.back().Pixel)
+                    {
+                        tile.Runs.back().Right = x + 1;
+                        continue;
+                    }
+
+                    if (tile.Runs.size() == maxRuns)
+                    {
+                        runLength = false;
+                        break;
+                    }
+
+                    tile.Runs.push_back({x + 1, row[x]});
+                }
+            }
+
+            if (!runLength)
+            {
+                tile = Tile{};
+                tile.Kind = TileKind::Raw;
+                tile.Pixels.resize(static_cast<size_t>(width) * height);
+                for (uint32_t y = 0; y < height; y++)
+                {
+                    std::copy(pixels + y * rowPitch, pixels + y * rowPitch + width, tile.Pixels.data() + static_cast<size_t>(y) * width);
+                }
+
+                return;
+            }
+
+            const bool solid = tile.Runs.size() == height && std::all_of(tile.Runs.begin(), tile.Runs.end(), [&](const Run& run) {
+                return run.Pixel == tile.Runs[0].Pixel;
+            });
+
+            if (solid)
+            {
+                const uint64_t pixel = tile.Runs[0].Pixel;
+                tile = Tile{};
+                tile.Pixel = pixel;
+                return;
+            }
+
+            tile.Kind = TileKind::RunLength;
+            tile.RowRuns.push_back(static_cast<uint32_t>(tile.Runs.size()));
+            tile.Runs.shrink_to_fit();
+        }
+
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_tilesAcross;
+        uint32_t m_tilesDown;
+        std::vector<std::shared_ptr<const Tile>> m_tiles;
+    };
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries
@@ -0,0 +1,288 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+//
+// The coefficients used to carry color over a display wire.
+//
+// The decode half (dequantization, YCbCr matrices, transfer functions and primaries) matches the Tanager's compute
+// shaders, which the Tanager's CPU decoder also uses. The encode half is the forward transform a source applies, the exact
+// inverse of each decode step except for quantization, which uses the standard code ranges. Running a value through
+// both halves gives what a capture through the Tanager would see, so that predictions can account for it.
+//
+namespace winrt::MicrosoftDisplayCaptureTools::Libraries::WireFormat {
+
+    // The YCbCr to R'G'B' conversion matrix, None for RGB data.
+    enum class YcbcrMatrix
+    {
+        None,
+        Bt601,
+        Bt709,
+        Bt2020,
+    };
+
+    // The transfer function used to encode the incoming data.
+    enum class TransferFunction
+    {
+        Bt709,
+        Smpte2084,
+        OpRgb,
+    };
+
+    // The primaries of the incoming data, the output is always converted to BT.709/sRGB primaries (scRGB).
+    enum class ColorPrimaries
+    {
+        Bt709,
+        Smpte170M,
+        Bt2020,
+        OpRgb,
+        DciP3,
+    };
+
+    // The dequantization parameters for each channel, this matches the layout of the constant buffer used by the
+    // Dequantizer compute shader.
+    //
+    // Peak = 2^N - 1 (where N is the bit depth)
+    // Levels = how many levels has the output been quantized to (Generally 219*2^(N-8))
+    // Min = what is the minimum value that the output has been quantized to (generally 16*2^(N-8))
+    struct DequantizerConstants
+    {
+        uint32_t PeakForBitDepth;
+        uint32_t A_min, A_levels;
+        uint32_t B_min, B_levels;
+        uint32_t C_min, C_levels;
+        uint32_t pad; // included because CS constant buffers must be 16-byte aligned
+    };
+
+    constexpr DequantizerConstants GetDequantizerConstants(uint32_t bitDepth, bool limitedRange, bool isYcbcr)
+    {
+        DequantizerConstants constants{};
+        constants.PeakForBitDepth = (1u << bitDepth) - 1;
+
+        if (!limitedRange)
+        {
+            constants.A_min = 0;
+            constants.A_levels = constants.PeakForBitDepth;
+            constants.B_min = 0;
+            constants.B_levels = constants.PeakForBitDepth;
+            constants.C_min = 0;
+            constants.C_levels = constants.PeakForBitDepth;
+            return constants;
+        }
+
+        const uint32_t bitDepthModifier = 1u << (bitDepth - 8);
+        constants.A_min = 16 * bitDepthModifier;
+        constants.A_levels = (235 - 16) * bitDepthModifier;
+        constants.B_min = 16 * bitDepthModifier;
+        constants.C_min = 16 * bitDepthModifier;
+
+        if (isYcbcr)
+        {
+            constants.B_levels = (240 - 16) * bitDepthModifier;
+            constants.C_levels = (240 - 16) * bitDepthModifier;
+        }
+        else
+        {
+            constants.B_levels = (235 - 16) * bitDepthModifier;
+            constants.C_levels = (235 - 16) * bitDepthModifier;
+        }
+
+        return constants;
+    }
+
+    using Matrix = std::array<std::array<float, 3>, 3>;
+
+    constexpr Matrix GetYcbcrMatrix(YcbcrMatrix matrix)
+    {
+        switch (matrix)
+        {
+        case YcbcrMatrix::Bt601:
+            return {{{1.0000f, 0.00000f, 1.40199f}, {1.0000f, -0.34411f, -0.71410f}, {1.0000f, 1.77198f, -0.00013f}}};
+        case YcbcrMatrix::Bt709:
+            return {{{1.0000f, 0.0000f, 1.5748f}, {1.0000f, -0.1873f, -0.4681f}, {1.0000f, 1.8556f, 0.0000f}}};
+        case YcbcrMatrix::Bt2020:
+            return {{{1.0f, -0.000043128f, 1.474587959f},
+                     {1.0f, -0.164535603f, -0.57133834f},
+                     {1.0f, 1.881390696f, -0.000115718f}}};
+        default:
+            return {{{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}};
+        }
+    }
+
+    // Converts linear values with the given primaries to BT.709 primaries, these match the Color_* shaders.
+    constexpr Matrix GetPrimariesMatrix(ColorPrimaries primaries)
+    {
+        switch (primaries)
+        {
+        case ColorPrimaries::Smpte170M:
+            return {{{0.939555291f, 0.050172214f, 0.010272495f},
+                     {0.017775713f, 0.965792910f, 0.016431377f},
+                     {-0.00162227f, -0.004370698f, 1.005992968f}}};
+        case ColorPrimaries::Bt2020:
+            return {{{1.660362656f, -0.587539997f, -0.072822659f},
+                     {-0.124563549f, 1.132911375f, -0.008347826f},
+                     {-0.018156606f, -0.100601732f, 1.118758338f}}};
+        case ColorPrimaries::OpRgb:
+            return {{{1.39828f, -0.39828f, 0.00000f}, {0.00000f, 1.00000f, 0.00000f}, {0.00000f, -0.04294f, 1.04294f}}};
+        case ColorPrimaries::DciP3:
+            return {{{0.72050f, 0.27950f, 0.00000f}, {-0.02474f, 1.02474f, 0.00000f}, {-0.01156f, 0.79733f, 0.21423f}}};
+        default:
+            return {{{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}};
+        }
+    }
+
+    // The inverse of a matrix, worked out in double precision. Used to find the forward transform a source applies from
+    // the matrix the sink decodes with.
+    inline Matrix InvertMatrix(const Matrix& m)
+    {
+        const auto at = [&](size_t row, size_t column) { return static_cast<double>(m[row][column]); };
+
+        const double cofactor00 = at(1, 1) * at(2, 2) - at(1, 2) * at(2, 1);
+        const double cofactor01 = at(1, 2) * at(2, 0) - at(1, 0) * at(2, 2);
+        const double cofactor02 = at(1, 0) * at(2, 1) - at(1, 1) * at(2, 0);
+        const double determinant = at(0, 0) * cofactor00 + at(0, 1) * cofactor01 + at(0, 2) * cofactor02;
+
+        const double adjugate[3][3] = {
+            {cofactor00, at(0, 2) * at(2, 1) - at(0, 1) * at(2, 2), at(0, 1) * at(1, 2) - at(0, 2) * at(1, 1)},
+            {cofactor01, at(0, 0) * at(2, 2) - at(0, 2) * at(2, 0), at(0, 2) * at(1, 0) - at(0, 0) * at(1, 2)},
+            {cofactor02, at(0, 1) * at(2, 0) - at(0, 0) * at(2, 1), at(0, 0) * at(1, 1) - at(0, 1) * at(1, 0)}};
+
+        Matrix inverse{};
+        for (size_t row = 0; row < 3; row++)
+        {
+            for (size_t column = 0; column < 3; column++)
+            {
+                inverse[row][column] = static_cast<float>(adjugate[row][column] / determinant);
+            }
+        }
+
+        return inverse;
+    }
+
+    inline float LinearizeBt709(float value)
+    {
+        return value < 0.081f ? value / 4.5f : std::pow((value + 0.099f) / 1.099f, 1.0f / 0.45f);
+    }
+
+    inline float LinearizeOpRgb(float value)
+    {
+        return std::pow(value, 2.19921875f);
+    }
+
+    inline float LinearizeSmpte2084(float value)
+    {
+        constexpr float m1 = 0.1593017578f;
+        constexpr float m2 = 78.84375f;
+        constexpr float c1 = 0.8359375f;
+        constexpr float c2 = 18.8515625f;
+        constexpr float c3 = 18.6875f;
+
+        const float e = std::pow(value, 1.0f / m2);
+        return std::pow((std::max)(e - c1, 0.0f) / (c2 - c3 * e), 1.0f / m1);
+    }
+
+    inline float Linearize(TransferFunction transfer, float value)
+    {
+        switch (transfer)
+        {
+        case TransferFunction::Bt709:
+            return LinearizeBt709(value);
+        case TransferFunction::OpRgb:
+            return LinearizeOpRgb(value);
+        case TransferFunction::Smpte2084:
+            return LinearizeSmpte2084(value);
+        default:
+            return value;
+        }
+    }
+
+    // The inverse of each Linearize function, for linear values in [0, 1]
+    inline float EncodeBt709(float value)
+    {
+        return value < 0.081f / 4.5f ? value * 4.5f : 1.099f * std::pow(value, 0.45f) - 0.099f;
+    }
+
+    inline float EncodeOpRgb(float value)
+    {
+        return std::pow(value, 1.0f / 2.19921875f);
+    }
+
+    inline float EncodeSmpte2084(float value)
+    {
+        constexpr float m1 = 0.1593017578f;
+        constexpr float m2 = 78.84375f;
+        constexpr float c1 = 0.8359375f;
+        constexpr float c2 = 18.8515625f;
+        constexpr float c3 = 18.6875f;
+
+        const float y = std::pow(value, m1);
+        return std::pow((c1 + c2 * y) / (1.0f + c3 * y), m2);
+    }
+
+    inline float Encode(TransferFunction transfer, float value)
+    {
+        switch (transfer)
+        {
+        case TransferFunction::Bt709:
+            return EncodeBt709(value);
+        case TransferFunction::OpRgb:
+            return EncodeOpRgb(value);
+        case TransferFunction::Smpte2084:
+            return EncodeSmpte2084(value);
+        default:
+            return value;
+        }
+    }
+
+    // The transfer functions work on linear values normalized to [0, 1]. This is the scRGB value of that 1.0, reference
+    // white for the SDR curves and the 10000 nit peak for PQ, the same as GetLinearScale in RenderingUtils.
+    inline float GetLinearScale(TransferFunction transfer)
+    {
+        return transfer == TransferFunction::Smpte2084 ? 10000.0f / 80.0f : 1.0f;
+    }
+
+    // Matches the Dequantizer shader, scaling a code value to full range and normalizing it to 0-1.
+    inline float Dequantize(uint32_t code, uint32_t min, uint32_t levels, uint32_t peakForBitDepth)
+    {
+        const float peak = static_cast<float>(peakForBitDepth);
+        const float value = std::clamp(static_cast<float>(code), static_cast<float>(min), peak);
+        const float scaled = std::nearbyint((value - static_cast<float>(min)) * peak / static_cast<float>(levels));
+        return std::clamp(scaled, 0.0f, peak) / peak;
+    }
+
+    // The code range a source quantizes one channel to
+    struct QuantizerRange
+    {
+        float Min;
+        float Levels;
+        float Peak;
+    };
+
+    // Full range uses every code, limited range puts black at 16 and white at 235 (240 for chroma) scaled to the bit depth
+    inline QuantizerRange GetQuantizerRange(uint32_t bitDepth, bool limitedRange, bool chroma)
+    {
+        const float peak = static_cast<float>((1u << bitDepth) - 1);
+        if (!limitedRange)
+        {
+            return {0.0f, peak, peak};
+        }
+
+        const float bitDepthModifier = static_cast<float>(1u << (bitDepth - 8));
+        return {16.0f * bitDepthModifier, (chroma ? 224.0f : 219.0f) * bitDepthModifier, peak};
+    }
+
+    // The code a source sends for a value in [0, 1]
+    inline uint32_t Quantize(float value, const QuantizerRange& range)
+    {
+        const float code = std::nearbyint(range.Min + value * range.Levels);
+        if (!(code > 0.0f))
+        {
+            return 0;
+        }
+
+        return static_cast<uint32_t>((std::min)(code, range.Peak));
+    }
+
+} // namespace winrt::MicrosoftDisplayCaptureTools::Libraries::WireFormat
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "BitmapBufferPoolTests.h"
+
+#include "..\BasicDisplayConfiguration\BitmapBufferPool.h"
+
+using namespace winrt::BasicDisplayConfiguration::Rendering;
+
+namespace
+{
+    bool IsAligned(const BitmapBuffer& buffer)
+    {
+        return reinterpret_cast<uintptr_t>(buffer.Data()) % BitmapBufferPool::Alignment == 0;
+    }
+
+    // Buffers are compared by address, which is how a reused one is recognized
+    uintptr_t Address(const BitmapBuffer& buffer)
+    {
+        return reinterpret_cast<uintptr_t>(buffer.Data());
+    }
+} // namespace
+
+void BitmapBufferPoolTests::BuffersAreAligned()
+{
+    BitmapBufferPool pool;
+
+    // Sizes of bitmaps of odd widths and heights, whose pitch is a multiple of 16 but not of the alignment
+    const size_t sizes[] = {1, 3, 16, 48, 64, 65, 272 * 3, 4096, 4100 * 7};
+    for (size_t size : sizes)
+    {
+        auto buffer = pool.Allocate(size);
+        VERIFY_IS_NOT_NULL(buffer.Data());
+        VERIFY_ARE_EQUAL(size, buffer.Size());
+        VERIFY_IS_TRUE(IsAligned(buffer));
+
+        // The whole buffer must be usable
+        std::memset(buffer.Data(), 0xCD, buffer.Size());
+    }
+
+    // Every size has been released once, so these come back from the pool
+    for (size_t size : sizes)
+    {
+        auto buffer = pool.Allocate(size);
+        VERIFY_IS_TRUE(IsAligned(buffer));
+    }
+
+    auto empty = pool.Allocate(0);
+    VERIFY_IS_NOT_NULL(empty.Data());
+    VERIFY_ARE_EQUAL(size_t{1}, empty.Size());
+    VERIFY_IS_TRUE(IsAligned(empty));
+}
+
+void BitmapBufferPoolTests::ReleasedBuffersAreReused()
+{
+    BitmapBufferPool pool;
+
+    auto first = pool.Allocate(1024);
+    const uintptr_t firstAddress = Address(first);
+    first.Reset();
+    VERIFY_IS_NULL(first.Data());
+    VERIFY_ARE_EQUAL(size_t{1024}, pool.PooledBytes());
+
+    // A different size doesn't take the pooled buffer
+    auto other = pool.Allocate(2048);
+    VERIFY_ARE_NOT_EQUAL(firstAddress, Address(other));
+    VERIFY_ARE_EQUAL(size_t{1024}, pool.PooledBytes());
+
+    auto second = pool.Allocate(1024);
+    VERIFY_ARE_EQUAL(firstAddress, Address(second));
+    VERIFY_ARE_EQUAL(size_t{0}, pool.PooledBytes());
+
+    // Buffers go back when they are destroyed as well
+    {
+        auto scoped = pool.Allocate(4096);
+    }
+    VERIFY_ARE_EQUAL(size_t{4096}, pool.PooledBytes());
+}
+
+void BitmapBufferPoolTests::BuffersReturnUnderAllocatedSize()
+{
+    BitmapBufferPool pool;
+
+    // Whatever is done with the memory, the buffer keeps the size it was allocated with. A bitmap that changed its pitch
+    // or height after allocating would otherwise return its buffer under the wrong size.
+    auto buffer = pool.Allocate(1000);
+    const uintptr_t address = Address(buffer);
+    BitmapBuffer moved = std::move(buffer);
+    VERIFY_IS_NULL(buffer.Data());
+    VERIFY_ARE_EQUAL(size_t{0}, buffer.Size());
+    VERIFY_ARE_EQUAL(size_t{1000}, moved.Size());
+
+    // The emptied handle has nothing to give back
+    buffer.Reset();
+    VERIFY_ARE_EQUAL(size_t{0}, pool.PooledBytes());
+
+    moved.Reset();
+    VERIFY_ARE_EQUAL(size_t{1000}, pool.PooledBytes());
+
+    // Neighbouring sizes don't get the buffer, the size it was allocated with does
+    auto smaller = pool.Allocate(999);
+    auto larger = pool.Allocate(1001);
+    VERIFY_ARE_NOT_EQUAL(address, Address(smaller));
+    VERIFY_ARE_NOT_EQUAL(address, Address(larger));
+
+    auto same = pool.Allocate(1000);
+    VERIFY_ARE_EQUAL(address, Address(same));
+
+    // Assigning over a buffer gives the old one back first
+    same = pool.Allocate(500);
+    VERIFY_ARE_EQUAL(size_t{1000}, pool.PooledBytes());
+}
+
+void BitmapBufferPoolTests::PoolKeepsToBudget()
+{
+    BitmapBufferPool pool(3000);
+
+    auto first = pool.Allocate(1000);
+    auto second = pool.Allocate(1000);
+    auto third = pool.Allocate(1000);
+    auto fourth = pool.Allocate(1000);
+
+    first.Reset();
+    second.Reset();
+    third.Reset();
+    VERIFY_ARE_EQUAL(size_t{3000}, pool.PooledBytes());
+
+    // This one doesn't fit in the budget and goes back to the heap
+    fourth.Reset();
+    VERIFY_ARE_EQUAL(size_t{3000}, pool.PooledBytes());
+
+    // Nor does anything larger than the whole budget
+    BitmapBufferPool small(100);
+    small.Allocate(101).Reset();
+    VERIFY_ARE_EQUAL(size_t{0}, small.PooledBytes());
+    small.Allocate(100).Reset();
+    VERIFY_ARE_EQUAL(size_t{100}, small.PooledBytes());
+}
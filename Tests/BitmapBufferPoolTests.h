@@ -0,0 +1,29 @@
+#pragma once
+
+/// <summary>
+/// Validates the pool that bitmap pixels are allocated from. These only use the CPU, so they can be run in
+/// prediction-only mode without a capture board attached.
+/// </summary>
+class BitmapBufferPoolTests
+{
+    BEGIN_TEST_CLASS(BitmapBufferPoolTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(BuffersAreAligned)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that new and reused buffers of sizes that are and aren't multiples of the alignment all start on an aligned address, and that an empty request still gets a buffer.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(ReleasedBuffersAreReused)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a released buffer is handed out again for the same size and not for a different one.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(BuffersReturnUnderAllocatedSize)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a buffer goes back to the pool under the size it was allocated with, and that moving a buffer hands it back only once.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(PoolKeepsToBudget)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that the pool keeps released buffers only up to its budget.")
+    END_TEST_METHOD()
+};
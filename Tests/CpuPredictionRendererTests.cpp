@@ -0,0 +1,392 @@
+#include "pch.h"
+#include "CpuPredictionRendererTests.h"
+
+#include <tuple>
+
+#include "..\BasicDisplayConfiguration\CpuPredictionRenderer.h"
+
+using namespace winrt::BasicDisplayConfiguration::Rendering;
+namespace HalfFloat = winrt::MicrosoftDisplayCaptureTools::Libraries::HalfFloat;
+using winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool;
+using winrt::MicrosoftDisplayCaptureTools::Libraries::TiledFrame;
+
+namespace
+{
+    // Output pixels are fp16, which holds values up to 1 to within about 1e-3
+    constexpr double Tolerance = 2e-3;
+
+    struct Color
+    {
+        double R, G, B;
+    };
+
+    // A different value in every channel of every texel, all of which fp16 holds exactly
+    Color TexelColor(uint32_t x, uint32_t y)
+    {
+        return {((x * 7 + y * 3) % 16) / 16.0, ((x * 5 + y * 11) % 16) / 16.0, ((x + y * 13) % 16) / 16.0};
+    }
+
+    std::shared_ptr<PlaneSurface> MakeSurface(uint32_t width, uint32_t height)
+    {
+        auto surface = std::make_shared<PlaneSurface>(PlanePixelFormat::R16G16B16A16Float, width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const Color color = TexelColor(x, y);
+                const uint64_t pixel = HalfFloat::PackRgba(
+                    static_cast<float>(color.R), static_cast<float>(color.G), static_cast<float>(color.B), 1.0f);
+                std::memcpy(surface->Row(y) + static_cast<size_t>(x) * sizeof(pixel), &pixel, sizeof(pixel));
+            }
+        }
+
+        return surface;
+    }
+
+    // A frame of width x height with a single opaque plane stretched over all of it
+    CpuFrame StretchedFrame(uint32_t width, uint32_t height, std::shared_ptr<const PlaneSurface> surface, PlaneInterpolation interpolation)
+    {
+        CpuPlane plane;
+        plane.Surface = surface;
+        plane.DestinationRect = {0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)};
+        plane.SourceRect = {0.0f, 0.0f, static_cast<float>(surface->Width()), static_cast<float>(surface->Height())};
+        plane.Interpolation = interpolation;
+
+        CpuFrame frame;
+        frame.Width = width;
+        frame.Height = height;
+        frame.Planes.push_back(std::move(plane));
+        return frame;
+    }
+
+    std::vector<uint64_t> Render(const CpuFrame& frame)
+    {
+        std::vector<uint64_t> pixels(static_cast<size_t>(frame.Width) * frame.Height);
+        CpuPredictionRenderer(frame).Render(pixels.data(), nullptr, ThreadPool::Default());
+        return pixels;
+    }
+
+    double CatmullRom(double distance)
+    {
+        distance = std::abs(distance);
+        if (distance < 1.0)
+        {
+            return (1.5 * distance - 2.5) * distance * distance + 1.0;
+        }
+
+        return distance < 2.0 ? ((-0.5 * distance + 2.5) * distance - 4.0) * distance + 2.0 : 0.0;
+    }
+
+    // The texels pixel i of a row of targetSize pixels, stretched from sourceSize texels, is filtered from and their
+    // weights. Texels past the edge repeat the edge texel.
+    std::vector<std::pair<uint32_t, double>> Taps(uint32_t i, uint32_t targetSize, uint32_t sourceSize, PlaneInterpolation interpolation)
+    {
+        const double position = (i + 0.5) * sourceSize / targetSize - 0.5;
+        const double floorPosition = std::floor(position);
+        const double fraction = position - floorPosition;
+        const auto texel = [&](double offset) {
+            return static_cast<uint32_t>(std::clamp(floorPosition + offset, 0.0, static_cast<double>(sourceSize - 1)));
+        };
+
+        if (interpolation == PlaneInterpolation::Linear)
+        {
+            return {{texel(0), 1.0 - fraction}, {texel(1), fraction}};
+        }
+
+        std::vector<std::pair<uint32_t, double>> taps;
+        for (int offset = -1; offset <= 2; offset++)
+        {
+            taps.push_back({texel(offset), CatmullRom(offset - fraction)});
+        }
+
+        return taps;
+    }
+
+    // Filters the texels directly, the rows and columns of the plane at once
+    Color ReferencePixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const PlaneSurface& surface, PlaneInterpolation interpolation)
+    {
+        Color sum{0.0, 0.0, 0.0};
+        for (const auto& [texelY, weightY] : Taps(y, height, surface.Height(), interpolation))
+        {
+            for (const auto& [texelX, weightX] : Taps(x, width, surface.Width(), interpolation))
+            {
+                const Color texel = TexelColor(texelX, texelY);
+                sum.R += texel.R * weightX * weightY;
+                sum.G += texel.G * weightX * weightY;
+                sum.B += texel.B * weightX * weightY;
+            }
+        }
+
+        return sum;
+    }
+
+    // A plane of one alpha whose color changes from texel to texel, stored the way alphaMode says
+    std::shared_ptr<PlaneSurface> MakeOverlay(PlanePixelFormat format, PlaneAlphaMode alphaMode, float alpha, uint32_t width, uint32_t height)
+    {
+        auto surface = std::make_shared<PlaneSurface>(format, width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const Color color = TexelColor(x + 3, y + 5);
+                const float scale = alphaMode == PlaneAlphaMode::Premultiplied ? alpha : 1.0f;
+                const float channels[4] = {
+                    static_cast<float>(color.R) * scale, static_cast<float>(color.G) * scale, static_cast<float>(color.B) * scale, alpha};
+
+                uint8_t* pixel = surface->Row(y) + static_cast<size_t>(x) * BytesPerPixel(format);
+                for (uint32_t channel = 0; channel < 4; channel++)
+                {
+                    if (format == PlanePixelFormat::R8G8B8A8UIntNormalized)
+                    {
+                        pixel[channel] = static_cast<uint8_t>(std::lround(channels[channel] * 255.0f));
+                    }
+                    else
+                    {
+                        const uint16_t half = HalfFloat::FromFloat(channels[channel]);
+                        std::memcpy(pixel + channel * sizeof(half), &half, sizeof(half));
+                    }
+                }
+            }
+        }
+
+        return surface;
+    }
+
+    // The texel as stored, converted to premultiplied alpha
+    std::array<double, 4> PremultipliedTexel(const PlaneSurface& surface, PlaneAlphaMode alphaMode, uint32_t x, uint32_t y)
+    {
+        const uint8_t* pixel = surface.Row(y) + static_cast<size_t>(x) * BytesPerPixel(surface.Format());
+
+        std::array<double, 4> texel;
+        for (uint32_t channel = 0; channel < 4; channel++)
+        {
+            if (surface.Format() == PlanePixelFormat::R8G8B8A8UIntNormalized)
+            {
+                texel[channel] = pixel[channel] / 255.0;
+            }
+            else
+            {
+                uint16_t half;
+                std::memcpy(&half, pixel + channel * sizeof(half), sizeof(half));
+                texel[channel] = HalfFloat::ToFloat(half);
+            }
+        }
+
+        if (alphaMode == PlaneAlphaMode::Straight || texel[3] == 0.0)
+        {
+            for (uint32_t channel = 0; channel < 3; channel++)
+            {
+                texel[channel] *= texel[3];
+            }
+        }
+
+        return texel;
+    }
+
+    // The largest difference of any channel from reference(x, y)
+    template <typename Reference>
+    double LargestError(const std::vector<uint64_t>& pixels, uint32_t width, uint32_t height, Reference&& reference)
+    {
+        double largestError = 0.0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint64_t pixel = pixels[static_cast<size_t>(y) * width + x];
+                const Color expected = reference(x, y);
+                for (const auto& [channel, value] : {std::pair{0, expected.R}, std::pair{1, expected.G}, std::pair{2, expected.B}})
+                {
+                    const double rendered = HalfFloat::ToFloat(static_cast<uint16_t>(pixel >> (channel * 16)));
+                    largestError = (std::max)(largestError, std::abs(rendered - value));
+                }
+            }
+        }
+
+        return largestError;
+    }
+} // namespace
+
+void CpuPredictionRendererTests::IncrementalRenderMatchesFullRender()
+{
+    constexpr uint32_t width = 150, height = 100;
+
+    // Renders previous, then current on top of it, and checks that gives the same pixels as rendering current in full
+    const auto verifyIncremental = [&](const CpuFrame& previous, const CpuFrame& current) {
+        const auto changed = ChangedRegions(previous, current);
+        VERIFY_IS_TRUE(changed.has_value());
+        if (!changed)
+        {
+            return;
+        }
+
+        const TiledFrame previousTiles = CpuPredictionRenderer(previous).RenderTiled(ThreadPool::Default());
+        const TiledFrame incremental = CpuPredictionRenderer(current).RenderTiled(previousTiles, *changed, ThreadPool::Default());
+        const TiledFrame full = CpuPredictionRenderer(current).RenderTiled(ThreadPool::Default());
+
+        std::vector<uint64_t> incrementalPixels(static_cast<size_t>(width) * height), fullPixels(incrementalPixels.size());
+        incremental.CopyRows(0, height, incrementalPixels.data());
+        full.CopyRows(0, height, fullPixels.data());
+        VERIFY_IS_TRUE(incrementalPixels == fullPixels);
+    };
+
+    // Changes the texels of a rectangle of the frame's first plane
+    const auto withChangedTexels = [](const CpuFrame& frame, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom) {
+        auto surface = std::make_shared<PlaneSurface>(*frame.Planes[0].Surface);
+        const uint64_t changedPixel = HalfFloat::PackRgba(1.0f, 0.0f, 0.5f, 1.0f);
+        for (uint32_t y = top; y < bottom; y++)
+        {
+            for (uint32_t x = left; x < right; x++)
+            {
+                std::memcpy(surface->Row(y) + static_cast<size_t>(x) * sizeof(changedPixel), &changedPixel, sizeof(changedPixel));
+            }
+        }
+
+        CpuFrame changed = frame;
+        changed.Planes[0].Surface = surface;
+        return changed;
+    };
+
+    // Texels changed in the middle of an unscaled plane, and of a plane scaled up with a wide filter. Scaled up, the
+    // changed texels start just past the first tile and only the filter reaches back into it.
+    for (const auto& [surfaceWidth, surfaceHeight, interpolation] :
+         {std::tuple{width, height, PlaneInterpolation::Linear}, std::tuple{width / 2, height / 2, PlaneInterpolation::Lanczos3}})
+    {
+        const auto frame = StretchedFrame(width, height, MakeSurface(surfaceWidth, surfaceHeight), interpolation);
+        verifyIncremental(frame, withChangedTexels(frame, 34, 34, 41, 40));
+    }
+
+    // A partially transparent plane moved across a tile boundary
+    auto frame = StretchedFrame(width, height, MakeSurface(width, height), PlaneInterpolation::Linear);
+    CpuPlane overlay;
+    overlay.Surface = MakeOverlay(PlanePixelFormat::R16G16B16A16Float, PlaneAlphaMode::Straight, 0.4f, 20, 20);
+    overlay.AlphaMode = PlaneAlphaMode::Straight;
+    overlay.DestinationRect = {50.0f, 40.0f, 70.0f, 60.0f};
+    overlay.SourceRect = {0.0f, 0.0f, 20.0f, 20.0f};
+    frame.Planes.push_back(overlay);
+
+    auto moved = frame;
+    moved.Planes[1].DestinationRect = {57.0f, 43.0f, 77.0f, 63.0f};
+    verifyIncremental(frame, moved);
+}
+
+void CpuPredictionRendererTests::PlaneBlendMatchesReference()
+{
+    // Neither size is a whole number of tiles, and the overlay hangs off the right and bottom of the frame
+    constexpr uint32_t width = 100, height = 70;
+    constexpr uint32_t overlayLeft = 80, overlayTop = 50, overlaySize = 40;
+    const auto base = MakeSurface(width, height);
+
+    for (auto format : {PlanePixelFormat::R8G8B8A8UIntNormalized, PlanePixelFormat::R16G16B16A16Float})
+    {
+        for (auto alphaMode : {PlaneAlphaMode::Straight, PlaneAlphaMode::Premultiplied})
+        {
+            for (float alpha : {0.0f, 0.4f, 1.0f})
+            {
+                const auto overlaySurface = MakeOverlay(format, alphaMode, alpha, overlaySize, overlaySize);
+
+                auto frame = StretchedFrame(width, height, base, PlaneInterpolation::Linear);
+                CpuPlane overlay;
+                overlay.Surface = overlaySurface;
+                overlay.AlphaMode = alphaMode;
+                overlay.DestinationRect = {
+                    static_cast<float>(overlayLeft),
+                    static_cast<float>(overlayTop),
+                    static_cast<float>(overlayLeft + overlaySize),
+                    static_cast<float>(overlayTop + overlaySize)};
+                overlay.SourceRect = {0.0f, 0.0f, static_cast<float>(overlaySize), static_cast<float>(overlaySize)};
+                frame.Planes.push_back(std::move(overlay));
+
+                // Source over, onto the opaque base plane
+                const auto reference = [&](uint32_t x, uint32_t y) {
+                    Color color = TexelColor(x, y);
+                    if (x < overlayLeft || y < overlayTop)
+                    {
+                        return color;
+                    }
+
+                    const auto texel = PremultipliedTexel(*overlaySurface, alphaMode, x - overlayLeft, y - overlayTop);
+                    color.R = texel[0] + color.R * (1.0 - texel[3]);
+                    color.G = texel[1] + color.G * (1.0 - texel[3]);
+                    color.B = texel[2] + color.B * (1.0 - texel[3]);
+                    return color;
+                };
+
+                VERIFY_IS_LESS_THAN(LargestError(Render(frame), width, height, reference), Tolerance);
+
+                const TiledFrame tiled = CpuPredictionRenderer(frame).RenderTiled(ThreadPool::Default());
+                std::vector<uint64_t> tiledPixels(static_cast<size_t>(width) * height);
+                tiled.CopyRows(0, height, tiledPixels.data());
+                VERIFY_IS_LESS_THAN(LargestError(tiledPixels, width, height, reference), Tolerance);
+            }
+        }
+    }
+}
+
+void CpuPredictionRendererTests::UnscaledPlaneMatchesTexels()
+{
+    constexpr uint32_t width = 37, height = 23;
+    const auto surface = MakeSurface(width, height);
+
+    for (auto interpolation : {PlaneInterpolation::NearestNeighbor, PlaneInterpolation::Linear, PlaneInterpolation::Cubic, PlaneInterpolation::Lanczos3})
+    {
+        const auto pixels = Render(StretchedFrame(width, height, surface, interpolation));
+        VERIFY_ARE_EQUAL(LargestError(pixels, width, height, TexelColor), 0.0);
+    }
+}
+
+void CpuPredictionRendererTests::UpscaledPlaneMatchesReference()
+{
+    constexpr uint32_t width = 74, height = 46;
+    const auto surface = MakeSurface(width / 2, height / 2);
+
+    for (auto interpolation : {PlaneInterpolation::Linear, PlaneInterpolation::Cubic})
+    {
+        const auto pixels = Render(StretchedFrame(width, height, surface, interpolation));
+        const double error = LargestError(pixels, width, height, [&](uint32_t x, uint32_t y) {
+            return ReferencePixel(x, y, width, height, *surface, interpolation);
+        });
+
+        VERIFY_IS_LESS_THAN(error, Tolerance);
+    }
+}
+
+void CpuPredictionRendererTests::DownscaledPlaneMatchesReference()
+{
+    constexpr uint32_t width = 19, height = 11;
+    const auto surface = MakeSurface(width * 2, height * 2);
+
+    const auto pixels = Render(StretchedFrame(width, height, surface, PlaneInterpolation::Linear));
+
+    // Every pixel is centered between four texels, and is their average
+    const double error = LargestError(pixels, width, height, [&](uint32_t x, uint32_t y) {
+        Color sum{0.0, 0.0, 0.0};
+        for (uint32_t texelY : {y * 2, y * 2 + 1})
+        {
+            for (uint32_t texelX : {x * 2, x * 2 + 1})
+            {
+                const Color texel = TexelColor(texelX, texelY);
+                sum.R += texel.R / 4;
+                sum.G += texel.G / 4;
+                sum.B += texel.B / 4;
+            }
+        }
+
+        return sum;
+    });
+
+    VERIFY_IS_LESS_THAN(error, Tolerance);
+}
+
+void CpuPredictionRendererTests::UnsampledPlaneDrawsNothing()
+{
+    constexpr uint32_t width = 16, height = 8;
+    const auto surface = MakeSurface(width, height);
+
+    // The source is wider than a float can say, so every column samples at infinity and has no taps
+    auto frame = StretchedFrame(width, height, surface, PlaneInterpolation::Linear);
+    frame.Planes[0].SourceRect.Left = -3.4e38f;
+    frame.Planes[0].SourceRect.Right = 3.4e38f;
+
+    const auto pixels = Render(frame);
+    VERIFY_ARE_EQUAL(LargestError(pixels, width, height, [](uint32_t, uint32_t) { return Color{0.0, 0.0, 0.0}; }), 0.0);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/// <summary>
+/// Validates the CPU prediction renderer against per-pixel reference computations. These only use the CPU, so they can
+/// be run in prediction-only mode without a capture board attached.
+/// </summary>
+class CpuPredictionRendererTests
+{
+    BEGIN_TEST_CLASS(CpuPredictionRendererTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(IncrementalRenderMatchesFullRender)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that rendering only what changed on top of the previous frame gives bit for bit the same tiles as rendering the changed frame in full, for changed texels of unscaled and scaled planes and for a plane that moved.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(PlaneBlendMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates blending a transparent, a partially transparent and an opaque plane with straight and premultiplied alpha against a per-pixel reference, with the plane partly off the frame over its last, partial tiles.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(UnscaledPlaneMatchesTexels)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a plane drawn at its own size gives back its texels exactly, for every interpolation mode.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(UpscaledPlaneMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates linear and cubic resampling of a plane scaled up 2x against the filter computed directly for each pixel.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(DownscaledPlaneMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates linear resampling of a plane scaled down 2x against the average of the texels each pixel covers.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(UnsampledPlaneDrawsNothing)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a scaled plane whose sample positions aren't numbers leaves the background as it is.")
+    END_TEST_METHOD()
+};
@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "CursorConversionTests.h"
+
+#include <random>
+
+#include "..\BasicDisplayConfiguration\CursorConversion.h"
+
+using namespace winrt::BasicDisplayConfiguration::Rendering;
+
+namespace
+{
+    constexpr uint32_t Black = 0;
+    constexpr uint32_t White = 0xFFFFFF;
+    constexpr uint32_t PaddingPixel = 0xCDCDCDCD;
+
+    // Pixels of rows of a cursor, with a few pixels of padding after each row as a bitmap's pitch can have
+    struct CursorPixels
+    {
+        CursorPixels(uint32_t width, uint32_t height, uint32_t fill = 0xFF000000) :
+            Width(width), Height(height), Stride(width + 3), Pixels(static_cast<size_t>(width + 3) * height, PaddingPixel)
+        {
+            for (uint32_t y = 0; y < height; y++)
+            {
+                std::fill_n(Pixels.data() + static_cast<size_t>(y) * Stride, width, fill);
+            }
+        }
+
+        uint32_t& At(uint32_t x, uint32_t y)
+        {
+            return Pixels[static_cast<size_t>(y) * Stride + x];
+        }
+
+        uint32_t At(uint32_t x, uint32_t y) const
+        {
+            return Pixels[static_cast<size_t>(y) * Stride + x];
+        }
+
+        uint8_t* Data()
+        {
+            return reinterpret_cast<uint8_t*>(Pixels.data());
+        }
+
+        size_t Pitch() const
+        {
+            return static_cast<size_t>(Stride) * sizeof(uint32_t);
+        }
+
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t Stride;
+        std::vector<uint32_t> Pixels;
+    };
+
+    uint8_t Alpha(uint32_t pixel)
+    {
+        return static_cast<uint8_t>(pixel >> 24);
+    }
+
+    uint32_t Color(uint32_t pixel)
+    {
+        return pixel & White;
+    }
+
+    uint32_t MakePixel(uint8_t alpha, uint32_t color)
+    {
+        return static_cast<uint32_t>(alpha) << 24 | color;
+    }
+
+    // The border conversion as it was first written, one pixel and one border window at a time
+    CursorPixels ReferenceXorBorder(const CursorPixels& input)
+    {
+        const uint32_t borderSize = (input.Width + 47) / 48;
+        CursorPixels output(input.Width + borderSize * 2, input.Height + borderSize * 2, MakePixel(0xFF, Black));
+
+        for (uint32_t cy = 0; cy < input.Height; ++cy)
+        {
+            for (uint32_t cx = 0; cx < input.Width; ++cx)
+            {
+                const uint32_t pixel = input.At(cx, cy);
+                if (Alpha(pixel) && Color(pixel) == Black)
+                {
+                    continue;
+                }
+
+                output.At(cx + borderSize, cy + borderSize) = Alpha(pixel) ? MakePixel(0, Black) : pixel;
+
+                for (uint32_t outerCy = cy; outerCy < cy + borderSize * 2 + 1; outerCy++)
+                {
+                    for (uint32_t outerCx = cx; outerCx < cx + borderSize * 2 + 1; outerCx++)
+                    {
+                        uint32_t& outer = output.At(outerCx, outerCy);
+                        if (Alpha(outer) && Color(outer) == Black)
+                        {
+                            outer = MakePixel(0, White);
+                        }
+                    }
+                }
+            }
+        }
+
+        return output;
+    }
+
+    // A cursor that is mostly transparent, with some XOR pixels and some opaque black and colored ones
+    CursorPixels MixedCursor(uint32_t width, uint32_t height, std::mt19937& random)
+    {
+        CursorPixels cursor(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint32_t kind = random() % 20;
+                const uint32_t color = random() & White;
+                if (kind == 0)
+                {
+                    cursor.At(x, y) = MakePixel(static_cast<uint8_t>(1 + random() % 255), color | 1);
+                }
+                else if (kind == 1)
+                {
+                    cursor.At(x, y) = MakePixel(0, Black);
+                }
+                else if (kind == 2)
+                {
+                    cursor.At(x, y) = MakePixel(0, color);
+                }
+            }
+        }
+
+        return cursor;
+    }
+
+    // Converts the cursor and compares every output pixel and all of the row padding with the reference
+    void VerifyXorBorder(const CursorPixels& input)
+    {
+        const CursorPixels expected = ReferenceXorBorder(input);
+
+        const uint32_t borderSize = XorBorderSize(input.Width);
+        VERIFY_ARE_EQUAL(expected.Width, input.Width + borderSize * 2);
+
+        CursorPixels converted(expected.Width, expected.Height, 0x12345678);
+        ConvertXorToBorder(
+            reinterpret_cast<const uint8_t*>(input.Pixels.data()), input.Pitch(), input.Width, input.Height, converted.Data(), converted.Pitch());
+
+        size_t wrongPixels = 0;
+        for (size_t i = 0; i < expected.Pixels.size(); i++)
+        {
+            if (converted.Pixels[i] != expected.Pixels[i])
+            {
+                wrongPixels++;
+            }
+        }
+
+        VERIFY_ARE_EQUAL(size_t{0}, wrongPixels);
+    }
+} // namespace
+
+void CursorConversionTests::XorBorderMatchesReference()
+{
+    // Widths on either side of each step of the border size (1 up to 48, 2 up to 96, 3 up to 144), odd and even
+    const uint32_t widths[] = {1, 2, 3, 7, 31, 32, 33, 47, 48, 49, 63, 64, 65, 95, 96, 97, 130, 144, 145};
+
+    std::mt19937 random(1);
+    for (uint32_t width : widths)
+    {
+        for (uint32_t height : {1u, 5u, 33u})
+        {
+            VerifyXorBorder(MixedCursor(width, height, random));
+        }
+
+        // A lone pixel of each kind in every corner and the middle of each edge, whose border reaches the edges of the
+        // output and, for wider cursors, crosses words of the mask
+        const uint32_t height = 17;
+        const std::pair<uint32_t, uint32_t> positions[] = {
+            {0, 0}, {width - 1, 0}, {0, height - 1}, {width - 1, height - 1}, {width / 2, 0}, {width / 2, height - 1}, {0, height / 2}, {width - 1, height / 2}};
+        for (const auto& [x, y] : positions)
+        {
+            for (uint32_t pixel : {MakePixel(0xFF, White), MakePixel(0x80, 0x0000FF), MakePixel(0, Black), MakePixel(0, 0x00FF00)})
+            {
+                CursorPixels cursor(width, height);
+                cursor.At(x, y) = pixel;
+                VerifyXorBorder(cursor);
+            }
+        }
+
+        // Nothing but transparent pixels, and nothing transparent at all
+        VerifyXorBorder(CursorPixels(width, 9));
+        VerifyXorBorder(CursorPixels(width, 9, MakePixel(0xFF, White)));
+    }
+}
+
+void CursorConversionTests::MaskToStraightMatchesReference()
+{
+    std::mt19937 random(2);
+    for (uint32_t width = 1; width <= 19; width++)
+    {
+        CursorPixels cursor(width, 7);
+        for (uint32_t y = 0; y < cursor.Height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                // Only some alpha values matter, as any alpha at all makes the pixel transparent
+                const uint8_t alphas[] = {0, 0, 1, 0x80, 0xFF};
+                cursor.At(x, y) = MakePixel(alphas[random() % 5], random() & White);
+            }
+        }
+
+        // The conversion as it was first written
+        CursorPixels expected = cursor;
+        for (uint32_t y = 0; y < expected.Height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint32_t& pixel = expected.At(x, y);
+                pixel = Alpha(pixel) != 0 ? MakePixel(0, 0) : MakePixel(0xFF, Color(pixel));
+            }
+        }
+
+        ConvertMaskToStraight(cursor.Data(), cursor.Pitch(), cursor.Width, cursor.Height);
+        VERIFY_IS_TRUE(cursor.Pixels == expected.Pixels);
+    }
+}
+
+void CursorConversionTests::MonochromeMatchesReference()
+{
+    std::mt19937 random(3);
+    for (uint32_t width : {1u, 2u, 7u, 8u, 9u, 15u, 16u, 17u, 31u, 33u, 63u})
+    {
+        const uint32_t height = 6;
+
+        // A byte more than the row needs, as the planes of a shape can be padded, with every bit set at random including
+        // the ones past the end of the row
+        const size_t planePitch = (width + 7) / 8 + 1;
+        std::vector<uint8_t> andPlane(planePitch * height);
+        std::vector<uint8_t> xorPlane(planePitch * height);
+        for (size_t i = 0; i < andPlane.size(); i++)
+        {
+            andPlane[i] = static_cast<uint8_t>(random());
+            xorPlane[i] = static_cast<uint8_t>(random());
+        }
+
+        // The conversion as it was first written, one bit at a time
+        CursorPixels expected(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint8_t bit = static_cast<uint8_t>(0x80 >> (x % 8));
+                const bool andValue = andPlane[y * planePitch + x / 8] & bit;
+                const bool xorValue = xorPlane[y * planePitch + x / 8] & bit;
+                expected.At(x, y) = MakePixel(andValue ? 0xFF : 0, xorValue ? White : Black);
+            }
+        }
+
+        CursorPixels converted(width, height, 0x12345678);
+        ExpandMonochrome(andPlane.data(), xorPlane.data(), planePitch, width, height, converted.Data(), converted.Pitch());
+        VERIFY_IS_TRUE(converted.Pixels == expected.Pixels);
+    }
+}
+
+void CursorConversionTests::ContainsXorFindsSinglePixel()
+{
+    // Pixels that come close to XOR without being it: white without alpha, nearly white with alpha, and transparent
+    const uint32_t nearlyXor[] = {MakePixel(0, White), MakePixel(0xFF, 0xFFFFFE), MakePixel(0xFF, 0x7FFFFF), MakePixel(0x80, Black), MakePixel(0, Black)};
+
+    // Widths that are and aren't whole SIMD vectors, so the pixel is found both in the vectors and in the last pixels of
+    // a row
+    for (uint32_t width = 1; width <= 13; width++)
+    {
+        const uint32_t height = 3;
+        CursorPixels cursor(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                cursor.At(x, y) = nearlyXor[(x + y * width) % std::size(nearlyXor)];
+            }
+        }
+
+        // The padding after each row is XOR, it must not be looked at
+        for (uint32_t y = 0; y < height; y++)
+        {
+            cursor.At(width, y) = MakePixel(0xFF, White);
+        }
+
+        VERIFY_IS_FALSE(ContainsXorPixel(cursor.Data(), cursor.Pitch(), width, height));
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                for (uint8_t alpha : {uint8_t{1}, uint8_t{0xFF}})
+                {
+                    CursorPixels single = cursor;
+                    single.At(x, y) = MakePixel(alpha, White);
+                    VERIFY_IS_TRUE(ContainsXorPixel(single.Data(), single.Pitch(), width, height));
+                }
+            }
+        }
+    }
+}
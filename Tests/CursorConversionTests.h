@@ -0,0 +1,29 @@
+#pragma once
+
+/// <summary>
+/// Validates the pixel conversions of cursor shapes against the per-pixel implementations they replaced. These only use
+/// the CPU, so they can be run in prediction-only mode without a capture board attached.
+/// </summary>
+class CursorConversionTests
+{
+    BEGIN_TEST_CLASS(CursorConversionTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(XorBorderMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates the white border drawn in place of XOR pixels against a per-pixel reference, for odd widths and widths on either side of each border size, with pixels on the first and last rows and columns, in rows with padding.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(MaskToStraightMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates converting masked color to straight alpha against a per-pixel reference, for widths that do and don't fill whole SIMD vectors, and that the row padding is left alone.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(MonochromeMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates expanding the AND and XOR planes of monochrome cursors against a per-pixel reference, for widths that aren't a multiple of 8 and planes with padding bits and bytes after each row.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(ContainsXorFindsSinglePixel)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a cursor with no XOR pixels, only pixels that are nearly XOR, has none found, and that the same cursor with a single XOR pixel at any position has it found.")
+    END_TEST_METHOD()
+};
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "FrameComparisonTests.h"
+
+#include "FrameComparison.h"
+
+using namespace winrt::MicrosoftDisplayCaptureTools::Libraries;
+
+namespace
+{
+    // Large enough to be split into many blocks
+    constexpr size_t PixelCount = 1 << 20;
+
+    std::vector<uint64_t> GrayFrame(size_t pixelCount = PixelCount)
+    {
+        return std::vector<uint64_t>(pixelCount, HalfFloat::PackRgba(0.5f, 0.5f, 0.5f, 1.0f));
+    }
+
+    // Makes every step-th pixel of [first, first + count) very wrong
+    void AddErrors(std::vector<uint64_t>& frame, size_t first, size_t count, size_t step = 1)
+    {
+        for (size_t pixel = first; pixel < first + count; pixel += step)
+        {
+            frame[pixel] = HalfFloat::PackRgba(7.0f, 7.0f, 7.0f, 1.0f);
+        }
+    }
+
+    FrameComparison::ComparisonReport Compare(
+        const std::vector<uint64_t>& expected, const std::vector<uint64_t>& captured, bool exact, ThreadPool& pool)
+    {
+        FrameComparison::ComparisonOptions options;
+        options.PsnrLimit = 70.0;
+        options.Exact = exact;
+        return FrameComparison::CompareFrames(std::span<const uint64_t>(expected), std::span<const uint64_t>(captured), options, pool);
+    }
+} // namespace
+
+void FrameComparisonTests::IdenticalFramesPass()
+{
+    const auto frame = GrayFrame();
+    const auto report = Compare(frame, frame, false, ThreadPool::Default());
+
+    VERIFY_IS_TRUE(report.Passed);
+    VERIFY_IS_TRUE(report.Complete);
+    VERIFY_ARE_EQUAL(report.PixelsCompared, PixelCount);
+    VERIFY_ARE_EQUAL(report.PixelsOverTolerance, uint64_t(0));
+}
+
+void FrameComparisonTests::EmptyFramesPass()
+{
+    const std::vector<uint64_t> frame;
+    const auto report = Compare(frame, frame, false, ThreadPool::Default());
+
+    VERIFY_IS_TRUE(report.Passed);
+    VERIFY_IS_TRUE(report.Complete);
+    VERIFY_ARE_EQUAL(report.PixelsCompared, size_t(0));
+    VERIFY_IS_TRUE(std::isinf(report.Psnr) && report.Psnr > 0);
+    for (double mse : report.ChannelMse)
+    {
+        VERIFY_ARE_EQUAL(mse, 0.0);
+    }
+
+    VERIFY_ARE_EQUAL(FrameComparison::ComputeMse(frame, frame), 0.0);
+    VERIFY_IS_TRUE(std::isinf(FrameComparison::ComputePsnr(frame, frame)));
+}
+
+void FrameComparisonTests::EarlyExitReportsBound()
+{
+    // Every block of the frame is enough to fail it, so whichever block is compared first stops the comparison
+    const auto expected = GrayFrame();
+    auto captured = expected;
+    AddErrors(captured, 0, PixelCount, 16);
+
+    ThreadPool pool(2);
+    const auto report = Compare(expected, captured, false, pool);
+    const auto exactReport = Compare(expected, captured, true, pool);
+
+    VERIFY_IS_FALSE(report.Passed);
+    VERIFY_IS_TRUE(report.PsnrFailed);
+    VERIFY_IS_FALSE(report.Complete);
+    VERIFY_IS_LESS_THAN(report.PixelsCompared, PixelCount);
+
+    VERIFY_IS_TRUE(exactReport.Complete);
+    VERIFY_IS_TRUE(exactReport.PsnrFailed);
+    VERIFY_IS_TRUE(report.Psnr >= exactReport.Psnr);
+}
+
+void FrameComparisonTests::FailureInLastBlockIsComplete()
+{
+    // A frame of a single block crosses the limit in the only block there is, so nothing is skipped
+    constexpr size_t pixelCount = 10000;
+    const auto expected = GrayFrame(pixelCount);
+    auto captured = expected;
+    AddErrors(captured, 0, 1000);
+
+    const auto report = Compare(expected, captured, false, ThreadPool::Default());
+    const auto exactReport = Compare(expected, captured, true, ThreadPool::Default());
+
+    VERIFY_IS_FALSE(report.Passed);
+    VERIFY_IS_TRUE(report.PsnrFailed);
+    VERIFY_IS_TRUE(report.Complete);
+    VERIFY_ARE_EQUAL(report.PixelsCompared, pixelCount);
+    VERIFY_ARE_EQUAL(report.Psnr, exactReport.Psnr);
+}
+
+void FrameComparisonTests::ExactComparisonIsDeterministic()
+{
+    const auto expected = GrayFrame();
+    auto captured = expected;
+    AddErrors(captured, 0, PixelCount, 1000);
+
+    ThreadPool singleThread(1);
+    ThreadPool manyThreads(8);
+    const auto reference = Compare(expected, captured, true, singleThread);
+
+    for (int run = 0; run < 4; run++)
+    {
+        const auto report = Compare(expected, captured, true, manyThreads);
+        VERIFY_IS_TRUE(report.Complete);
+        VERIFY_ARE_EQUAL(report.Psnr, reference.Psnr);
+        VERIFY_IS_TRUE(report.ChannelMse == reference.ChannelMse);
+    }
+}
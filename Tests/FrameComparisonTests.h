@@ -0,0 +1,33 @@
+#pragma once
+
+/// <summary>
+/// Validates how frame comparisons report frames that stop early. These only use the CPU, so they can be run in
+/// prediction-only mode without a capture board attached.
+/// </summary>
+class FrameComparisonTests
+{
+    BEGIN_TEST_CLASS(FrameComparisonTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(IdenticalFramesPass)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that identical frames pass with every pixel compared.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(EmptyFramesPass)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that frames with no pixels pass with an infinite PSNR and no error, rather than NaN.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(EarlyExitReportsBound)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a comparison that stops early fails, is reported as incomplete and gives a PSNR no lower than the exact one.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(FailureInLastBlockIsComplete)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a frame which only crosses the limit once no blocks are left is reported as complete.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(ExactComparisonIsDeterministic)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that exact comparisons give the same PSNR whatever the number of threads.")
+    END_TEST_METHOD()
+};
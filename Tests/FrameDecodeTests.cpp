@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "FrameDecodeTests.h"
+
+#include <random>
+
+#include "..\CapturePlugins\TanagerPlugin\StreamingFrameDecoder.h"
+
+using namespace WEX::Logging;
+using namespace winrt::MicrosoftDisplayCaptureTools::TanagerPlugin::DataProcessing;
+
+namespace
+{
+    constexpr uint32_t FrameWidth = 64;
+    constexpr uint32_t FrameHeight = 36;
+
+    // The raw data of a frame is 64-bit words, each holding two pixels, or four for 4:2:0
+    size_t RawFrameSize(const CpuDecodeDescriptor& descriptor)
+    {
+        const size_t pixelsPerWord = descriptor.Layout == RawPixelLayout::Ycbcr420 ? 4 : 2;
+        return static_cast<size_t>(descriptor.Width) * descriptor.Height / pixelsPerWord * sizeof(uint64_t);
+    }
+
+    std::vector<uint8_t> RandomFrameData(size_t size, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> data(size);
+        for (auto& byte : data)
+        {
+            byte = static_cast<uint8_t>(random());
+        }
+
+        return data;
+    }
+} // namespace
+
+void FrameDecodeTests::StreamingDecodeMatchesWholeFrameDecode()
+{
+    winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool pool(4);
+    const size_t pixelCount = static_cast<size_t>(FrameWidth) * FrameHeight;
+
+    uint32_t seed = 0;
+    for (const auto& entry : DecodeKernels::DispatchTable)
+    {
+        const CpuDecodeDescriptor descriptor{
+            FrameWidth, FrameHeight, entry.Key.BitDepth, entry.Key.LimitedRange, entry.Key.Layout, entry.Key.Matrix, entry.Key.Transfer, entry.Key.Primaries};
+        const CpuFrameDecoder decoder(descriptor);
+        VERIFY_IS_TRUE(decoder.IsSupported());
+
+        const auto recording = RandomFrameData(RawFrameSize(descriptor), seed++);
+
+        std::vector<uint64_t> expectedScRgb(pixelCount);
+        std::vector<uint32_t> expectedRgba8(pixelCount);
+        decoder.DecodeRows(recording, 0, FrameHeight, expectedScRgb.data(), expectedRgba8.data());
+
+        // Chunks that don't line up with rows or words, so bands are queued part way through a row
+        RecordedFrameDataSource source(recording, 1000);
+        std::vector<uint8_t> raw(recording.size());
+        std::vector<uint64_t> scRgb(pixelCount);
+        std::vector<uint32_t> rgba8(pixelCount);
+
+        StreamingFrameDecoder streamingDecoder(decoder, raw, scRgb.data(), rgba8.data(), pool, 5);
+        VERIFY_ARE_EQUAL(streamingDecoder.Receive(source), recording.size());
+        streamingDecoder.Finish();
+
+        VERIFY_IS_TRUE(scRgb == expectedScRgb);
+        VERIFY_IS_TRUE(rgba8 == expectedRgba8);
+    }
+}
+
+void FrameDecodeTests::TruncatedSourceIsDiscarded()
+{
+    winrt::MicrosoftDisplayCaptureTools::Libraries::ThreadPool pool(4);
+    const size_t pixelCount = static_cast<size_t>(FrameWidth) * FrameHeight;
+
+    const CpuDecodeDescriptor descriptor{
+        FrameWidth, FrameHeight, 8, false, RawPixelLayout::Rgb444, YcbcrMatrix::None, TransferFunction::Bt709, ColorPrimaries::Bt709};
+    const CpuFrameDecoder decoder(descriptor);
+    VERIFY_IS_TRUE(decoder.IsSupported());
+
+    // Only the first half of the frame was recorded, the decoder gets whatever the raw buffer held for the rest
+    const size_t frameSize = RawFrameSize(descriptor);
+    const auto recording = RandomFrameData(frameSize / 2, 1);
+
+    RecordedFrameDataSource truncatedSource(recording, 256);
+    std::vector<uint8_t> raw(frameSize);
+    std::vector<uint64_t> scRgb(pixelCount);
+    std::vector<uint32_t> rgba8(pixelCount);
+
+    StreamingFrameDecoder streamingDecoder(decoder, raw, scRgb.data(), rgba8.data(), pool, 5);
+    VERIFY_ARE_EQUAL(streamingDecoder.Receive(truncatedSource), recording.size());
+    streamingDecoder.Finish();
+
+    std::vector<uint64_t> expectedScRgb(pixelCount);
+    std::vector<uint32_t> expectedRgba8(pixelCount);
+    decoder.DecodeRows(raw, 0, FrameHeight, expectedScRgb.data(), expectedRgba8.data());
+    VERIFY_IS_TRUE(scRgb == expectedScRgb);
+    VERIFY_IS_TRUE(rgba8 == expectedRgba8);
+
+    // A read that stops early drops the rest of the frame
+    RecordedFrameDataSource source(RandomFrameData(frameSize, 2), 256);
+    std::vector<uint8_t> chunk(100);
+    VERIFY_ARE_EQUAL(source.Read(chunk), chunk.size());
+    source.Discard();
+    VERIFY_ARE_EQUAL(source.Read(chunk), size_t(0));
+}
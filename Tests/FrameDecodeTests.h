@@ -0,0 +1,21 @@
+#pragma once
+
+/// <summary>
+/// Validates the Tanager CPU decode against recorded frame data. These only use the CPU, so they can be run in
+/// prediction-only mode without a capture board attached.
+/// </summary>
+class FrameDecodeTests
+{
+    BEGIN_TEST_CLASS(FrameDecodeTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(StreamingDecodeMatchesWholeFrameDecode)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that decoding a frame while it streams in from a recorded source gives the same pixels as decoding it in one go, for every decode kernel.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(TruncatedSourceIsDiscarded)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that a frame cut short still finishes decoding, and that discarding a source leaves nothing of the frame to be read.")
+    END_TEST_METHOD()
+};
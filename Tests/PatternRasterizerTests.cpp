@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "PatternRasterizerTests.h"
+
+#include "..\BasicDisplayConfiguration\PatternRasterizer.h"
+
+using namespace winrt::BasicDisplayConfiguration::Rendering;
+
+namespace
+{
+    constexpr uint32_t SquareSize = 50;
+    constexpr uint8_t PaddingByte = 0xCD;
+
+    // The pixel the checkerboard should have at (x, y), worked out from the square the pixel is in
+    template <typename Pixel>
+    Pixel ReferencePixel(uint32_t x, uint32_t y, Pixel checker, Pixel background)
+    {
+        return (x / SquareSize + y / SquareSize) % 2 == 0 ? checker : background;
+    }
+
+    template <typename Pixel>
+    Pixel PixelAt(const std::vector<uint8_t>& data, size_t rowPitch, uint32_t x, uint32_t y)
+    {
+        Pixel pixel;
+        std::memcpy(&pixel, data.data() + y * rowPitch + x * sizeof(Pixel), sizeof(Pixel));
+        return pixel;
+    }
+
+    template <typename Pixel>
+    void VerifyCheckerboard(uint32_t width, uint32_t height, Pixel checker, Pixel background)
+    {
+        // Rows are padded the way a mapped texture's are, the padding must not be written
+        const size_t rowPitch = (static_cast<size_t>(width) + 3) * sizeof(Pixel);
+        std::vector<uint8_t> data(rowPitch * height, PaddingByte);
+
+        RasterizeCheckerboard<Pixel>(data.data(), rowPitch, width, height, SquareSize, checker, background);
+
+        size_t wrongPixels = 0;
+        size_t paddingWritten = 0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                wrongPixels += PixelAt<Pixel>(data, rowPitch, x, y) != ReferencePixel(x, y, checker, background);
+            }
+
+            for (size_t offset = width * sizeof(Pixel); offset < rowPitch; offset++)
+            {
+                paddingWritten += data[y * rowPitch + offset] != PaddingByte;
+            }
+        }
+
+        VERIFY_ARE_EQUAL(wrongPixels, size_t(0));
+        VERIFY_ARE_EQUAL(paddingWritten, size_t(0));
+    }
+} // namespace
+
+void PatternRasterizerTests::CheckerboardMatchesReference()
+{
+    for (uint32_t width : {1u, 49u, 50u, 51u, 130u})
+    {
+        for (uint32_t height : {1u, 50u, 101u})
+        {
+            VerifyCheckerboard<uint32_t>(width, height, 0xFF00FF00u, 0xFF000000u);
+            VerifyCheckerboard<uint64_t>(width, height, 0x3C003C003C003C00ull, 0x3C00000000000000ull);
+        }
+    }
+}
+
+void PatternRasterizerTests::PlaneOutsidePatternIsCleared()
+{
+    constexpr uint32_t planeWidth = 160, planeHeight = 120;
+    constexpr uint32_t width = 130, height = 101;
+    constexpr uint32_t checker = 0xFF0000FFu, background = 0xFF000000u;
+
+    const size_t rowPitch = planeWidth * sizeof(uint32_t);
+    std::vector<uint8_t> data(rowPitch * planeHeight, PaddingByte);
+
+    RasterizeCheckerboard<uint32_t>(data.data(), rowPitch, width, height, SquareSize, checker, background);
+    FillPixels<uint32_t>(data.data(), rowPitch, width, 0, planeWidth, height, background);
+    FillPixels<uint32_t>(data.data(), rowPitch, 0, height, planeWidth, planeHeight, background);
+
+    size_t wrongPixels = 0;
+    for (uint32_t y = 0; y < planeHeight; y++)
+    {
+        for (uint32_t x = 0; x < planeWidth; x++)
+        {
+            const uint32_t expected = x < width && y < height ? ReferencePixel(x, y, checker, background) : background;
+            wrongPixels += PixelAt<uint32_t>(data, rowPitch, x, y) != expected;
+        }
+    }
+
+    VERIFY_ARE_EQUAL(wrongPixels, size_t(0));
+}
+
+void PatternRasterizerTests::BandStartsMatchPattern()
+{
+    for (uint32_t height : {0u, 1u, 50u, 101u})
+    {
+        const auto bandStarts = CheckerboardBandStarts(height, SquareSize);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            if (y == 0 || ReferencePixel(0u, y, 1u, 0u) != ReferencePixel(0u, y - 1, 1u, 0u))
+            {
+                expected.push_back(y);
+            }
+        }
+
+        VERIFY_IS_TRUE(bandStarts == expected);
+    }
+}
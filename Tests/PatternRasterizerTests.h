@@ -0,0 +1,25 @@
+#pragma once
+
+/// <summary>
+/// Validates the base plane checkerboard rasterizer against a per-pixel reference. These only use the CPU, so they can
+/// be run in prediction-only mode without a capture board attached.
+/// </summary>
+class PatternRasterizerTests
+{
+    BEGIN_TEST_CLASS(PatternRasterizerTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(CheckerboardMatchesReference)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates every pixel of 8 bit and fp16 checkerboards of sizes that do and don't fit whole squares, in rows with padding, and that the padding is left alone.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(PlaneOutsidePatternIsCleared)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that the part of a plane outside of the pattern is filled with the background, as the output path does for planes larger than the source mode.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(BandStartsMatchPattern)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that the band starts reported for a plane are the rows where the pattern changes.")
+    END_TEST_METHOD()
+};
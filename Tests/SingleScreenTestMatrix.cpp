@@ -3,6 +3,7 @@
 
 // Shared Utilities
 #include "BinaryLoader.h"
+#include "CaptureComparison.h"
 
 #include <winrt/Windows.Storage.Streams.h>
 #include <winrt/Windows.Graphics.Imaging.h>
@@ -35,7 +36,29 @@ namespace MicrosoftDisplayCaptureTools::Tests
             auto filePathRaw = fileNamePrefix + L"_raw.hwhlk";
             auto file = co_await folder.CreateFileAsync(filePathRaw, winrt::CreationCollisionOption::ReplaceExisting);
 
-            co_await winrt::FileIO::WriteBufferAsync(file, frame.Data());
+            // Frames held as tiles are written a row of tiles at a time, rather than making the whole buffer first
+            const auto tiledFrame = winrt::Libraries::FrameComparison::GetTiledFrame(frame, frame.Resolution());
+            if (tiledFrame)
+            {
+                constexpr uint32_t rowsPerWrite = winrt::Libraries::TiledFrame::TileSize;
+                auto stream = co_await file.OpenAsync(winrt::FileAccessMode::ReadWrite);
+                winrt::Buffer buffer(tiledFrame->Width() * rowsPerWrite * sizeof(uint64_t));
+
+                for (uint32_t y = 0; y < tiledFrame->Height(); y += rowsPerWrite)
+                {
+                    const uint32_t rowCount = (std::min)(rowsPerWrite, tiledFrame->Height() - y);
+                    tiledFrame->CopyRows(y, rowCount, reinterpret_cast<uint64_t*>(buffer.data()));
+                    buffer.Length(tiledFrame->Width() * rowCount * sizeof(uint64_t));
+
+                    co_await stream.WriteAsync(buffer);
+                }
+
+                co_await stream.FlushAsync();
+            }
+            else
+            {
+                co_await winrt::FileIO::WriteBufferAsync(file, frame.Data());
+            }
         }
 
         auto renderableFrame = frame.try_as<winrt::IRawFrameRenderable>();
@@ -59,23 +82,24 @@ namespace MicrosoftDisplayCaptureTools::Tests
         co_return;
     }
 
-    winrt::IAsyncAction SaveFrameSetToDisk(winrt::IRawFrameSet frameset, winrt::hstring resultFolderPath, winrt::hstring testName)
+    winrt::IAsyncOperation<winrt::StorageFolder> GetResultsFolderAsync(winrt::hstring resultFolderPath)
     {
         auto cwd = co_await winrt::StorageFolder::GetFolderFromPathAsync(resultFolderPath);
-        auto resultsFolder = co_await cwd.CreateFolderAsync(L"Results", winrt::CreationCollisionOption::OpenIfExists);
+        co_return co_await cwd.CreateFolderAsync(L"Results", winrt::CreationCollisionOption::OpenIfExists);
+    }
+
+    winrt::IAsyncAction SaveFrameSetToDisk(winrt::IRawFrameSet frameset, winrt::hstring resultFolderPath, winrt::hstring testName)
+    {
+        auto resultsFolder = co_await GetResultsFolderAsync(resultFolderPath);
 
+        // Frames are saved one at a time, so that only one frame's pixels and approximation are held at once. Each is
+        // released as soon as it has been written.
         unsigned long frameCounter = 0;
-        std::vector<winrt::IAsyncAction> frameSaveActions;
         for (auto frame : frameset.Frames())
         {
             auto filePrefix = winrt::hstring(String().Format(L"%s_Frame_%d", testName.c_str(), frameCounter++));
 
-            frameSaveActions.push_back(SaveFrameToDisk(frame, resultsFolder, filePrefix));
-        }
-
-        for (auto& frameSave : frameSaveActions)
-        {
-             co_await frameSave;
+            co_await SaveFrameToDisk(frame, resultsFolder, filePrefix);
         }
 
         co_return;
@@ -237,6 +261,13 @@ void SingleScreenTestMatrix::Test()
         }
     }
 
+    // Without a capture to compare against, each frame is saved as soon as it has been rendered rather than once the
+    // whole prediction is done, so the prediction never holds on to more than the frames still being rendered.
+    if (winrt::RuntimeSettings().GetSettingValueAsBool(RunPredictionOnlyRuntimeParameter))
+    {
+        SaveOutputAsRendered(prediction, testName + L"_Prediction");
+    }
+
     // Start generating the prediction at the same time as we start outputting.
     auto predictionDataAsync = prediction.FinalizePredictionAsync();
     winrt::IRawFrameSet predictionFrameSet = nullptr;
@@ -294,15 +325,9 @@ void SingleScreenTestMatrix::Test()
     }
     else
     {
-        if (!predictionFrameSet)
-        {
-             // We synchronize on the data being generated, so that any errors that happen there will be flagged
-             // synchronously in this test method. However, by default we will save the data asynchronously. This
-             // helps make best use of the testing time with the physical devices.
-             predictionFrameSet = predictionDataAsync.get();
-        }
-
-        SaveOutput(predictionFrameSet, testName + L"_Prediction");
+        // We synchronize on the data being generated, so that any errors that happen there will be flagged
+        // synchronously in this test method. The frames themselves were saved as they were rendered.
+        predictionDataAsync.get();
     }
 }
 
@@ -319,4 +344,27 @@ void SingleScreenTestMatrix::SaveOutput(winrt::IRawFrameSet frames, winrt::hstri
     {
         fileOperationsVector.push_back(savePredictionTask);
     }
+}
+
+void SingleScreenTestMatrix::SaveOutputAsRendered(winrt::IPrediction prediction, winrt::hstring name)
+{
+    auto resultFolderPath = winrt::hstring(std::wstring(std::filesystem::current_path()));
+    auto resultsFolder = GetResultsFolderAsync(resultFolderPath).get();
+    const bool synchronize = winrt::RuntimeSettings().GetSettingValueAsBool(SynchronizeSavingPredictionToDisk);
+
+    // Frames are handed over one at a time and in order, each is released once it has been written. By default the
+    // writes are left to finish in the background, Cleanup waits on them.
+    prediction.FrameRenderedCallback([this, resultsFolder, name, synchronize, frameCounter = 0ul](auto&&, winrt::IRawFrame const& frame) mutable {
+        auto filePrefix = winrt::hstring(String().Format(L"%s_Frame_%d", name.c_str(), frameCounter++));
+        auto saveFrameTask = SaveFrameToDisk(frame, resultsFolder, filePrefix);
+
+        if (synchronize)
+        {
+            saveFrameTask.get();
+        }
+        else
+        {
+            fileOperationsVector.push_back(saveFrameTask);
+        }
+    });
 }
\ No newline at end of file
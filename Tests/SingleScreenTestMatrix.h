@@ -16,5 +16,6 @@ class SingleScreenTestMatrix : public CaptureFrameworkTestBase
 
 private:
     void SaveOutput(winrt::MicrosoftDisplayCaptureTools::Framework::IRawFrameSet data, winrt::hstring name);
+    void SaveOutputAsRendered(winrt::MicrosoftDisplayCaptureTools::ConfigurationTools::IPrediction prediction, winrt::hstring name);
     std::vector<winrt::Windows::Foundation::IAsyncAction> fileOperationsVector;
 };
\ No newline at end of file
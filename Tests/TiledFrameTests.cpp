@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "TiledFrameTests.h"
+
+#include <random>
+
+#include "FrameComparison.h"
+
+using namespace winrt::MicrosoftDisplayCaptureTools::Libraries;
+
+namespace
+{
+    // A frame whose left third is one color, middle third is short runs and right third is noise, so it has tiles of
+    // every kind
+    std::vector<uint64_t> MixedPixels(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        std::mt19937_64 random(seed);
+        std::vector<uint64_t> pixels(static_cast<size_t>(width) * height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint64_t& pixel = pixels[static_cast<size_t>(y) * width + x];
+                if (x < width / 3)
+                {
+                    pixel = HalfFloat::PackRgba(0.5f, 0.25f, 1.0f, 1.0f);
+                }
+                else if (x < width * 2 / 3)
+                {
+                    pixel = HalfFloat::PackRgba(static_cast<float>((x / 7 + y) % 3), 0.0f, 0.0f, 1.0f);
+                }
+                else
+                {
+                    pixel = HalfFloat::PackRgba(
+                        static_cast<float>(random() % 1024) / 1023, static_cast<float>(random() % 1024) / 1023, 0.0f, 1.0f);
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    std::vector<uint64_t> Pixels(const TiledFrame& frame)
+    {
+        std::vector<uint64_t> pixels(static_cast<size_t>(frame.Width()) * frame.Height());
+        frame.CopyRows(0, frame.Height(), pixels.data());
+        return pixels;
+    }
+} // namespace
+
+void TiledFrameTests::SerializedFrameRoundTrips()
+{
+    const std::pair<uint32_t, uint32_t> sizes[] = {{0, 0}, {1, 1}, {63, 65}, {129, 1}, {200, 130}, {640, 64}};
+    uint32_t seed = 0;
+    for (const auto& [width, height] : sizes)
+    {
+        const auto pixels = MixedPixels(width, height, seed++);
+        const auto frame = TiledFrame::FromPixels(pixels, width, height);
+
+        const auto deserialized = TiledFrame::Deserialize(frame.Serialize());
+        VERIFY_IS_TRUE(deserialized.has_value());
+        VERIFY_ARE_EQUAL(deserialized->Width(), width);
+        VERIFY_ARE_EQUAL(deserialized->Height(), height);
+
+        for (uint32_t tileY = 0; tileY < frame.TilesDown(); tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < frame.TilesAcross(); tileX++)
+            {
+                VERIFY_IS_TRUE(deserialized->Kind(tileX, tileY) == frame.Kind(tileX, tileY));
+            }
+        }
+
+        VERIFY_IS_TRUE(Pixels(*deserialized) == pixels);
+    }
+}
+
+void TiledFrameTests::MalformedDataIsRejected()
+{
+    const auto pixels = MixedPixels(200, 130, 1);
+    const auto data = TiledFrame::FromPixels(pixels, 200, 130).Serialize();
+    VERIFY_IS_TRUE(TiledFrame::Deserialize(data).has_value());
+
+    VERIFY_IS_FALSE(TiledFrame::Deserialize({}).has_value());
+
+    auto wrongVersion = data;
+    wrongVersion[0]++;
+    VERIFY_IS_FALSE(TiledFrame::Deserialize(wrongVersion).has_value());
+
+    auto truncated = data;
+    truncated.pop_back();
+    VERIFY_IS_FALSE(TiledFrame::Deserialize(truncated).has_value());
+
+    auto trailing = data;
+    trailing.push_back(0);
+    VERIFY_IS_FALSE(TiledFrame::Deserialize(trailing).has_value());
+
+    // A frame larger than the data could possibly describe
+    auto oversized = data;
+    oversized[1] = (static_cast<uint64_t>(1) << 32 | 1) * 0x10000;
+    VERIFY_IS_FALSE(TiledFrame::Deserialize(oversized).has_value());
+
+    // The first tile with an unknown kind
+    auto unknownKind = data;
+    unknownKind[2] = 3;
+    VERIFY_IS_FALSE(TiledFrame::Deserialize(unknownKind).has_value());
+
+    // Corrupting any single value must never give a frame that reads outside of its data
+    std::mt19937_64 random(2);
+    for (int attempt = 0; attempt < 1000; attempt++)
+    {
+        auto corrupted = data;
+        corrupted[random() % corrupted.size()] ^= static_cast<uint64_t>(1) << (random() % 64);
+        if (const auto frame = TiledFrame::Deserialize(corrupted); frame && frame->Width() == 200 && frame->Height() == 130)
+        {
+            Pixels(*frame);
+        }
+    }
+}
+
+void TiledFrameTests::ComparisonMatchesPixels()
+{
+    const auto pixels = MixedPixels(200, 130, 3);
+    const auto frame = TiledFrame::Deserialize(TiledFrame::FromPixels(pixels, 200, 130).Serialize());
+    VERIFY_IS_TRUE(frame.has_value());
+
+    auto captured = pixels;
+    std::mt19937_64 random(4);
+    for (auto& pixel : captured)
+    {
+        pixel ^= random() % 4;
+    }
+
+    FrameComparison::ComparisonOptions options;
+    options.PsnrLimit = 40.0;
+    options.Exact = true;
+
+    const auto expected = FrameComparison::CompareFrames(std::span<const uint64_t>(pixels), std::span<const uint64_t>(captured), options);
+    const auto report = FrameComparison::CompareFrames(*frame, captured, options);
+
+    VERIFY_IS_TRUE(report.Complete);
+    VERIFY_ARE_EQUAL(report.Passed, expected.Passed);
+    VERIFY_ARE_EQUAL(report.Psnr, expected.Psnr);
+    VERIFY_IS_TRUE(report.ChannelMse == expected.ChannelMse);
+    VERIFY_ARE_EQUAL(report.MaxAbsoluteError, expected.MaxAbsoluteError);
+    VERIFY_ARE_EQUAL(report.PixelsOverTolerance, expected.PixelsOverTolerance);
+}
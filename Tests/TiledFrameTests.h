@@ -0,0 +1,25 @@
+#pragma once
+
+/// <summary>
+/// Validates that tiled predictions survive being passed between modules as a frame property, and compare the same as
+/// the pixels they hold. These only use the CPU, so they can be run in prediction-only mode without a capture board.
+/// </summary>
+class TiledFrameTests
+{
+    BEGIN_TEST_CLASS(TiledFrameTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(SerializedFrameRoundTrips)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that serializing and deserializing frames with solid, run length and raw tiles gives back every pixel, for sizes that do and don't fit whole tiles.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(MalformedDataIsRejected)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that data that isn't a serialized frame is rejected rather than read.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(ComparisonMatchesPixels)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that comparing against a deserialized tiled frame gives the same report as comparing against its pixels.")
+    END_TEST_METHOD()
+};
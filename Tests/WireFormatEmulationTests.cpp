@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "WireFormatEmulationTests.h"
+
+#include "..\BasicDisplayConfiguration\WireFormatEmulation.h"
+
+using namespace winrt::BasicDisplayConfiguration::Rendering;
+namespace WireFormat = winrt::MicrosoftDisplayCaptureTools::Libraries::WireFormat;
+
+namespace
+{
+    // 10 bit PQ with BT.2020 primaries, the HDR10 wire formats. Both are full range, so that only the transfer function
+    // and quantization stand between the source and the sink.
+    WireFormatEmulation Hdr10Rgb()
+    {
+        WireFormatEmulation format;
+        format.BitDepth = 10;
+        format.Transfer = WireFormat::TransferFunction::Smpte2084;
+        format.Primaries = WireFormat::ColorPrimaries::Bt2020;
+        return format;
+    }
+
+    WireFormatEmulation Hdr10Ycbcr()
+    {
+        WireFormatEmulation format = Hdr10Rgb();
+        format.Matrix = WireFormat::YcbcrMatrix::Bt2020;
+        return format;
+    }
+
+    // Sends gray pixels of each value (in scRGB, 1.0 is 80 nits) over the wire and back, and returns the largest
+    // relative error of any channel the sink sees against the expected values
+    float LargestRelativeError(const WireFormatEmulation& format, const std::vector<float>& values, const std::vector<float>& expected)
+    {
+        ColorBlock block{};
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            block.R[i] = block.G[i] = block.B[i] = values[i];
+            block.A[i] = 1.0f;
+        }
+
+        CompiledWireFormatEmulation(format).Apply(block, nullptr, values.size());
+
+        float largestError = 0.0f;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            for (float channel : {block.R[i], block.G[i], block.B[i]})
+            {
+                largestError = (std::max)(largestError, std::abs(channel - expected[i]) / expected[i]);
+            }
+        }
+
+        return largestError;
+    }
+} // namespace
+
+void WireFormatEmulationTests::PqRoundTripsAboveSdrWhite()
+{
+    // 40 to 4000 nits, over this range a 10 bit PQ code is a step of well under 2%
+    const std::vector<float> values = {0.5f, 1.0f, 5.0f, 12.5f, 50.0f};
+
+    for (const auto& format : {Hdr10Rgb(), Hdr10Ycbcr()})
+    {
+        VERIFY_IS_LESS_THAN(LargestRelativeError(format, values, values), 0.02f);
+    }
+}
+
+void WireFormatEmulationTests::WireClampsAtItsPeak()
+{
+    // 16000 nits is past what PQ can carry
+    for (const auto& format : {Hdr10Rgb(), Hdr10Ycbcr()})
+    {
+        VERIFY_IS_LESS_THAN(LargestRelativeError(format, {200.0f}, {WireFormat::GetLinearScale(format.Transfer)}), 0.02f);
+    }
+
+    const WireFormatEmulation sdr;
+    VERIFY_IS_LESS_THAN(LargestRelativeError(sdr, {5.0f}, {1.0f}), 0.01f);
+}
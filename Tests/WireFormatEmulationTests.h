@@ -0,0 +1,21 @@
+#pragma once
+
+/// <summary>
+/// Validates the emulation of the display wire that CPU predictions go through. These only use the CPU, so they can be
+/// run in prediction-only mode without a capture board attached.
+/// </summary>
+class WireFormatEmulationTests
+{
+    BEGIN_TEST_CLASS(WireFormatEmulationTests)
+        TEST_CLASS_PROPERTY(L"", L"")
+    END_TEST_CLASS()
+
+public:
+    BEGIN_TEST_METHOD(PqRoundTripsAboveSdrWhite)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that values up to thousands of nits come back from RGB and YCbCr PQ wires to within the 10 bit quantization.")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(WireClampsAtItsPeak)
+        TEST_METHOD_PROPERTY(L"Description", L"Validates that PQ wires clamp at 10000 nits and SDR wires at reference white.")
+    END_TEST_METHOD()
+};